@@ -0,0 +1,368 @@
+// Headless benchmarks for the rendering, tick generation, hit-testing and CSV paths.
+//
+// Runs on the offscreen platform unless QT_QPA_PLATFORM is set, so it needs neither a display nor
+// a GPU. Each benchmark repeats its operation until --min-time has passed and reports the min,
+// median and mean duration of one iteration. The results are written as a single JSON document
+// to stdout or --output, progress goes to stderr. Run with --help for all options.
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <cstdio>
+#include "qcustomplot.h"
+#include "csvreader.h"
+#include "csvwriter.h"
+
+namespace {
+
+struct Options
+{
+    qint64 maxPoints = 10000000;
+    qint64 maxUnsampledPoints = 1000000;
+    double minTime = 0.2;
+    int maxIterations = 1000;
+    QString filter;
+};
+
+class Benchmark
+{
+public:
+    explicit Benchmark(const Options &options) : options(options) {}
+
+    bool isSelected(const QString &name) const
+    {
+        return options.filter.isEmpty() || name.contains(options.filter, Qt::CaseInsensitive);
+    }
+
+    // Whether any of the given benchmark names is selected, used to skip the setup of a group.
+    bool isAnySelected(const QStringList &names) const
+    {
+        for(const QString &name : names){
+            if(isSelected(name)){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Runs function after one warm-up call until the minimum time has passed, and records the
+    // timing together with the parameters and the extra values returned by report (if any).
+    void run(const QString &name, const QJsonObject &parameters, const std::function<void()> &function,
+             const std::function<QJsonObject()> &report = nullptr)
+    {
+        if(!isSelected(name)){
+            return;
+        }
+        fprintf(stderr, "%s %s\n", qPrintable(name), QJsonDocument(parameters).toJson(QJsonDocument::Compact).constData());
+
+        function();
+        QVector<qint64> durations;
+        QElapsedTimer total;
+        total.start();
+        while(durations.size() < options.maxIterations && (durations.isEmpty() || total.nsecsElapsed() < options.minTime*1e9)){
+            QElapsedTimer timer;
+            timer.start();
+            function();
+            durations.append(timer.nsecsElapsed());
+        }
+        std::sort(durations.begin(), durations.end());
+        double sum = 0;
+        for(qint64 duration : durations){
+            sum += duration;
+        }
+
+        QJsonObject result;
+        result["benchmark"] = name;
+        result["parameters"] = parameters;
+        result["iterations"] = durations.size();
+        result["minMs"] = durations.first()*1e-6;
+        result["medianMs"] = durations.at(durations.size()/2)*1e-6;
+        result["meanMs"] = sum/durations.size()*1e-6;
+        if(report){
+            const QJsonObject extra = report();
+            for(auto it = extra.constBegin(); it != extra.constEnd(); ++it){
+                result[it.key()] = it.value();
+            }
+        }
+        results.append(result);
+    }
+
+    QJsonArray results;
+
+private:
+    Options options;
+};
+
+QVector<qint64> pointCounts(qint64 maxPoints)
+{
+    QVector<qint64> counts;
+    for(qint64 count = 1000; count <= maxPoints && count <= 100000000; count *= 10){
+        counts.append(count);
+    }
+    return counts;
+}
+
+// A random walk with evenly spaced keys, which is the typical shape of measured signals.
+QSharedPointer<QCPGraphDataContainer> randomWalk(qint64 count)
+{
+    QRandomGenerator random(42);
+    QVector<QCPGraphData> data(int(count));
+    double value = 0;
+    for(int i = 0; i < data.size(); ++i){
+        value += random.generateDouble() - 0.5;
+        data[i] = QCPGraphData(i, value);
+    }
+    QSharedPointer<QCPGraphDataContainer> container(new QCPGraphDataContainer);
+    container->set(data, true);
+    return container;
+}
+
+std::unique_ptr<QCustomPlot> createPlot()
+{
+    std::unique_ptr<QCustomPlot> plot(new QCustomPlot);
+    plot->resize(1280, 720);
+    plot->setViewport(plot->rect());
+    return plot;
+}
+
+// Replots once with profiling enabled and returns the number of points left after adaptive
+// sampling, as recorded by the data preparation steps of the plottables.
+QJsonObject sampledPoints(QCustomPlot *plot)
+{
+    plot->setProfiling(true);
+    plot->replot(QCustomPlot::rpQueuedRefresh);
+    plot->setProfiling(false);
+    qint64 sampled = 0;
+    for(const QCPReplotProfile::Event &event : plot->replotProfile().events("data")){
+        sampled += event.sampledCount;
+    }
+    return QJsonObject{{"sampledPoints", sampled}};
+}
+
+void benchmarkGraphs(Benchmark &benchmark, const Options &options)
+{
+    if(!benchmark.isAnySelected({"graph-line", "graph-scatter", "hit-test-point", "hit-test-rect", "hit-test-nearest"})){
+        return;
+    }
+    for(qint64 count : pointCounts(options.maxPoints)){
+        QSharedPointer<QCPGraphDataContainer> data = randomWalk(count);
+        std::unique_ptr<QCustomPlot> plot = createPlot();
+        QCPGraph *graph = plot->addGraph();
+        graph->setData(data);
+        plot->rescaleAxes();
+
+        for(bool scatter : {false, true}){
+            graph->setLineStyle(scatter ? QCPGraph::lsNone : QCPGraph::lsLine);
+            graph->setScatterStyle(scatter ? QCPScatterStyle(QCPScatterStyle::ssDisc, 4) : QCPScatterStyle());
+            for(bool adaptiveSampling : {true, false}){
+                if(!adaptiveSampling && count > options.maxUnsampledPoints){
+                    continue;
+                }
+                graph->setAdaptiveSampling(adaptiveSampling);
+                benchmark.run(scatter ? "graph-scatter" : "graph-line",
+                              QJsonObject{{"points", count}, {"adaptiveSampling", adaptiveSampling}},
+                              [&]{ plot->replot(QCustomPlot::rpQueuedRefresh); },
+                              [&]{ return sampledPoints(plot.get()); });
+            }
+        }
+
+        // hit tests at random positions inside the axis rect, as during mouse hover and selection
+        graph->setLineStyle(QCPGraph::lsLine);
+        graph->setScatterStyle(QCPScatterStyle());
+        graph->setAdaptiveSampling(true);
+        plot->replot(QCustomPlot::rpQueuedRefresh);
+        const QRect axisRect = plot->axisRect()->rect();
+        const int queries = 100;
+        QVector<QPointF> positions;
+        QRandomGenerator random(7);
+        for(int i = 0; i < queries; ++i){
+            positions.append(QPointF(axisRect.left() + random.bounded(axisRect.width()), axisRect.top() + random.bounded(axisRect.height())));
+        }
+        for(bool spatialIndexing : {false, true}){
+            graph->setSpatialIndexing(spatialIndexing);
+            const QJsonObject parameters{{"points", count}, {"queries", queries}, {"spatialIndexing", spatialIndexing}};
+            benchmark.run("hit-test-point", parameters, [&]{
+                for(const QPointF &position : positions){
+                    graph->selectTest(position, false);
+                }
+            });
+            benchmark.run("hit-test-rect", parameters, [&]{
+                for(const QPointF &position : positions){
+                    graph->selectTestRect(QRectF(position, QSizeF(50, 50)), false);
+                }
+            });
+            benchmark.run("hit-test-nearest", parameters, [&]{
+                for(const QPointF &position : positions){
+                    graph->findNearestData(position, 10);
+                }
+            });
+        }
+    }
+}
+
+void benchmarkColorMaps(Benchmark &benchmark)
+{
+    if(!benchmark.isAnySelected({"colormap-update", "colormap-replot"})){
+        return;
+    }
+    for(int size : {100, 500, 1000, 2000}){
+        std::unique_ptr<QCustomPlot> plot = createPlot();
+        QCPColorMap *colorMap = new QCPColorMap(plot->xAxis, plot->yAxis);
+        colorMap->data()->setSize(size, size);
+        colorMap->data()->setRange(QCPRange(0, 1), QCPRange(0, 1));
+        for(int x = 0; x < size; ++x){
+            for(int y = 0; y < size; ++y){
+                colorMap->data()->setCell(x, y, qSin(x*0.05)*qCos(y*0.05));
+            }
+        }
+        colorMap->setGradient(QCPColorGradient::gpJet);
+        colorMap->rescaleDataRange();
+        plot->rescaleAxes();
+
+        const QJsonObject parameters{{"cells", size*size}, {"size", size}};
+        // modifying a cell makes the map image be regenerated on the next replot
+        double z = 0;
+        benchmark.run("colormap-update", parameters, [&]{
+            colorMap->data()->setCell(0, 0, z += 0.001);
+            plot->replot(QCustomPlot::rpQueuedRefresh);
+        });
+        benchmark.run("colormap-replot", parameters, [&]{ plot->replot(QCustomPlot::rpQueuedRefresh); });
+    }
+}
+
+void benchmarkTickers(Benchmark &benchmark)
+{
+    if(!benchmark.isSelected("ticks")){
+        return;
+    }
+    const QLocale locale(QLocale::C);
+    const int ranges = 1000;
+    QList<QPair<QString, QSharedPointer<QCPAxisTicker>>> tickers;
+    tickers.append(qMakePair(QString("fixed"), QSharedPointer<QCPAxisTicker>(new QCPAxisTicker)));
+    tickers.append(qMakePair(QString("datetime"), QSharedPointer<QCPAxisTicker>(new QCPAxisTickerDateTime)));
+    tickers.append(qMakePair(QString("log"), QSharedPointer<QCPAxisTicker>(new QCPAxisTickerLog)));
+    tickers.append(qMakePair(QString("time"), QSharedPointer<QCPAxisTicker>(new QCPAxisTickerTime)));
+
+    for(const auto &ticker : tickers){
+        for(bool zoom : {false, true}){
+            // panning keeps the range size, so the tickers can reuse their cached tick step
+            benchmark.run("ticks", QJsonObject{{"ticker", ticker.first}, {"mode", zoom ? "zoom" : "pan"}, {"ranges", ranges}}, [&]{
+                QVector<double> ticks, subTicks;
+                QVector<QString> labels;
+                for(int i = 0; i < ranges; ++i){
+                    const double lower = 1 + i*0.37;
+                    const double size = zoom ? 10*qPow(1.01, i) : 10;
+                    ticker.second->generate(QCPRange(lower, lower + size), locale, 'g', 6, ticks, &subTicks, &labels);
+                }
+            });
+        }
+    }
+}
+
+void benchmarkCsv(Benchmark &benchmark, const Options &options)
+{
+    if(!benchmark.isAnySelected({"csv-save", "csv-load"})){
+        return;
+    }
+    QTemporaryDir directory;
+    if(!directory.isValid()){
+        fprintf(stderr, "could not create a temporary directory, skipping CSV benchmarks\n");
+        return;
+    }
+    const QString filePath = directory.filePath("benchmark.csv");
+    for(qint64 count : pointCounts(options.maxPoints)){
+        if(count < 100000){
+            continue;
+        }
+        QSharedPointer<QCPGraphDataContainer> data = randomWalk(count);
+        const QJsonObject parameters{{"points", count}, {"threads", QThread::idealThreadCount()}};
+        auto fileSize = [&]{ return QJsonObject{{"bytes", QFileInfo(filePath).size()}}; };
+        auto save = [&]{
+            CsvWriter writer(filePath);
+            writer.setHeader("x,y");
+            if(!writer.write(*data)){
+                fprintf(stderr, "%s\n", qPrintable(writer.errorString()));
+            }
+        };
+
+        benchmark.run("csv-save", parameters, save, fileSize);
+        if(!benchmark.isSelected("csv-save")){
+            save(); // csv-load reads the file written by csv-save
+        }
+        benchmark.run("csv-load", parameters, [&]{
+            QVector<double> keys, values;
+            CsvReader reader(filePath);
+            if(!reader.read(keys, values)){
+                fprintf(stderr, "%s\n", qPrintable(reader.errorString()));
+            }
+        }, fileSize);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")){
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("customPlotBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless benchmarks of graph rendering, color maps, tick generation, hit-testing and CSV I/O.");
+    parser.addHelpOption();
+    QCommandLineOption maxPointsOption("max-points", "Largest graph and CSV size, up to 100000000.", "count", "10000000");
+    QCommandLineOption maxUnsampledOption("max-unsampled-points", "Largest graph size rendered without adaptive sampling.", "count", "1000000");
+    QCommandLineOption minTimeOption("min-time", "Minimum time in seconds each benchmark is repeated for.", "seconds", "0.2");
+    QCommandLineOption filterOption("filter", "Only run benchmarks whose name contains this text, e.g. graph, colormap, ticks, hit-test or csv.", "text");
+    QCommandLineOption outputOption("output", "Write the JSON results to this file instead of stdout.", "file");
+    parser.addOptions({maxPointsOption, maxUnsampledOption, minTimeOption, filterOption, outputOption});
+    parser.process(app);
+
+    Options options;
+    options.maxPoints = parser.value(maxPointsOption).toLongLong();
+    options.maxUnsampledPoints = parser.value(maxUnsampledOption).toLongLong();
+    options.minTime = parser.value(minTimeOption).toDouble();
+    options.filter = parser.value(filterOption);
+
+    Benchmark benchmark(options);
+    benchmarkGraphs(benchmark, options);
+    benchmarkColorMaps(benchmark);
+    benchmarkTickers(benchmark);
+    benchmarkCsv(benchmark, options);
+
+    QJsonObject report;
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["qtVersion"] = QString(qVersion());
+    report["platform"] = QApplication::platformName();
+    report["cpuArchitecture"] = QSysInfo::currentCpuArchitecture();
+    report["kernel"] = QSysInfo::kernelType() + " " + QSysInfo::kernelVersion();
+    report["idealThreadCount"] = QThread::idealThreadCount();
+    report["results"] = benchmark.results;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if(parser.isSet(outputOption)){
+        QFile file(parser.value(outputOption));
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()){
+            fprintf(stderr, "could not write %s: %s\n", qPrintable(file.fileName()), qPrintable(file.errorString()));
+            return 1;
+        }
+    }
+    else{
+        fwrite(json.constData(), 1, size_t(json.size()), stdout);
+    }
+    return 0;
+}
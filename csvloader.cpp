@@ -0,0 +1,59 @@
+#include "csvloader.h"
+#include <QThread>
+
+namespace {
+
+const int previewSampleCount = 4096;
+
+} // namespace
+
+CsvLoader::CsvLoader(const QString &filePath, QObject *parent)
+    : QObject(parent)
+    , path(filePath)
+    , reader(filePath)
+    , thread(nullptr)
+{
+}
+
+// Cancels a running load and waits for the worker thread, so no signal is emitted afterwards.
+CsvLoader::~CsvLoader()
+{
+    if (thread){
+        reader.cancel();
+        thread->wait();
+        delete thread;
+    }
+}
+
+void CsvLoader::start()
+{
+    if (thread)
+        return;
+    thread = QThread::create([this]{ run(); });
+    thread->start();
+}
+
+// May be called from any thread. Blocks that were already published stay valid; finished is
+// emitted with success set to false once the worker thread has stopped.
+void CsvLoader::cancel()
+{
+    reader.cancel();
+}
+
+void CsvLoader::run()
+{
+    QVector<double> keys;
+    QVector<double> values;
+    if (reader.readSample(previewSampleCount, keys, values) && !keys.isEmpty())
+        emit previewLoaded(keys, values);
+
+    reader.setChunkCallback([this](const QVector<double> &chunkKeys, const QVector<double> &chunkValues, bool sorted){
+        emit chunkLoaded(chunkKeys, chunkValues, sorted);
+    });
+    reader.setProgressCallback([this](qint64 bytesRead, qint64 bytesTotal){
+        emit progressChanged(bytesRead, bytesTotal);
+        return true;
+    });
+    const bool success = reader.read(keys, values);
+    emit finished(success, reader.errorString());
+}
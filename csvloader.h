@@ -0,0 +1,44 @@
+#ifndef CSVLOADER_H
+#define CSVLOADER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include "csvreader.h"
+
+class QThread;
+
+// Reads a CSV file with CsvReader on a worker thread and publishes the data as it arrives.
+//
+// First a coarse sample spread over the whole file is published with previewLoaded, then the
+// data points of every parsed block with chunkLoaded, in file order. The signals are emitted from
+// the worker thread, so connections to objects of the GUI thread are queued automatically.
+class CsvLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CsvLoader(const QString &filePath, QObject *parent = nullptr);
+    ~CsvLoader();
+
+    void start();
+    void cancel();
+
+    bool isCanceled() const { return reader.isCanceled(); }
+    QString filePath() const { return path; }
+
+signals:
+    void previewLoaded(const QVector<double> &keys, const QVector<double> &values);
+    void chunkLoaded(const QVector<double> &keys, const QVector<double> &values, bool sorted);
+    void progressChanged(qint64 bytesRead, qint64 bytesTotal);
+    void finished(bool success, const QString &errorString);
+
+private:
+    QString path;
+    CsvReader reader;
+    QThread *thread;
+
+    void run();
+};
+
+#endif // CSVLOADER_H
@@ -0,0 +1,475 @@
+#include "csvreader.h"
+#include <QByteArray>
+#include <QFile>
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if __has_include(<charconv>)
+#  include <charconv>
+#  if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#    define CSVREADER_FROM_CHARS
+#  endif
+#endif
+
+namespace {
+
+const qint64 defaultBlockSize = 64*1024*1024;
+const qint64 minimumRangeSize = 1024*1024;       // don't start a thread for less than this
+const qint64 cancelCheckInterval = 1024*1024;    // bytes parsed between checks of the cancel flag
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool isBlankLine(const char *begin, const char *end)
+{
+    for (const char *p = begin; p < end; ++p){
+        if (!isBlank(*p))
+            return false;
+    }
+    return true;
+}
+
+// Parses plain decimal numbers like "-12.5e3" with at most 15 significant digits and a decimal
+// exponent within +-22. Then both the mantissa and the power of ten are exactly representable as
+// double, so the single multiplication or division is correctly rounded and the result equals
+// that of strtod. Returns false for anything else, which is left to the general parser.
+bool parseDoubleFast(const char *p, const char *last, double &result)
+{
+    static const double powersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    bool negative = false;
+    if (p < last && *p == '-'){
+        negative = true;
+        ++p;
+    }
+
+    quint64 mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool anyDigits = false;
+    for (; p < last && isDigit(*p); ++p){
+        anyDigits = true;
+        if (mantissa == 0 && *p == '0')
+            continue;
+        if (++significantDigits > 15)
+            return false;
+        mantissa = mantissa*10 + quint64(*p - '0');
+    }
+    if (p < last && *p == '.'){
+        for (++p; p < last && isDigit(*p); ++p){
+            anyDigits = true;
+            --exponent;
+            if (mantissa == 0 && *p == '0')
+                continue;
+            if (++significantDigits > 15)
+                return false;
+            mantissa = mantissa*10 + quint64(*p - '0');
+        }
+    }
+    if (!anyDigits)
+        return false;
+
+    if (p < last && (*p == 'e' || *p == 'E')){
+        ++p;
+        bool negativeExponent = false;
+        if (p < last && (*p == '+' || *p == '-')){
+            negativeExponent = *p == '-';
+            ++p;
+        }
+        if (p == last || !isDigit(*p))
+            return false;
+        int explicitExponent = 0;
+        for (; p < last && isDigit(*p); ++p){
+            if (explicitExponent < 100000)
+                explicitExponent = explicitExponent*10 + (*p - '0');
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+    if (p != last)
+        return false;
+
+    if (mantissa == 0){
+        result = negative ? -0.0 : 0.0;
+        return true;
+    }
+    if (exponent < -22 || exponent > 22)
+        return false;
+    double value = double(mantissa);
+    value = exponent < 0 ? value/powersOf10[-exponent] : value*powersOf10[exponent];
+    result = negative ? -value : value;
+    return true;
+}
+
+} // namespace
+
+CsvReader::CsvReader(const QString &filePath)
+    : filePath(filePath)
+    , threadCount(qMax(1, QThread::idealThreadCount()))
+    , headerLines(1)
+    , blockSize(defaultBlockSize)
+    , canceled(false)
+    , sorted(true)
+    , skipped(0)
+{
+}
+
+void CsvReader::setThreadCount(int count)
+{
+    threadCount = qMax(1, count);
+}
+
+// Number of lines at the beginning of the file which don't contain data. Files written by
+// MainWindow::on_btnSave_clicked start with one line holding the time stamp.
+void CsvReader::setHeaderLines(int count)
+{
+    headerLines = qMax(0, count);
+}
+
+// Number of bytes mapped and parsed at once. Blocks are extended to the next line end, so lines
+// longer than the block size are still read correctly.
+void CsvReader::setBlockSize(qint64 bytes)
+{
+    blockSize = qMax(qint64(4096), bytes);
+}
+
+void CsvReader::setProgressCallback(const ProgressCallback &callback)
+{
+    progressCallback = callback;
+}
+
+// If a chunk callback is set, read() passes the data points of each block to it instead of
+// collecting them, so the whole data doesn't have to be kept twice while streaming it elsewhere.
+void CsvReader::setChunkCallback(const ChunkCallback &callback)
+{
+    chunkCallback = callback;
+}
+
+// May be called from any thread. read() returns false as soon as the running parse threads have
+// noticed the request.
+void CsvReader::cancel()
+{
+    canceled.store(true);
+}
+
+// Reads all data lines of the file into keys and values. Lines that don't consist of exactly two
+// numbers separated by a comma are skipped (see skippedLines()). Returns false if the file
+// couldn't be read or reading was canceled, in which case keys and values are left empty.
+bool CsvReader::read(QVector<double> &keys, QVector<double> &values)
+{
+    keys.clear();
+    values.clear();
+    sorted = true;
+    skipped = 0;
+    error.clear();
+
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly)){
+        error = file.errorString();
+        return false;
+    }
+
+    const qint64 fileSize = file.size();
+    int headerLinesLeft = headerLines;
+    qint64 pos = 0;
+    qint64 dataCount = 0;
+    bool hasLastKey = false;
+    double lastKey = 0;
+    while (pos < fileSize && !isCanceled()){
+        // map the next block and shrink it to end at a line end:
+        qint64 length = qMin(blockSize, fileSize - pos);
+        uchar *block = nullptr;
+        const char *blockEnd = nullptr;
+        for (;;){
+            block = file.map(pos, length);
+            if (!block){
+                error = file.errorString();
+                keys.clear();
+                values.clear();
+                return false;
+            }
+            blockEnd = reinterpret_cast<const char*>(block) + length;
+            if (pos + length == fileSize)
+                break;
+            const char *lastNewline = blockEnd;
+            while (lastNewline > reinterpret_cast<const char*>(block) && *(lastNewline - 1) != '\n')
+                --lastNewline;
+            if (lastNewline > reinterpret_cast<const char*>(block)){
+                blockEnd = lastNewline;
+                break;
+            }
+            file.unmap(block); // no line end in block, try again with a larger one
+            length = qMin(length*2, fileSize - pos);
+        }
+        const char *blockBegin = reinterpret_cast<const char*>(block);
+
+        const char *dataBegin = blockBegin;
+        while (headerLinesLeft > 0 && dataBegin < blockEnd){
+            const char *newline = static_cast<const char*>(std::memchr(dataBegin, '\n', size_t(blockEnd - dataBegin)));
+            dataBegin = newline ? newline + 1 : blockEnd;
+            --headerLinesLeft;
+        }
+
+        // count the lines of each range to know where it writes its data points, then parse:
+        QVector<Range> ranges = splitBlock(dataBegin, blockEnd);
+        runParallel(ranges, [this](Range &range){ countLines(range); });
+        qint64 lineCount = 0;
+        for (Range &range : ranges){
+            range.firstIndex = dataCount + lineCount;
+            lineCount += range.count;
+        }
+        if (pos == 0 && blockEnd - blockBegin > 0 && !chunkCallback){
+            // estimate the total number of data points from the first block, to avoid reallocating:
+            const qint64 estimate = lineCount*fileSize/(blockEnd - blockBegin);
+            keys.reserve(estimate + estimate/16);
+            values.reserve(estimate + estimate/16);
+        }
+        keys.resize(dataCount + lineCount);
+        values.resize(dataCount + lineCount);
+        double *keyData = keys.data();
+        double *valueData = values.data();
+        runParallel(ranges, [this, keyData, valueData](Range &range){ parseRange(range, keyData, valueData); });
+        pos += blockEnd - blockBegin;
+        file.unmap(block);
+
+        // close the gaps left by skipped lines and check whether the keys are still ascending:
+        for (const Range &range : std::as_const(ranges)){
+            if (range.count > 0){
+                if (range.firstIndex != dataCount){
+                    std::copy(keyData + range.firstIndex, keyData + range.firstIndex + range.count, keyData + dataCount);
+                    std::copy(valueData + range.firstIndex, valueData + range.firstIndex + range.count, valueData + dataCount);
+                }
+                if (!range.sorted || (hasLastKey && keyData[dataCount] < lastKey))
+                    sorted = false;
+                lastKey = keyData[dataCount + range.count - 1];
+                hasLastKey = true;
+                dataCount += range.count;
+            }
+            skipped += range.skipped;
+        }
+        keys.resize(dataCount);
+        values.resize(dataCount);
+        if (chunkCallback && dataCount > 0 && !isCanceled()){
+            chunkCallback(keys, values, sorted);
+            keys.resize(0);
+            values.resize(0);
+            dataCount = 0;
+        }
+
+        if (progressCallback && !progressCallback(pos, fileSize))
+            cancel();
+    }
+
+    if (isCanceled()){
+        error = "Loading canceled";
+        keys.clear();
+        values.clear();
+        return false;
+    }
+    return true;
+}
+
+// Reads about count data lines spread evenly over the file, without reading the lines in between.
+// This gives a coarse overview of large files in a fraction of the time read() takes. The returned
+// keys are in file order, so they may not be sorted even if the whole file is.
+bool CsvReader::readSample(int count, QVector<double> &keys, QVector<double> &values)
+{
+    keys.clear();
+    values.clear();
+    error.clear();
+
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly)){
+        error = file.errorString();
+        return false;
+    }
+
+    const qint64 fileSize = file.size();
+    const qint64 windowSize = 4096;
+    qint64 dataStart = 0;
+    {
+        const qint64 headSize = qMin(fileSize, qint64(1024*1024));
+        uchar *head = file.map(0, headSize);
+        if (!head){
+            error = file.errorString();
+            return false;
+        }
+        const char *headBegin = reinterpret_cast<const char*>(head);
+        const char *headerEnd = skipHeader(headBegin, headBegin + headSize);
+        dataStart = headerEnd ? headerEnd - headBegin : fileSize; // header longer than head, no sample
+        file.unmap(head);
+    }
+
+    keys.reserve(count);
+    values.reserve(count);
+    qint64 lastLineOffset = -1;
+    for (int i = 0; i < count && dataStart < fileSize && !isCanceled(); ++i){
+        const qint64 offset = dataStart + (fileSize - dataStart)*i/count;
+        const qint64 length = qMin(windowSize, fileSize - offset);
+        uchar *window = file.map(offset, length);
+        if (!window){
+            error = file.errorString();
+            return false;
+        }
+        const char *windowEnd = reinterpret_cast<const char*>(window) + length;
+        const char *lineBegin = reinterpret_cast<const char*>(window);
+        if (offset > dataStart){ // skip the rest of the line the offset points into
+            const char *newline = static_cast<const char*>(std::memchr(lineBegin, '\n', size_t(windowEnd - lineBegin)));
+            lineBegin = newline ? newline + 1 : windowEnd;
+        }
+        const qint64 lineOffset = offset + (lineBegin - reinterpret_cast<const char*>(window));
+        const char *lineEnd = static_cast<const char*>(std::memchr(lineBegin, '\n', size_t(windowEnd - lineBegin)));
+        if (!lineEnd && offset + length == fileSize)
+            lineEnd = windowEnd; // last line of the file without line end
+        double key, value;
+        if (lineEnd && lineOffset > lastLineOffset && parseLine(lineBegin, lineEnd, key, value)){
+            lastLineOffset = lineOffset; // in small files, several offsets point into the same line
+            keys.append(key);
+            values.append(value);
+        }
+        file.unmap(window);
+    }
+    return !isCanceled();
+}
+
+// Parses a single number, allowing surrounding blanks and a leading '+', like QString::toDouble.
+bool CsvReader::parseDouble(const char *first, const char *last, double &result)
+{
+    while (first < last && isBlank(*first))
+        ++first;
+    while (last > first && isBlank(*(last - 1)))
+        --last;
+    if (first < last && *first == '+')
+        ++first;
+    if (first == last || *first == '+')
+        return false;
+
+    if (parseDoubleFast(first, last, result))
+        return true;
+#ifdef CSVREADER_FROM_CHARS
+    const std::from_chars_result parsed = std::from_chars(first, last, result);
+    return parsed.ec == std::errc() && parsed.ptr == last;
+#else
+    bool ok = false;
+    result = QByteArray::fromRawData(first, int(last - first)).toDouble(&ok);
+    return ok;
+#endif
+}
+
+// Returns the beginning of the first data line after the header lines, or nullptr if the header
+// doesn't end before end.
+const char *CsvReader::skipHeader(const char *begin, const char *end) const
+{
+    const char *dataBegin = begin;
+    for (int i = 0; i < headerLines; ++i){
+        const char *newline = static_cast<const char*>(std::memchr(dataBegin, '\n', size_t(end - dataBegin)));
+        if (!newline)
+            return nullptr;
+        dataBegin = newline + 1;
+    }
+    return dataBegin;
+}
+
+// Splits [begin, end) at line ends into one range per thread.
+QVector<CsvReader::Range> CsvReader::splitBlock(const char *begin, const char *end) const
+{
+    const qint64 size = end - begin;
+    const int rangeCount = int(qBound(qint64(1), size/minimumRangeSize, qint64(threadCount)));
+    QVector<Range> ranges(rangeCount);
+    const char *rangeBegin = begin;
+    for (int i = 0; i < rangeCount; ++i){
+        const char *rangeEnd = end;
+        if (i < rangeCount - 1){
+            rangeEnd = qMax(rangeBegin, begin + size*(i + 1)/rangeCount);
+            const char *newline = static_cast<const char*>(std::memchr(rangeEnd, '\n', size_t(end - rangeEnd)));
+            rangeEnd = newline ? newline + 1 : end;
+        }
+        Range &range = ranges[i];
+        range.begin = rangeBegin;
+        range.end = rangeEnd;
+        range.firstIndex = 0;
+        range.count = 0;
+        range.skipped = 0;
+        range.sorted = true;
+        rangeBegin = rangeEnd;
+    }
+    return ranges;
+}
+
+// Runs function for every range, each on its own thread. The first range is processed on the
+// calling thread.
+void CsvReader::runParallel(QVector<Range> &ranges, const std::function<void(Range &)> &function) const
+{
+    Range *rangeData = ranges.data();
+    std::vector<std::thread> threads;
+    threads.reserve(size_t(ranges.size()));
+    for (qsizetype i = 1; i < ranges.size(); ++i)
+        threads.emplace_back(function, std::ref(rangeData[i]));
+    if (!ranges.isEmpty())
+        function(rangeData[0]);
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+// Sets range.count to the number of lines in the range, an upper bound for its data points.
+void CsvReader::countLines(Range &range) const
+{
+    range.count = std::count(range.begin, range.end, '\n');
+    if (range.end > range.begin && *(range.end - 1) != '\n')
+        ++range.count; // last line of the file without line end
+}
+
+void CsvReader::parseRange(Range &range, double *keys, double *values) const
+{
+    qint64 index = range.firstIndex;
+    bool hasLastKey = false;
+    double lastKey = 0;
+    const char *p = range.begin;
+    const char *lastCancelCheck = p;
+    while (p < range.end){
+        const char *lineEnd = static_cast<const char*>(std::memchr(p, '\n', size_t(range.end - p)));
+        if (!lineEnd)
+            lineEnd = range.end;
+        double key, value;
+        if (parseLine(p, lineEnd, key, value)){
+            keys[index] = key;
+            values[index] = value;
+            ++index;
+            if (hasLastKey && key < lastKey)
+                range.sorted = false;
+            lastKey = key;
+            hasLastKey = true;
+        }
+        else if (!isBlankLine(p, lineEnd)){
+            ++range.skipped;
+        }
+        p = lineEnd < range.end ? lineEnd + 1 : range.end;
+        if (p - lastCancelCheck >= cancelCheckInterval){
+            if (canceled.load(std::memory_order_relaxed))
+                break;
+            lastCancelCheck = p;
+        }
+    }
+    range.count = index - range.firstIndex;
+}
+
+bool CsvReader::parseLine(const char *begin, const char *end, double &key, double &value)
+{
+    const char *comma = static_cast<const char*>(std::memchr(begin, ',', size_t(end - begin)));
+    if (!comma)
+        return false;
+    if (std::memchr(comma + 1, ',', size_t(end - comma - 1)))
+        return false; // more than two columns
+    return parseDouble(begin, comma, key) && parseDouble(comma + 1, end, value);
+}
@@ -0,0 +1,74 @@
+#ifndef CSVREADER_H
+#define CSVREADER_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+// Reads two-column "key,value" CSV files as written by MainWindow::on_btnSave_clicked.
+//
+// The file is memory-mapped block by block. Each block is split at line boundaries into one
+// range per thread, the ranges are parsed in parallel directly from the mapped bytes, and the
+// results are written into preallocated key/value arrays. Memory use stays at the size of the
+// parsed arrays plus one mapped block, instead of several copies of the whole file as text.
+class CsvReader
+{
+public:
+    // Called on the thread that runs read(), after each parsed block. Returns whether reading
+    // should continue; returning false has the same effect as cancel().
+    using ProgressCallback = std::function<bool(qint64 bytesRead, qint64 bytesTotal)>;
+    // Called on the thread that runs read(), with the data points of each parsed block. sorted
+    // tells whether all keys read so far are ascending.
+    using ChunkCallback = std::function<void(const QVector<double> &keys, const QVector<double> &values, bool sorted)>;
+
+    explicit CsvReader(const QString &filePath);
+
+    void setThreadCount(int count);
+    void setHeaderLines(int count);
+    void setBlockSize(qint64 bytes);
+    void setProgressCallback(const ProgressCallback &callback);
+    void setChunkCallback(const ChunkCallback &callback);
+
+    bool read(QVector<double> &keys, QVector<double> &values);
+    bool readSample(int count, QVector<double> &keys, QVector<double> &values);
+    void cancel();
+
+    bool isCanceled() const { return canceled.load(); }
+    bool isSorted() const { return sorted; }
+    qint64 skippedLines() const { return skipped; }
+    QString errorString() const { return error; }
+
+    static bool parseDouble(const char *first, const char *last, double &result);
+
+private:
+    struct Range
+    {
+        const char *begin;
+        const char *end;
+        qint64 firstIndex;  // where the range writes its first data point
+        qint64 count;       // number of data points written
+        qint64 skipped;     // number of non-empty lines that couldn't be parsed
+        bool sorted;
+    };
+
+    QString filePath;
+    int threadCount;
+    int headerLines;
+    qint64 blockSize;
+    ProgressCallback progressCallback;
+    ChunkCallback chunkCallback;
+    std::atomic<bool> canceled;
+    bool sorted;
+    qint64 skipped;
+    QString error;
+
+    const char *skipHeader(const char *begin, const char *end) const;
+    QVector<Range> splitBlock(const char *begin, const char *end) const;
+    void runParallel(QVector<Range> &ranges, const std::function<void(Range &)> &function) const;
+    void countLines(Range &range) const;
+    void parseRange(Range &range, double *keys, double *values) const;
+    static bool parseLine(const char *begin, const char *end, double &key, double &value);
+};
+
+#endif // CSVREADER_H
@@ -0,0 +1,124 @@
+#include "csvwriter.h"
+#include <QLocale>
+#include <QSaveFile>
+#include <QThread>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if __has_include(<charconv>)
+#  include <charconv>
+#  if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#    define CSVWRITER_TO_CHARS
+#  endif
+#endif
+
+namespace {
+
+const int rowsPerPiece = 256*1024;  // about 10 MiB of text per piece
+const int maxDoubleLength = 32;     // "-1.2345678901234567e-308" and the like
+const int maxRowLength = 2*maxDoubleLength + 2;
+
+} // namespace
+
+CsvWriter::CsvWriter(const QString &filePath)
+    : filePath(filePath)
+    , threadCount(qMax(1, QThread::idealThreadCount()))
+{
+}
+
+// A line written before the data, like the time stamp of MainWindow::on_btnSave_clicked.
+void CsvWriter::setHeader(const QString &header)
+{
+    this->header = header;
+}
+
+void CsvWriter::setThreadCount(int count)
+{
+    threadCount = qMax(1, count);
+}
+
+// Writes the data points of data which lie in rows. The file is replaced only once it was written
+// completely.
+bool CsvWriter::write(const QCPGraphDataContainer &data, const QCPDataSelection &rows)
+{
+    error.clear();
+    QSaveFile file(filePath);
+    if (!file.open(QFile::WriteOnly)){
+        error = file.errorString();
+        return false;
+    }
+    if (!header.isEmpty()){
+        const QByteArray headerLine = header.toUtf8() + '\n';
+        if (file.write(headerLine) != headerLine.size()){
+            error = file.errorString();
+            return false;
+        }
+    }
+
+    // cut the rows into pieces that are formatted independently:
+    QVector<QCPDataRange> pieces;
+    const QCPDataRange dataBounds(0, data.size());
+    for (const QCPDataRange &range : rows.dataRanges()){
+        const QCPDataRange bounded = range.bounded(dataBounds);
+        for (int begin = bounded.begin(); begin < bounded.end(); begin += rowsPerPiece)
+            pieces.append(QCPDataRange(begin, qMin(bounded.end(), begin + rowsPerPiece)));
+    }
+
+    // format up to threadCount pieces at once and write them in order:
+    QVector<QByteArray> buffers(threadCount);
+    for (qsizetype first = 0; first < pieces.size(); first += threadCount){
+        const int count = int(qMin(qsizetype(threadCount), pieces.size() - first));
+        std::vector<std::thread> threads;
+        for (int i = 1; i < count; ++i)
+            threads.emplace_back(&CsvWriter::formatRows, std::cref(data), pieces.at(first + i), std::ref(buffers[i]));
+        formatRows(data, pieces.at(first), buffers[0]);
+        for (std::thread &thread : threads)
+            thread.join();
+        for (int i = 0; i < count; ++i){
+            if (file.write(buffers.at(i)) != buffers.at(i).size()){
+                error = file.errorString();
+                return false;
+            }
+        }
+    }
+
+    if (!file.commit()){
+        error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool CsvWriter::write(const QCPGraphDataContainer &data)
+{
+    return write(data, QCPDataSelection(QCPDataRange(0, data.size())));
+}
+
+// Writes the shortest text that reads back to exactly value into buffer, which must have room for
+// maxDoubleLength characters. Returns the number of characters written.
+int CsvWriter::formatDouble(double value, char *buffer)
+{
+#ifdef CSVWRITER_TO_CHARS
+    const std::to_chars_result result = std::to_chars(buffer, buffer + maxDoubleLength, value);
+    return int(result.ptr - buffer);
+#else
+    const QByteArray text = QByteArray::number(value, 'g', QLocale::FloatingPointShortest);
+    std::memcpy(buffer, text.constData(), size_t(text.size()));
+    return int(text.size());
+#endif
+}
+
+void CsvWriter::formatRows(const QCPGraphDataContainer &data, const QCPDataRange &piece, QByteArray &buffer)
+{
+    buffer.resize(piece.size()*maxRowLength);
+    char *out = buffer.data();
+    QCPGraphDataContainer::const_iterator it = data.constBegin() + piece.begin();
+    for (int i = piece.begin(); i < piece.end(); ++i, ++it){
+        out += formatDouble(it->key, out);
+        *out++ = ',';
+        out += formatDouble(it->value, out);
+        *out++ = '\n';
+    }
+    buffer.resize(out - buffer.constData());
+}
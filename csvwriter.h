@@ -0,0 +1,38 @@
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include "qcustomplot.h"
+
+// Writes graph data as two-column "key,value" CSV files, readable by CsvReader.
+//
+// Numbers are formatted with the shortest representation that reads back to the identical
+// double. The rows are cut into pieces which are formatted into byte buffers in parallel, and the
+// buffers are then written in order through a single file handle.
+class CsvWriter
+{
+public:
+    explicit CsvWriter(const QString &filePath);
+
+    void setHeader(const QString &header);
+    void setThreadCount(int count);
+
+    bool write(const QCPGraphDataContainer &data, const QCPDataSelection &rows);
+    bool write(const QCPGraphDataContainer &data);
+
+    QString errorString() const { return error; }
+
+    static int formatDouble(double value, char *buffer);
+
+private:
+    QString filePath;
+    QString header;
+    int threadCount;
+    QString error;
+
+    static void formatRows(const QCPGraphDataContainer &data, const QCPDataRange &piece, QByteArray &buffer);
+};
+
+#endif // CSVWRITER_H
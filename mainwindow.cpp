@@ -5,9 +5,23 @@
 #include <QColorDialog>
 #include <QFile>
 #include <QFileDialog>
-#include <QTextStream>
 #include <QDateTime>
 #include <QMessageBox>
+#include <QFileInfo>
+#include "csvloader.h"
+#include "tracefile.h"
+#include "csvwriter.h"
+#include "tracegraphsource.h"
+
+namespace {
+
+// traces with more points are displayed from disk instead of being loaded into memory
+const qint64 outOfCorePointCount = 20000000;
+
+// the hover readout snaps to data points within this many pixels of the cursor
+const double hoverSnapDistance = 10;
+
+} // namespace
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -50,6 +64,9 @@ MainWindow::MainWindow(QWidget *parent)
     plot->installEventFilter(this);
 
     plot->graph(0)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, Qt::black, Qt::black, 0));
+
+    connect(plot, &QCustomPlot::mousePress, this, &MainWindow::stopFollowingCsvLoading);
+    connect(plot, &QCustomPlot::mouseWheel, this, &MainWindow::stopFollowingCsvLoading);
 }
 
 MainWindow::~MainWindow()
@@ -81,9 +98,24 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
             double x = plot->xAxis->pixelToCoord(mouseEvent->pos().x());
             double y = plot->yAxis->pixelToCoord(mouseEvent->pos().y());
 
+            // snap to the nearest data point close to the cursor, otherwise show the graph value at the cursor's key
+            double graphValue = qQNaN();
+            if(plot->graphCount() > 0){
+                QCPGraph *graph = plot->graph(0);
+                int index = graph->findNearestData(mouseEvent->position(), hoverSnapDistance, &graphValue);
+                if(index >= 0){
+                    x = graph->dataMainKey(index);
+                    y = graph->dataMainValue(index);
+                    graphValue = qQNaN();
+                }
+            }
+
             QString text = QString("X: %1\nY: %2")
                                .arg(x, 0, 'f', 2)
                                .arg(y, 0, 'f', 2);
+            if(!qIsNaN(graphValue)){
+                text += QString("\nGraph: %1").arg(graphValue, 0, 'f', 2);
+            }
 
             QToolTip::showText(mouseEvent->globalPosition().toPoint(), text, plot);
         }
@@ -128,7 +160,15 @@ void MainWindow::errorMessage(QString text){
 void MainWindow::on_btnGenerate_clicked()
 {
     if(!isGenerating){
-        if(ui->lineCount->text().isEmpty()){
+        if(loader){
+            errorMessage("Please wait until loading has finished");
+            return;
+        }
+        else if(traceSource){
+            errorMessage("Please clear the trace displayed from disk first");
+            return;
+        }
+        else if(ui->lineCount->text().isEmpty()){
             errorMessage("Please enter count");
             return;
         }
@@ -170,6 +210,9 @@ void MainWindow::on_btnGenerate_clicked()
 
 void MainWindow::on_btnClear_clicked()
 {
+    if(loader){
+        loader->cancel();
+    }
     if(!isGenerating){
         QCPScatterStyle currentStyle = plot->graph(0)->scatterStyle();
         QPen pen = plot->graph(0)->pen();
@@ -387,48 +430,249 @@ void MainWindow::on_btnYZeroLineColor_clicked()
 
 void MainWindow::on_btnSave_clicked()
 {
+    const QString csvAll = "CSV File (*.csv)";
+    const QString csvVisible = "CSV File, visible points only (*.csv)";
+    const QString csvSelected = "CSV File, selected points only (*.csv)";
+    const QString csvAllGraphs = "CSV File, one file per graph (*.csv)";
+    const QString trace = "Trace File (*.qcptrace)";
+
     QFileDialog dialog;
     dialog.setFileMode(QFileDialog::AnyFile);
-    QString filePath = dialog.getSaveFileName(this, "Create new file", "", "CSV File (*.csv)");
-    QFile file(filePath);
+    QString selectedFilter;
+    QString filePath = dialog.getSaveFileName(this, "Create new file", "",
+                                              QStringList({csvAll, csvVisible, csvSelected, csvAllGraphs, trace}).join(";;"),
+                                              &selectedFilter);
+    if(filePath.isEmpty()){
+        return;
+    }
+    if(traceSource){
+        errorMessage("This trace is displayed from disk, only its visible part is in memory. Please copy the trace file instead.");
+        return;
+    }
+    if(selectedFilter == trace){
+        if(!filePath.endsWith(".qcptrace", Qt::CaseInsensitive)){
+            filePath += ".qcptrace";
+        }
+        QString errorString;
+        if(!TraceFile::write(filePath, *xData, *yData, &errorString)){
+            errorMessage("Could not write " + filePath + ": " + errorString);
+        }
+        return;
+    }
+    if(plot->graphCount() == 0){
+        return;
+    }
+
     QString time = QDateTime::currentDateTime().toString("yyyy / MM / dd - HH : mm");
-    if(file.open(QFile::WriteOnly | QFile::Text)){
-        QTextStream out(&file);
-        out << time << "\n";
-        for (int i = 0; i < xData->size(); ++i) {
-            out << xData->at(i) << "," << yData->at(i) << "\n";
+    if(selectedFilter == csvAllGraphs){
+        // the first graph goes to the chosen file, the others to name_2.csv, name_3.csv, ...
+        QFileInfo fileInfo(filePath);
+        for (int i = 0; i < plot->graphCount(); ++i) {
+            QString graphFilePath = i == 0 ? filePath : fileInfo.path() + "/" + fileInfo.completeBaseName() + "_" + QString::number(i + 1) + ".csv";
+            if(!exportCsv(graphFilePath, plot->graph(i), QCPDataSelection(QCPDataRange(0, plot->graph(i)->dataCount())), time)){
+                return;
+            }
         }
+        return;
+    }
+
+    QCPGraph *graph = plot->graph(0);
+    QCPDataSelection rows(QCPDataRange(0, graph->dataCount()));
+    if(selectedFilter == csvVisible){
+        rows = QCPDataSelection(QCPDataRange(graph->findBegin(graph->keyAxis()->range().lower, false),
+                                             graph->findEnd(graph->keyAxis()->range().upper, false)));
+    }
+    else if(selectedFilter == csvSelected){
+        rows = graph->selection();
+    }
+    exportCsv(filePath, graph, rows, time);
+}
+
+bool MainWindow::exportCsv(const QString &filePath, QCPGraph *graph, const QCPDataSelection &rows, const QString &header)
+{
+    CsvWriter writer(filePath);
+    writer.setHeader(header);
+    if(!writer.write(*graph->data(), rows)){
+        errorMessage("Could not write " + filePath + ": " + writer.errorString());
+        return false;
     }
-    file.close();
+    return true;
 }
 
 
 void MainWindow::on_btnOpen_clicked()
 {
+    if(loader){
+        loader->cancel();
+        return;
+    }
+    if(isGenerating){
+        errorMessage("Please stop generating data first");
+        return;
+    }
+
     QFileDialog dialog;
     dialog.setFileMode(QFileDialog::AnyFile);
-    QString filePath = dialog.getOpenFileName(this, "Open CSV File", "", "CSV File (*.csv)");
-    QFile file(filePath);
-    if(file.open(QFile::ReadOnly | QFile::Text)){
+    QString filePath = dialog.getOpenFileName(this, "Open Data File", "", "Data Files (*.csv *.qcptrace);;CSV File (*.csv);;Trace File (*.qcptrace)");
+    if(filePath.isEmpty()){
+        return;
+    }
+    if(filePath.endsWith(".qcptrace", Qt::CaseInsensitive)){
+        openTraceFile(filePath);
+        return;
+    }
+
+    xData->clear();
+    yData->clear();
+    QCPScatterStyle currentStyle = plot->graph(0)->scatterStyle();
+    plot->clearItems();
+    plot->clearGraphs();
+    plot->addGraph();
+    plot->graph(0)->setScatterStyle(currentStyle);
+
+    // coarse overview of the whole file, replaced by the real data as it arrives:
+    previewGraph = plot->addGraph();
+    previewGraph->setPen(QPen(QColor(160, 160, 160)));
+    previewGraph->setSelectable(QCP::stNone);
+
+    followLoading = true;
+    loader = new CsvLoader(filePath, this);
+    connect(loader, &CsvLoader::previewLoaded, this, &MainWindow::showCsvPreview);
+    connect(loader, &CsvLoader::chunkLoaded, this, &MainWindow::appendCsvChunk);
+    connect(loader, &CsvLoader::progressChanged, this, &MainWindow::showCsvProgress);
+    connect(loader, &CsvLoader::finished, this, &MainWindow::finishCsvLoading);
+    ui->btnOpen->setText("Cancel Loading");
+    ui->statusbar->showMessage("Loading " + QFileInfo(filePath).fileName() + "...");
+    loader->start();
+}
+
+// Trace files are memory-mapped and their columns copied as a whole, so loading is bound by the
+// disk bandwidth and needs no background thread. Traces too large for that are displayed from
+// disk by a TraceGraphSource.
+void MainWindow::openTraceFile(const QString &filePath)
+{
+    TraceFile trace(filePath);
+    if(!trace.open(false)){
+        errorMessage("Could not read " + filePath + ": " + trace.errorString());
+        return;
+    }
+    if(trace.isSorted() && trace.pointCount() > outOfCorePointCount){
         xData->clear();
         yData->clear();
-        QTextStream in(&file);
-        QStringList items = in.readAll().split("\n");
-        for (int i = 1; i < items.size() - 1; ++i) {
-            QStringList data = items[i].split(",");
-            if (data.size() == 2){
-                xData->append(data[0].toDouble());
-                yData->append(data[1].toDouble());
-            }
-        }
         QCPScatterStyle currentStyle = plot->graph(0)->scatterStyle();
         plot->clearItems();
         plot->clearGraphs();
         plot->addGraph();
-        plot->graph(0)->setData(*xData, *yData);
         plot->graph(0)->setScatterStyle(currentStyle);
+
+        traceSource = new TraceGraphSource(plot->graph(0), filePath, this);
+        if(!traceSource->open()){
+            errorMessage("Could not read " + filePath + ": " + traceSource->errorString());
+            delete traceSource;
+            return;
+        }
+        plot->graph(0)->keyAxis()->setRange(traceSource->keyRange());
+        plot->graph(0)->valueAxis()->setRange(traceSource->valueRange());
+        traceSource->update();
+        plot->replot();
+        ui->statusbar->showMessage(QString("Showing %1 points from disk").arg(traceSource->pointCount()), 5000);
+        return;
+    }
+    if(!trace.open()){
+        errorMessage("Could not read " + filePath + ": " + trace.errorString());
+        return;
+    }
+    const qsizetype count = qsizetype(trace.pointCount());
+    xData->resize(count);
+    yData->resize(count);
+    std::copy(trace.keys(), trace.keys() + count, xData->begin());
+    std::copy(trace.values(), trace.values() + count, yData->begin());
+
+    QCPScatterStyle currentStyle = plot->graph(0)->scatterStyle();
+    plot->clearItems();
+    plot->clearGraphs();
+    plot->addGraph();
+    plot->graph(0)->setData(*xData, *yData, trace.isSorted());
+    plot->graph(0)->setScatterStyle(currentStyle);
+    plot->rescaleAxes();
+    plot->replot();
+}
+
+void MainWindow::showCsvPreview(const QVector<double> &keys, const QVector<double> &values)
+{
+    if(!loader || loader->isCanceled() || !previewGraph){
+        return;
+    }
+    previewGraph->setData(keys, values);
+    if(followLoading){
+        plot->rescaleAxes();
+    }
+    plot->replot(QCustomPlot::rpQueuedReplot);
+}
+
+void MainWindow::appendCsvChunk(const QVector<double> &keys, const QVector<double> &values, bool sorted)
+{
+    if(!loader || loader->isCanceled() || plot->graphCount() == 0){
+        return;
     }
-    file.close();
+    xData->append(keys);
+    yData->append(values);
+    plot->graph(0)->addData(keys, values, sorted);
+    if(sorted && previewGraph){
+        previewGraph->data()->removeBefore(keys.last());
+    }
+    if(followLoading){
+        plot->rescaleAxes();
+    }
+    plot->replot(QCustomPlot::rpQueuedReplot);
+}
+
+void MainWindow::showCsvProgress(qint64 bytesRead, qint64 bytesTotal)
+{
+    if(!loader){
+        return;
+    }
+    ui->statusbar->showMessage(QString("Loading %1: %2 %")
+                                   .arg(QFileInfo(loader->filePath()).fileName())
+                                   .arg(bytesRead*100/qMax(qint64(1), bytesTotal)));
+}
+
+void MainWindow::finishCsvLoading(bool success, const QString &errorString)
+{
+    if(!loader){
+        return;
+    }
+    const bool canceled = loader->isCanceled();
+    const QString filePath = loader->filePath();
+    loader->deleteLater();
+    loader = nullptr;
+    ui->btnOpen->setText("Open File Data");
+
+    if(previewGraph){
+        plot->removeGraph(previewGraph);
+    }
+    if(success && followLoading){
+        plot->rescaleAxes();
+    }
+    followLoading = false;
+    plot->replot(QCustomPlot::rpQueuedReplot);
+
+    if(canceled){
+        ui->statusbar->showMessage("Loading canceled", 5000);
+    }
+    else if(!success){
+        ui->statusbar->clearMessage();
+        errorMessage("Could not read " + filePath + ": " + errorString);
+    }
+    else{
+        ui->statusbar->showMessage(QString("Loaded %1 points").arg(xData->size()), 5000);
+    }
+}
+
+// Once the user drags or zooms, newly loaded data no longer changes the axis ranges.
+void MainWindow::stopFollowingCsvLoading()
+{
+    followLoading = false;
 }
 
 
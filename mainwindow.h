@@ -6,8 +6,12 @@
 #include <QRandomGenerator>
 #include <QTimer>
 #include <QFont>
+#include <QPointer>
 #include "qcustomplot.h"
 
+class CsvLoader;
+class TraceGraphSource;
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class MainWindow;
@@ -73,6 +77,16 @@ private slots:
 
     void on_btnSavePlotAsPdf_clicked();
 
+    void showCsvPreview(const QVector<double> &keys, const QVector<double> &values);
+
+    void appendCsvChunk(const QVector<double> &keys, const QVector<double> &values, bool sorted);
+
+    void showCsvProgress(qint64 bytesRead, qint64 bytesTotal);
+
+    void finishCsvLoading(bool success, const QString &errorString);
+
+    void stopFollowingCsvLoading();
+
 private:
     Ui::MainWindow *ui;
     QCustomPlot *plot;
@@ -85,8 +99,14 @@ private:
     bool isGenerating = false;
     QTimer *timer;
     QCPSelectionRect *zoomRect;
+    CsvLoader *loader = nullptr;
+    QPointer<QCPGraph> previewGraph;
+    QPointer<TraceGraphSource> traceSource;
+    bool followLoading = false;
 
     void generateRandomData();
+    void openTraceFile(const QString &filePath);
+    bool exportCsv(const QString &filePath, QCPGraph *graph, const QCPDataSelection &rows, const QString &header);
     bool eventFilter(QObject *obj, QEvent *event);
     void errorMessage(QString text);
 };
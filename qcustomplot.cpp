@@ -1142,15 +1142,27 @@ void QCPLayer::setMode(QCPLayer::LayerMode mode)
 */
 void QCPLayer::draw(QCPPainter *painter)
 {
+  QCPReplotProfile *profile = mParentPlot->activeProfile();
   foreach (QCPLayerable *child, mChildren)
   {
     if (child->realVisibility())
     {
+      int profileEvent = -1;
+      if (profile)
+      {
+        QString name = QString::fromLatin1(child->metaObject()->className());
+        QCPAbstractPlottable *plottable = qobject_cast<QCPAbstractPlottable*>(child);
+        if (plottable && !plottable->name().isEmpty())
+          name += QLatin1Char(' ') + plottable->name();
+        profileEvent = profile->beginEvent(name, plottable ? QLatin1String("plottable") : QLatin1String("layerable"));
+      }
       painter->save();
       painter->setClipRect(child->clipRect().translated(0, -1));
       child->applyDefaultAntialiasingHint(painter);
       child->draw(painter);
       painter->restore();
+      if (profile)
+        profile->endEvent(profileEvent);
     }
   }
 }
@@ -1170,8 +1182,11 @@ void QCPLayer::drawToPaintBuffer()
     if (QCPPainter *painter = pb->startPainting())
     {
       if (painter->isActive())
+      {
+        if (mIndex == 0) // the viewport background pixmap is baked into the buffer of the lowest layer
+          mParentPlot->drawBackground(painter);
         draw(painter);
-      else
+      } else
         qDebug() << Q_FUNC_INFO << "paint buffer returned inactive painter";
       delete painter;
       pb->donePainting();
@@ -1396,6 +1411,8 @@ QCPLayerable::~QCPLayerable()
 */
 void QCPLayerable::setVisible(bool on)
 {
+  if (mVisible != on && mParentPlot) // visibility of axes and layout elements may change the layout
+    mParentPlot->invalidateLayout();
   mVisible = on;
 }
 
@@ -2412,14 +2429,16 @@ bool QCPDataRange::contains(const QCPDataRange &other) const
 /*!
   Creates an empty QCPDataSelection.
 */
-QCPDataSelection::QCPDataSelection()
+QCPDataSelection::QCPDataSelection() :
+  mSimplified(true)
 {
 }
 
 /*!
   Creates a QCPDataSelection containing the provided \a range.
 */
-QCPDataSelection::QCPDataSelection(const QCPDataRange &range)
+QCPDataSelection::QCPDataSelection(const QCPDataRange &range) :
+  mSimplified(!range.isEmpty())
 {
   mDataRanges.append(range);
 }
@@ -2449,8 +2468,17 @@ bool QCPDataSelection::operator==(const QCPDataSelection &other) const
 */
 QCPDataSelection &QCPDataSelection::operator+=(const QCPDataSelection &other)
 {
-  mDataRanges << other.mDataRanges;
-  simplify();
+  if (mSimplified && other.mDataRanges.size()*8 < mDataRanges.size())
+  {
+    // few ranges are added to a large selection, insert them individually:
+    for (int i=0; i<other.mDataRanges.size(); ++i)
+      addDataRange(other.mDataRanges.at(i));
+  } else
+  {
+    mDataRanges << other.mDataRanges;
+    mSimplified = false;
+    simplify();
+  }
   return *this;
 }
 
@@ -2477,6 +2505,9 @@ QCPDataSelection &QCPDataSelection::operator-=(const QCPDataSelection &other)
 
 /*!
   Removes all data point indices that are described by \a other from this data selection.
+  
+  The affected data ranges are found with a binary search, so the cost of this operation is
+  logarithmic in the number of data ranges (plus moving the ranges behind a modification).
 */
 QCPDataSelection &QCPDataSelection::operator-=(const QCPDataRange &other)
 {
@@ -2484,39 +2515,21 @@ QCPDataSelection &QCPDataSelection::operator-=(const QCPDataRange &other)
     return *this;
   
   simplify();
-  int i=0;
-  while (i < mDataRanges.size())
-  {
-    const int thisBegin = mDataRanges.at(i).begin();
-    const int thisEnd = mDataRanges.at(i).end();
-    if (thisBegin >= other.end())
-      break; // since data ranges are sorted after the simplify() call, no ranges which contain other will come after this
-    
-    if (thisEnd > other.begin()) // ranges which don't fulfill this are entirely before other and can be ignored
-    {
-      if (thisBegin >= other.begin()) // range leading segment is encompassed
-      {
-        if (thisEnd <= other.end()) // range fully encompassed, remove completely
-        {
-          mDataRanges.removeAt(i);
-          continue;
-        } else // only leading segment is encompassed, trim accordingly
-          mDataRanges[i].setBegin(other.end());
-      } else // leading segment is not encompassed
-      {
-        if (thisEnd <= other.end()) // only trailing segment is encompassed, trim accordingly
-        {
-          mDataRanges[i].setEnd(other.begin());
-        } else // other lies inside this range, so split range
-        {
-          mDataRanges[i].setEnd(other.begin());
-          mDataRanges.insert(i+1, QCPDataRange(other.end(), thisEnd));
-          break; // since data ranges are sorted (and don't overlap) after simplify() call, we're done here
-        }
-      }
-    }
-    ++i;
-  }
+  // ranges [first, last) overlap other:
+  const int first = int(std::lower_bound(mDataRanges.constBegin(), mDataRanges.constEnd(), other.begin(), dataRangeEndsAtOrBefore)-mDataRanges.constBegin());
+  const int last = int(std::lower_bound(mDataRanges.constBegin()+first, mDataRanges.constEnd(), other.end(), dataRangeBeginsBefore)-mDataRanges.constBegin());
+  if (first >= last)
+    return *this;
+  
+  // keep the parts of the outermost overlapping ranges that stick out of other:
+  QList<QCPDataRange> remaining;
+  if (mDataRanges.at(first).begin() < other.begin())
+    remaining.append(QCPDataRange(mDataRanges.at(first).begin(), other.begin()));
+  if (mDataRanges.at(last-1).end() > other.end())
+    remaining.append(QCPDataRange(other.end(), mDataRanges.at(last-1).end()));
+  mDataRanges.erase(mDataRanges.begin()+first, mDataRanges.begin()+last);
+  for (int i=0; i<remaining.size(); ++i)
+    mDataRanges.insert(first+i, remaining.at(i));
   
   return *this;
 }
@@ -2570,12 +2583,46 @@ QCPDataRange QCPDataSelection::span() const
   allows disabling immediate simplification by setting \a simplify to false. This can improve
   performance if adding a very large amount of data ranges successively. In this case, make sure to
   call \ref simplify manually, after the operation.
+  
+  If the selection is simplified, \a dataRange is merged into the sorted ranges in place: the ranges
+  it touches are found with a binary search, so adding a range costs logarithmic time in the number
+  of data ranges (plus moving the ranges behind the insertion point), instead of sorting all ranges.
 */
 void QCPDataSelection::addDataRange(const QCPDataRange &dataRange, bool simplify)
 {
-  mDataRanges.append(dataRange);
-  if (simplify)
-    this->simplify();
+  if (!mSimplified)
+  {
+    mDataRanges.append(dataRange);
+    if (simplify)
+      this->simplify();
+  } else if (dataRange.isEmpty())
+  {
+    // empty ranges are dropped by simplify, so only keep them if simplification is deferred:
+    if (!simplify)
+    {
+      mDataRanges.append(dataRange);
+      mSimplified = false;
+    }
+  } else if (!simplify)
+  {
+    // a range strictly behind all others keeps the selection simplified:
+    if (!mDataRanges.isEmpty() && dataRange.begin() <= mDataRanges.last().end())
+      mSimplified = false;
+    mDataRanges.append(dataRange);
+  } else
+  {
+    // ranges [first, last) overlap or touch dataRange and are joined with it:
+    const int first = int(std::lower_bound(mDataRanges.constBegin(), mDataRanges.constEnd(), dataRange.begin(), dataRangeEndsBefore)-mDataRanges.constBegin());
+    const int last = int(std::upper_bound(mDataRanges.constBegin()+first, mDataRanges.constEnd(), dataRange.end(), dataRangeBeginsAfter)-mDataRanges.constBegin());
+    if (first == last)
+    {
+      mDataRanges.insert(first, dataRange);
+    } else
+    {
+      mDataRanges[first] = QCPDataRange(qMin(dataRange.begin(), mDataRanges.at(first).begin()), qMax(dataRange.end(), mDataRanges.at(last-1).end()));
+      mDataRanges.erase(mDataRanges.begin()+first+1, mDataRanges.begin()+last);
+    }
+  }
 }
 
 /*!
@@ -2586,6 +2633,7 @@ void QCPDataSelection::addDataRange(const QCPDataRange &dataRange, bool simplify
 void QCPDataSelection::clear()
 {
   mDataRanges.clear();
+  mSimplified = true;
 }
 
 /*!
@@ -2599,29 +2647,34 @@ void QCPDataSelection::clear()
 */
 void QCPDataSelection::simplify()
 {
+  if (mSimplified)
+    return;
+  mSimplified = true;
+  
   // remove any empty ranges:
-  for (int i=mDataRanges.size()-1; i>=0; --i)
+  int count = 0;
+  for (int i=0; i<mDataRanges.size(); ++i)
   {
-    if (mDataRanges.at(i).isEmpty())
-      mDataRanges.removeAt(i);
+    if (!mDataRanges.at(i).isEmpty())
+      mDataRanges[count++] = mDataRanges.at(i);
   }
+  mDataRanges.erase(mDataRanges.begin()+count, mDataRanges.end());
   if (mDataRanges.isEmpty())
     return;
   
   // sort ranges by starting value, ascending:
   std::sort(mDataRanges.begin(), mDataRanges.end(), lessThanDataRangeBegin);
   
-  // join overlapping/contiguous ranges:
-  int i = 1;
-  while (i < mDataRanges.size())
+  // join overlapping/contiguous ranges, compacting the list in one pass:
+  count = 1;
+  for (int i=1; i<mDataRanges.size(); ++i)
   {
-    if (mDataRanges.at(i-1).end() >= mDataRanges.at(i).begin()) // range i overlaps/joins with i-1, so expand range i-1 appropriately and remove range i from list
-    {
-      mDataRanges[i-1].setEnd(qMax(mDataRanges.at(i-1).end(), mDataRanges.at(i).end()));
-      mDataRanges.removeAt(i);
-    } else
-      ++i;
+    if (mDataRanges.at(count-1).end() >= mDataRanges.at(i).begin()) // range i overlaps/joins with the previous one, so expand that one appropriately
+      mDataRanges[count-1].setEnd(qMax(mDataRanges.at(count-1).end(), mDataRanges.at(i).end()));
+    else
+      mDataRanges[count++] = mDataRanges.at(i);
   }
+  mDataRanges.erase(mDataRanges.begin()+count, mDataRanges.end());
 }
 
 /*!
@@ -2679,22 +2732,29 @@ void QCPDataSelection::enforceType(QCP::SelectionType type)
   Returns true if the data selection \a other is contained entirely in this data selection, i.e.
   all data point indices that are in \a other are also in this data selection.
   
+  The containing range of each range of \a other is found with a binary search.
+  
   \see QCPDataRange::contains
 */
 bool QCPDataSelection::contains(const QCPDataSelection &other) const
 {
   if (other.isEmpty()) return false;
+  if (!mSimplified)
+  {
+    QCPDataSelection simplified(*this);
+    simplified.simplify();
+    return simplified.contains(other);
+  }
   
-  int otherIndex = 0;
-  int thisIndex = 0;
-  while (thisIndex < mDataRanges.size() && otherIndex < other.mDataRanges.size())
+  for (int i=0; i<other.mDataRanges.size(); ++i)
   {
-    if (mDataRanges.at(thisIndex).contains(other.mDataRanges.at(otherIndex)))
-      ++otherIndex;
-    else
-      ++thisIndex;
+    const QCPDataRange &otherRange = other.mDataRanges.at(i);
+    // the only candidate is the last range beginning at or before otherRange:
+    const int candidate = int(std::upper_bound(mDataRanges.constBegin(), mDataRanges.constEnd(), otherRange.begin(), dataRangeBeginsAfter)-mDataRanges.constBegin())-1;
+    if (candidate < 0 || !mDataRanges.at(candidate).contains(otherRange))
+      return false;
   }
-  return thisIndex < mDataRanges.size(); // if thisIndex ran all the way to the end to find a containing range for the current otherIndex, other is not contained in this
+  return true;
 }
 
 /*!
@@ -2707,9 +2767,19 @@ bool QCPDataSelection::contains(const QCPDataSelection &other) const
 */
 QCPDataSelection QCPDataSelection::intersection(const QCPDataRange &other) const
 {
+  if (!mSimplified)
+  {
+    QCPDataSelection simplified(*this);
+    simplified.simplify();
+    return simplified.intersection(other);
+  }
+  
+  // only ranges [first, last) overlap other:
   QCPDataSelection result;
-  foreach (QCPDataRange dataRange, mDataRanges)
-    result.addDataRange(dataRange.intersection(other), false);
+  const int first = int(std::lower_bound(mDataRanges.constBegin(), mDataRanges.constEnd(), other.begin(), dataRangeEndsAtOrBefore)-mDataRanges.constBegin());
+  const int last = int(std::lower_bound(mDataRanges.constBegin()+first, mDataRanges.constEnd(), other.end(), dataRangeBeginsBefore)-mDataRanges.constBegin());
+  for (int i=first; i<last; ++i)
+    result.addDataRange(mDataRanges.at(i).intersection(other), false);
   result.simplify();
   return result;
 }
@@ -2722,7 +2792,11 @@ QCPDataSelection QCPDataSelection::intersection(const QCPDataSelection &other) c
 {
   QCPDataSelection result;
   for (int i=0; i<other.dataRangeCount(); ++i)
-    result += intersection(other.dataRange(i));
+  {
+    const QCPDataSelection part = intersection(other.dataRange(i));
+    for (int k=0; k<part.dataRangeCount(); ++k)
+      result.addDataRange(part.dataRange(k), false);
+  }
   result.simplify();
   return result;
 }
@@ -3243,6 +3317,8 @@ void QCPLayoutElement::setOuterRect(const QRect &rect)
   {
     mOuterRect = rect;
     mRect = mOuterRect.adjusted(mMargins.left(), mMargins.top(), -mMargins.right(), -mMargins.bottom());
+    if (mParentPlot)
+      mParentPlot->invalidateLayout();
   }
 }
 
@@ -3263,6 +3339,8 @@ void QCPLayoutElement::setMargins(const QMargins &margins)
   {
     mMargins = margins;
     mRect = mOuterRect.adjusted(mMargins.left(), mMargins.top(), -mMargins.right(), -mMargins.bottom());
+    if (mParentPlot)
+      mParentPlot->invalidateLayout();
   }
 }
 
@@ -3280,6 +3358,8 @@ void QCPLayoutElement::setMinimumMargins(const QMargins &margins)
   if (mMinimumMargins != margins)
   {
     mMinimumMargins = margins;
+    if (mParentPlot)
+      mParentPlot->invalidateLayout();
   }
 }
 
@@ -3296,6 +3376,8 @@ void QCPLayoutElement::setMinimumMargins(const QMargins &margins)
 void QCPLayoutElement::setAutoMargins(QCP::MarginSides sides)
 {
   mAutoMargins = sides;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -3419,6 +3501,8 @@ void QCPLayoutElement::setMarginGroup(QCP::MarginSides sides, QCPMarginGroup *gr
       }
     }
   }
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -3797,6 +3881,8 @@ void QCPLayout::sizeConstraintsChanged() const
     w->updateGeometry();
   else if (QCPLayout *l = qobject_cast<QCPLayout*>(parent()))
     l->sizeConstraintsChanged();
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*! \internal
@@ -3838,6 +3924,8 @@ void QCPLayout::adoptElement(QCPLayoutElement *el)
     if (!el->parentPlot())
       el->initializeParentPlot(mParentPlot);
     el->layoutChanged();
+    if (mParentPlot)
+      mParentPlot->invalidateLayout();
   } else
     qDebug() << Q_FUNC_INFO << "Null element passed";
 }
@@ -3860,6 +3948,8 @@ void QCPLayout::releaseElement(QCPLayoutElement *el)
     el->setParentLayerable(nullptr);
     el->setParent(mParentPlot);
     // Note: Don't initializeParentPlot(0) here, because layout element will stay in same parent plot
+    if (mParentPlot)
+      mParentPlot->invalidateLayout();
   } else
     qDebug() << Q_FUNC_INFO << "Null element passed";
 }
@@ -4248,6 +4338,8 @@ void QCPLayoutGrid::setColumnStretchFactor(int column, double factor)
       qDebug() << Q_FUNC_INFO << "Invalid stretch factor, must be positive:" << factor;
   } else
     qDebug() << Q_FUNC_INFO << "Invalid column:" << column;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -4277,6 +4369,8 @@ void QCPLayoutGrid::setColumnStretchFactors(const QList<double> &factors)
     }
   } else
     qDebug() << Q_FUNC_INFO << "Column count not equal to passed stretch factor count:" << factors;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -4301,6 +4395,8 @@ void QCPLayoutGrid::setRowStretchFactor(int row, double factor)
       qDebug() << Q_FUNC_INFO << "Invalid stretch factor, must be positive:" << factor;
   } else
     qDebug() << Q_FUNC_INFO << "Invalid row:" << row;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -4330,6 +4426,8 @@ void QCPLayoutGrid::setRowStretchFactors(const QList<double> &factors)
     }
   } else
     qDebug() << Q_FUNC_INFO << "Row count not equal to passed stretch factor count:" << factors;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -4340,6 +4438,8 @@ void QCPLayoutGrid::setRowStretchFactors(const QList<double> &factors)
 void QCPLayoutGrid::setColumnSpacing(int pixels)
 {
   mColumnSpacing = pixels;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -4350,6 +4450,8 @@ void QCPLayoutGrid::setColumnSpacing(int pixels)
 void QCPLayoutGrid::setRowSpacing(int pixels)
 {
   mRowSpacing = pixels;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -4455,6 +4557,8 @@ void QCPLayoutGrid::expandTo(int newRowCount, int newColumnCount)
   }
   while (mColumnStretchFactors.size() < newColCount)
     mColumnStretchFactors.append(1);
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -4481,6 +4585,8 @@ void QCPLayoutGrid::insertRow(int newIndex)
   for (int col=0; col<columnCount(); ++col)
     newRow.append(nullptr);
   mElements.insert(newIndex, newRow);
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -4506,6 +4612,8 @@ void QCPLayoutGrid::insertColumn(int newIndex)
   mColumnStretchFactors.insert(newIndex, 1);
   for (int row=0; row<rowCount(); ++row)
     mElements[row].insert(newIndex, nullptr);
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -4742,6 +4850,8 @@ void QCPLayoutGrid::simplify()
         mElements[row].removeAt(col);
     }
   }
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /* inherits documentation from base class */
@@ -4954,6 +5064,8 @@ void QCPLayoutInset::setInsetPlacement(int index, QCPLayoutInset::InsetPlacement
     mInsetPlacement[index] = placement;
   else
     qDebug() << Q_FUNC_INFO << "Invalid element index:" << index;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -4970,6 +5082,8 @@ void QCPLayoutInset::setInsetAlignment(int index, Qt::Alignment alignment)
     mInsetAlignment[index] = alignment;
   else
     qDebug() << Q_FUNC_INFO << "Invalid element index:" << index;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -4989,6 +5103,8 @@ void QCPLayoutInset::setInsetRect(int index, const QRectF &rect)
     mInsetRect[index] = rect;
   else
     qDebug() << Q_FUNC_INFO << "Invalid element index:" << index;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /* inherits documentation from base class */
@@ -5458,6 +5574,201 @@ void QCPLineEnding::draw(QCPPainter *painter, const QCPVector2D &pos, double ang
 /* modified 2022-11-06T12:45:56, size 27519   */
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPLabelCachePrivate
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPLabelCachePrivate
+
+  \internal
+  \brief (Private)
+  
+  This is a private class and not part of the public QCustomPlot interface.
+  
+  Each QCustomPlot owns one instance of this class. It holds the rendered tick label pixmaps of all
+  axes (QCPAxisPainterPrivate) and polar axes (QCPLabelPainterPrivate) of the plot, so labels with
+  identical text and appearance are only shaped and rasterized once, even if they appear on many
+  axes (e.g. linked subplots).
+  
+  The label painters build the cache keys themselves. A key must contain everything that
+  influences the label pixmap, i.e. the text, font, color, rotation and number formatting options.
+  That way, changing the appearance of one axis doesn't invalidate the labels of other axes, and
+  switching back and forth between appearances reuses the previously rendered labels. The cache is
+  flushed completely when the buffer device pixel ratio of the plot changes (\ref
+  QCustomPlot::setBufferDevicePixelRatio).
+  
+  Least recently used labels are evicted once the pixmap memory exceeds \ref setMaximumMemory.
+  
+  Additionally, for labels that are drawn without pixmap caching (e.g. vectorized export or when
+  \ref QCP::phCacheLabels is disabled), the shaped glyph runs of texts are cached and reused by
+  \ref drawText, so the text layout doesn't need to be redone on every replot.
+*/
+
+/*!
+  Constructs the label cache with a default pixmap memory limit of 4 MB and room for 8192 shaped
+  glyphs.
+*/
+QCPLabelCachePrivate::QCPLabelCachePrivate() :
+  mLabels(4096)
+#if QT_VERSION >= QT_VERSION_CHECK(4, 8, 0)
+  , mShapedTexts(8192)
+#endif
+{
+}
+
+QCPLabelCachePrivate::~QCPLabelCachePrivate()
+{
+}
+
+/*!
+  Sets the maximum memory in \a kilobytes that the cached label pixmaps may occupy. If the limit is
+  exceeded, the least recently used labels are removed from the cache.
+*/
+void QCPLabelCachePrivate::setMaximumMemory(int kilobytes)
+{
+  mLabels.setMaxCost(qMax(0, kilobytes));
+}
+
+/*!
+  Sets the maximum number of glyphs that are held in the shaped text cache used by \ref drawText.
+*/
+void QCPLabelCachePrivate::setMaximumGlyphs(int glyphCount)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(4, 8, 0)
+  mShapedTexts.setMaxCost(qMax(0, glyphCount));
+#else
+  Q_UNUSED(glyphCount)
+#endif
+}
+
+int QCPLabelCachePrivate::maximumMemory() const
+{
+  return int(mLabels.maxCost());
+}
+
+int QCPLabelCachePrivate::maximumGlyphs() const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(4, 8, 0)
+  return int(mShapedTexts.maxCost());
+#else
+  return 0;
+#endif
+}
+
+/*!
+  Returns the memory in kilobytes currently occupied by cached label pixmaps.
+*/
+int QCPLabelCachePrivate::usedMemory() const
+{
+  return int(mLabels.totalCost());
+}
+
+/*!
+  Looks up the label with the given \a key. If it exists, it is copied to \a label (the pixmap is
+  implicitly shared, so this is cheap), marked as recently used and true is returned. Otherwise
+  returns false and leaves \a label untouched.
+*/
+bool QCPLabelCachePrivate::findLabel(const QByteArray &key, CachedLabel *label)
+{
+  if (const CachedLabel *cachedLabel = mLabels.object(key))
+  {
+    *label = *cachedLabel;
+    return true;
+  }
+  return false;
+}
+
+/*!
+  Inserts a copy of \a label into the cache with the given \a key. The cost of the entry is the
+  memory of its pixmap. If the pixmap alone exceeds \ref maximumMemory, the label isn't cached.
+*/
+void QCPLabelCachePrivate::insertLabel(const QByteArray &key, const CachedLabel &label)
+{
+  const qint64 bytes = qint64(label.pixmap.width())*qint64(label.pixmap.height())*qMax(1, label.pixmap.depth()/8);
+  mLabels.insert(key, new CachedLabel(label), int(qMax(qint64(1), bytes/1024)));
+}
+
+/*!
+  Draws the single-line \a text with the current font and pen of \a painter into \a rect, like
+  QPainter::drawText(const QRectF &, int, const QString &) would. Supported \a flags are the
+  horizontal alignment flags, the text is always aligned to the top of \a rect and not clipped.
+  
+  The glyph runs of the shaped text are cached per font and paint device resolution, so repeatedly
+  drawing the same text (e.g. tick labels on every replot of a vectorized export) skips the text
+  layout step. Texts containing line breaks are passed to QPainter::drawText directly.
+*/
+void QCPLabelCachePrivate::drawText(QCPPainter *painter, const QRectF &rect, int flags, const QString &text)
+{
+  if (text.isEmpty())
+    return;
+#if QT_VERSION >= QT_VERSION_CHECK(4, 8, 0)
+  if (text.contains(QLatin1Char('\n')))
+  {
+    painter->drawText(rect, flags, text);
+    return;
+  }
+  
+  QPaintDevice *device = painter->device();
+  const QFont font = painter->font();
+  QByteArray key = font.key().toUtf8();
+  key += QByteArray::number(device ? device->logicalDpiX() : 0)+'x'+QByteArray::number(device ? device->logicalDpiY() : 0)+'|';
+  key += text.toUtf8();
+  
+  if (const ShapedText *shapedText = mShapedTexts.object(key))
+  {
+    drawGlyphRuns(painter, rect, flags, shapedText->glyphRuns, shapedText->width);
+    return;
+  }
+  
+  // text not cached yet, shape it and insert the resulting glyph runs into the cache:
+  ShapedText shapedText;
+  QTextLayout layout(text, font, device);
+  layout.beginLayout();
+  QTextLine line = layout.createLine();
+  layout.endLayout();
+  shapedText.width = line.isValid() ? line.naturalTextWidth() : 0;
+  shapedText.glyphRuns = layout.glyphRuns();
+  int glyphCount = 0;
+  foreach (const QGlyphRun &run, shapedText.glyphRuns)
+    glyphCount += int(run.glyphIndexes().size());
+  drawGlyphRuns(painter, rect, flags, shapedText.glyphRuns, shapedText.width);
+  mShapedTexts.insert(key, new ShapedText(shapedText), qMax(1, glyphCount));
+#else
+  painter->drawText(rect, flags, text);
+#endif
+}
+
+/*!
+  Removes all labels and shaped texts from the cache.
+*/
+void QCPLabelCachePrivate::clear()
+{
+  mLabels.clear();
+#if QT_VERSION >= QT_VERSION_CHECK(4, 8, 0)
+  mShapedTexts.clear();
+#endif
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(4, 8, 0)
+/*! \internal
+  
+  Draws the pre-shaped \a glyphRuns with \a painter, horizontally aligned inside \a rect according
+  to \a flags. \a width is the natural width of the shaped text. This is a \ref drawText helper
+  function.
+*/
+void QCPLabelCachePrivate::drawGlyphRuns(QCPPainter *painter, const QRectF &rect, int flags, const QList<QGlyphRun> &glyphRuns, double width) const
+{
+  QPointF origin = rect.topLeft();
+  if (flags & Qt::AlignHCenter)
+    origin.rx() += (rect.width()-width)*0.5;
+  else if (flags & Qt::AlignRight)
+    origin.rx() += rect.width()-width;
+  foreach (const QGlyphRun &run, glyphRuns)
+    painter->drawGlyphRun(origin, run);
+}
+#endif
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPLabelPainterPrivate
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -5491,8 +5802,7 @@ QCPLabelPainterPrivate::QCPLabelPainterPrivate(QCustomPlot *parentPlot) :
   mSubstituteExponent(true),
   mMultiplicationSymbol(QChar(215)),
   mAbbreviateDecimalPowers(false),
-  mParentPlot(parentPlot),
-  mLabelCache(16)
+  mParentPlot(parentPlot)
 {
   analyzeFontMetrics();
 }
@@ -5527,6 +5837,7 @@ void QCPLabelPainterPrivate::setFont(const QFont &font)
   {
     mFont = font;
     analyzeFontMetrics();
+    mLabelParameterHash.clear();
   }
 }
 
@@ -5548,26 +5859,19 @@ void QCPLabelPainterPrivate::setRotation(double rotation)
 void QCPLabelPainterPrivate::setSubstituteExponent(bool enabled)
 {
   mSubstituteExponent = enabled;
+  mLabelParameterHash.clear();
 }
 
 void QCPLabelPainterPrivate::setMultiplicationSymbol(QChar symbol)
 {
   mMultiplicationSymbol = symbol;
+  mLabelParameterHash.clear();
 }
 
 void QCPLabelPainterPrivate::setAbbreviateDecimalPowers(bool enabled)
 {
   mAbbreviateDecimalPowers = enabled;
-}
-
-void QCPLabelPainterPrivate::setCacheSize(int labelCount)
-{
-  mLabelCache.setMaxCost(labelCount);
-}
-
-int QCPLabelPainterPrivate::cacheSize() const
-{
-  return mLabelCache.maxCost();
+  mLabelParameterHash.clear();
 }
 
 void QCPLabelPainterPrivate::drawTickLabel(QCPPainter *painter, const QPointF &tickPos, const QString &text)
@@ -5632,32 +5936,36 @@ int QCPLabelPainterPrivate::size() const
 
 /*! \internal
   
-  Clears the internal label cache. Upon the next \ref draw, all labels will be created new. This
-  method is called automatically if any parameters have changed that invalidate the cached labels,
-  such as font, color, etc. Usually you won't need to call this method manually.
+  Clears the label parameter hash, so it is regenerated upon the next drawn label. Labels of this
+  painter that are held in the plot-wide label cache are not removed, but are no longer used if
+  the parameters have changed (they are evicted by the cache eventually). The setters call this
+  automatically when a cache-invalidating parameter changes, so usually you won't need to call this
+  method manually.
 */
 void QCPLabelPainterPrivate::clearCache()
 {
-  mLabelCache.clear();
+  mLabelParameterHash.clear();
 }
 
 /*! \internal
   
-  Returns a hash that allows uniquely identifying whether the label parameters have changed such
-  that the cached labels must be refreshed (\ref clearCache). It is used in \ref draw. If the
-  return value of this method hasn't changed since the last redraw, the respective label parameters
-  haven't changed and cached labels may be used.
+  Returns a hash of all label parameters that are uniform for the labels of this painter and
+  influence the label pixmaps. It is used as prefix of the keys in the plot-wide label cache (see
+  \ref cacheKey), so labels drawn with different parameters don't collide in the cache, while labels
+  of other painters with identical parameters can be shared.
+  
+  Parameters that may vary from label to label (color, rotation and anchor side) are part of the
+  per-label key instead. The buffer device pixel ratio isn't part of the hash, because the label
+  cache is flushed when it changes.
 */
 QByteArray QCPLabelPainterPrivate::generateLabelParameterHash() const
 {
-  QByteArray result;
-  result.append(QByteArray::number(mParentPlot->bufferDevicePixelRatio()));
-  result.append(QByteArray::number(mRotation));
-  //result.append(QByteArray::number(int(tickLabelSide))); TODO: check whether this is really a cache-invalidating property
+  QByteArray result("L");
   result.append(QByteArray::number(int(mSubstituteExponent)));
+  result.append(QByteArray::number(int(mAbbreviateDecimalPowers)));
   result.append(QString(mMultiplicationSymbol).toUtf8());
-  result.append(mColor.name().toLatin1()+QByteArray::number(mColor.alpha(), 16));
   result.append(mFont.toString().toLatin1());
+  result.append('|');
   return result;
 }
 
@@ -5688,12 +5996,15 @@ void QCPLabelPainterPrivate::drawLabelMaybeCached(QCPPainter *painter, const QFo
 
   if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && !painter->modes().testFlag(QCPPainter::pmNoCaching)) // label caching enabled
   {
-    QByteArray key = cacheKey(text, color, rotation, side);
-    CachedLabel *cachedLabel = mLabelCache.take(QString::fromUtf8(key)); // attempt to take label from cache (don't use object() because we want ownership/prevent deletion during our operations, we re-insert it afterwards)
-    if (!cachedLabel)  // no cached label existed, create it
+    if (mLabelParameterHash.isEmpty()) // parameters changed since last label, regenerate key prefix
+      mLabelParameterHash = generateLabelParameterHash();
+    const QByteArray key = cacheKey(text, color, rotation, side);
+    QCPLabelCachePrivate::CachedLabel cachedLabel;
+    if (!mParentPlot->mLabelCache->findLabel(key, &cachedLabel))  // no cached label existed, create it
     {
       LabelData labelData = getTickLabelData(font, color, rotation, side, text);
       cachedLabel = createCachedLabel(labelData);
+      mParentPlot->mLabelCache->insertLabel(key, cachedLabel);
     }
     // if label would be partly clipped by widget border on sides, don't draw it (only for outside tick labels):
     bool labelClippedByBorder = false;
@@ -5708,10 +6019,10 @@ void QCPLabelPainterPrivate::drawLabelMaybeCached(QCPPainter *painter, const QFo
     */
     if (!labelClippedByBorder)
     {
-      painter->drawPixmap(pos+cachedLabel->offset, cachedLabel->pixmap);
-      finalSize = cachedLabel->pixmap.size()/mParentPlot->bufferDevicePixelRatio(); // TODO: collect this in a member rect list?
+      // offset is between label anchor and topleft of cache pixmap, so pixmap can be drawn at pos+offset to make the label anchor appear at pos:
+      painter->drawPixmap(pos+cachedLabel.rotatedTotalBounds.topLeft(), cachedLabel.pixmap);
+      finalSize = cachedLabel.pixmap.size()/mParentPlot->bufferDevicePixelRatio(); // TODO: collect this in a member rect list?
     }
-    mLabelCache.insert(QString::fromUtf8(key), cachedLabel);
   } else // label caching disabled, draw text directly on surface:
   {
     LabelData labelData = getTickLabelData(font, color, rotation, side, text);
@@ -5799,16 +6110,17 @@ void QCPLabelPainterPrivate::drawText(QCPPainter *painter, const QPointF &pos, c
   // draw text:
   painter->setFont(labelData.baseFont);
   painter->setPen(QPen(labelData.color));
+  QCPLabelCachePrivate *labelCache = mParentPlot->mLabelCache;
   if (!labelData.expPart.isEmpty()) // use superscripted exponent typesetting
   {
-    painter->drawText(0, 0, 0, 0, Qt::TextDontClip, labelData.basePart);
+    labelCache->drawText(painter, QRectF(0, 0, 0, 0), Qt::TextDontClip, labelData.basePart);
     if (!labelData.suffixPart.isEmpty())
-      painter->drawText(labelData.baseBounds.width()+1+labelData.expBounds.width(), 0, 0, 0, Qt::TextDontClip, labelData.suffixPart);
+      labelCache->drawText(painter, QRectF(labelData.baseBounds.width()+1+labelData.expBounds.width(), 0, 0, 0), Qt::TextDontClip, labelData.suffixPart);
     painter->setFont(labelData.expFont);
-    painter->drawText(labelData.baseBounds.width()+1, 0, labelData.expBounds.width(), labelData.expBounds.height(), Qt::TextDontClip,  labelData.expPart);
+    labelCache->drawText(painter, QRectF(labelData.baseBounds.width()+1, 0, labelData.expBounds.width(), labelData.expBounds.height()), Qt::TextDontClip,  labelData.expPart);
   } else
   {
-    painter->drawText(0, 0, labelData.totalBounds.width(), labelData.totalBounds.height(), Qt::TextDontClip | Qt::AlignHCenter, labelData.basePart);
+    labelCache->drawText(painter, QRectF(0, 0, labelData.totalBounds.width(), labelData.totalBounds.height()), Qt::TextDontClip | Qt::AlignHCenter, labelData.basePart);
   }
   
   /* Debug code to draw label bounding boxes, baseline, and capheight
@@ -5957,37 +6269,43 @@ void QCPLabelPainterPrivate::getMaxTickLabelSize(const QFont &font, const QStrin
 }
 */
 
-QCPLabelPainterPrivate::CachedLabel *QCPLabelPainterPrivate::createCachedLabel(const LabelData &labelData) const
+QCPLabelCachePrivate::CachedLabel QCPLabelPainterPrivate::createCachedLabel(const LabelData &labelData) const
 {
-  CachedLabel *result = new CachedLabel;
+  QCPLabelCachePrivate::CachedLabel result;
+  result.totalBounds = labelData.totalBounds;
+  result.rotatedTotalBounds = labelData.rotatedTotalBounds;
   
   // allocate pixmap with the correct size and pixel ratio:
   if (!qFuzzyCompare(1.0, mParentPlot->bufferDevicePixelRatio()))
   {
-    result->pixmap = QPixmap(labelData.rotatedTotalBounds.size()*mParentPlot->bufferDevicePixelRatio());
+    result.pixmap = QPixmap(labelData.rotatedTotalBounds.size()*mParentPlot->bufferDevicePixelRatio());
 #ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
 #  ifdef QCP_DEVICEPIXELRATIO_FLOAT
-    result->pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatioF());
+    result.pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatioF());
 #  else
-    result->pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatio());
+    result.pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatio());
 #  endif
 #endif
   } else
-    result->pixmap = QPixmap(labelData.rotatedTotalBounds.size());
-  result->pixmap.fill(Qt::transparent);
+    result.pixmap = QPixmap(labelData.rotatedTotalBounds.size());
+  result.pixmap.fill(Qt::transparent);
   
   // draw the label into the pixmap
-  // offset is between label anchor and topleft of cache pixmap, so pixmap can be drawn at pos+offset to make the label anchor appear at pos.
   // We use rotatedTotalBounds.topLeft() because rotatedTotalBounds is in a coordinate system where the label anchor is at (0, 0)
-  result->offset = labelData.rotatedTotalBounds.topLeft();
-  QCPPainter cachePainter(&result->pixmap);
-  drawText(&cachePainter, -result->offset, labelData);
+  QCPPainter cachePainter(&result.pixmap);
+  drawText(&cachePainter, -labelData.rotatedTotalBounds.topLeft(), labelData);
   return result;
 }
 
+/*! \internal
+  
+  Returns the key of the label with the given \a text, \a color, \a rotation and anchor \a side in
+  the plot-wide label cache. The key is prefixed with the current label parameter hash (see \ref
+  generateLabelParameterHash).
+*/
 QByteArray QCPLabelPainterPrivate::cacheKey(const QString &text, const QColor &color, double rotation, AnchorSide side) const
 {
-  return text.toUtf8()+
+  return mLabelParameterHash+text.toUtf8()+'|'+
       QByteArray::number(color.red()+256*color.green()+65536*color.blue(), 36)+
       QByteArray::number(color.alpha()+256*int(side), 36)+
       QByteArray::number(int(rotation*100), 36);
@@ -6114,6 +6432,12 @@ void QCPLabelPainterPrivate::analyzeFontMetrics()
   
   See the documentation of all these virtual methods in QCPAxisTicker for detailed information
   about the parameters and expected return values.
+  
+  Note that \ref generate memoizes the tick step as long as the range size stays the same, and
+  reuses the labels of ticks that were already generated in the previous call. So \ref getTickStep
+  should only depend on the size of the passed range, and \ref getTickLabel only on the tick
+  coordinate and the ticker properties. If your subclass has own properties that influence tick
+  steps or labels, call \ref invalidateCache in their setters.
 */
 
 /*!
@@ -6123,7 +6447,17 @@ void QCPLabelPainterPrivate::analyzeFontMetrics()
 QCPAxisTicker::QCPAxisTicker() :
   mTickStepStrategy(tssReadability),
   mTickCount(5),
-  mTickOrigin(0)
+  mTickOrigin(0),
+  mFastLabelFormatting(true),
+  mTickStepCacheValid(false),
+  mLabelCacheValid(false),
+  mCachedRangeSize(0),
+  mCachedTickStep(0),
+  mCachedLabelTickStep(0),
+  mCachedPrecision(0),
+  mFastFormatLocaleChecked(false),
+  mFastFormatDigits(false),
+  mFastFormatNumbers(false)
 {
 }
 
@@ -6139,6 +6473,7 @@ QCPAxisTicker::~QCPAxisTicker()
 void QCPAxisTicker::setTickStepStrategy(QCPAxisTicker::TickStepStrategy strategy)
 {
   mTickStepStrategy = strategy;
+  invalidateCache();
 }
 
 /*!
@@ -6152,8 +6487,10 @@ void QCPAxisTicker::setTickStepStrategy(QCPAxisTicker::TickStepStrategy strategy
 void QCPAxisTicker::setTickCount(int count)
 {
   if (count > 0)
+  {
     mTickCount = count;
-  else
+    invalidateCache();
+  } else
     qDebug() << Q_FUNC_INFO << "tick count must be greater than zero:" << count;
 }
 
@@ -6170,6 +6507,29 @@ void QCPAxisTicker::setTickOrigin(double origin)
   mTickOrigin = origin;
 }
 
+/*!
+  Sets whether tick labels may be generated by a fast formatter instead of QLocale::toString and
+  QDateTime::toString.
+  
+  The fast formatter writes numbers with \c std::to_chars and breaks down date/time coordinates
+  arithmetically, with the time zone offset cached per day. It is only used where it produces the
+  same result as QLocale, i.e. for locales with plain ASCII digits, a '.' decimal point, no group
+  separators, and (for QCPAxisTickerDateTime) formats that only consist of numeric fields. In all
+  other cases, and if the compiler's standard library doesn't provide floating point \c
+  std::to_chars, the labels are generated by QLocale as before.
+  
+  Set \a enabled to false if the labels must follow exact locale rules in every case, e.g. when
+  a reimplementation of QLocale behaviour is relied upon. The default is true.
+*/
+void QCPAxisTicker::setFastLabelFormatting(bool enabled)
+{
+  if (mFastLabelFormatting != enabled)
+  {
+    mFastLabelFormatting = enabled;
+    invalidateCache();
+  }
+}
+
 /*!
   This is the method called by QCPAxis in order to actually generate tick coordinates (\a ticks),
   tick label strings (\a tickLabels) and sub tick coordinates (\a subTicks).
@@ -6182,11 +6542,22 @@ void QCPAxisTicker::setTickOrigin(double origin)
   The output parameters \a subTicks and \a tickLabels are optional (set them to \c nullptr if not
   needed) and are respectively filled with sub tick coordinates, and tick label strings belonging
   to \a ticks by index.
+  
+  Since panning an axis only shifts the range without changing its size, the tick step and the
+  labels of ticks that stay visible are memoized from the previous call and reused, so only the
+  labels of ticks entering the range need to be generated (see \ref createLabelVectorCached).
 */
 void QCPAxisTicker::generate(const QCPRange &range, const QLocale &locale, QChar formatChar, int precision, QVector<double> &ticks, QVector<double> *subTicks, QVector<QString> *tickLabels)
 {
-  // generate (major) ticks:
-  double tickStep = getTickStep(range);
+  // generate (major) ticks, reusing the tick step if the range size didn't change (e.g. when panning):
+  const double rangeSize = range.size();
+  if (!mTickStepCacheValid || qAbs(rangeSize-mCachedRangeSize) > qAbs(mCachedRangeSize)*1e-12)
+  {
+    mCachedTickStep = getTickStep(range);
+    mCachedRangeSize = rangeSize;
+    mTickStepCacheValid = true;
+  }
+  const double tickStep = mCachedTickStep;
   ticks = createTickVector(tickStep, range);
   trimTicks(range, ticks, true); // trim ticks to visible range plus one outer tick on each side (incase a subclass createTickVector creates more)
   
@@ -6205,7 +6576,7 @@ void QCPAxisTicker::generate(const QCPRange &range, const QLocale &locale, QChar
   trimTicks(range, ticks, false);
   // generate labels for visible ticks if requested:
   if (tickLabels)
-    *tickLabels = createLabelVector(ticks, locale, formatChar, precision);
+    *tickLabels = createLabelVectorCached(tickStep, ticks, locale, formatChar, precision);
 }
 
 /*! \internal
@@ -6296,7 +6667,7 @@ int QCPAxisTicker::getSubTickCount(double tickStep)
 */
 QString QCPAxisTicker::getTickLabel(double tick, const QLocale &locale, QChar formatChar, int precision)
 {
-  return locale.toString(tick, formatChar.toLatin1(), precision);
+  return formatNumber(tick, locale, formatChar, precision);
 }
 
 /*! \internal
@@ -6474,6 +6845,143 @@ double QCPAxisTicker::cleanMantissa(double input) const
   }
   return input;
 }
+
+/*! \internal
+  
+  Discards the memoized tick step and tick labels of the previous \ref generate call, so the next
+  call regenerates them from scratch.
+  
+  This must be called whenever a property changes that influences the result of \ref getTickStep
+  or \ref getTickLabel. The setters of QCPAxisTicker and its built-in subclasses already do this.
+  Subclasses that introduce own properties affecting tick steps or labels must call this method
+  in the respective setters, too.
+*/
+void QCPAxisTicker::invalidateCache()
+{
+  mTickStepCacheValid = false;
+  mLabelCacheValid = false;
+  mCachedTicks.clear();
+  mCachedTickLabels.clear();
+}
+
+/*! \internal
+  
+  Returns the tick label strings for \a ticks, like \ref createLabelVector. Labels of ticks that
+  were already present in the previous call are taken over, and only the remaining ticks are passed
+  to \ref createLabelVector. This is what makes panning cheap: typically only one or two ticks
+  enter the visible range per replot.
+  
+  Labels are only reused if \a tickStep, \a locale, \a formatChar and \a precision are the same as
+  in the previous call, since some tickers (e.g. QCPAxisTickerPi) format labels depending on the
+  tick step. Both \a ticks and the memoized ticks are sorted ascendingly, so matching them is a
+  single linear merge.
+*/
+QVector<QString> QCPAxisTicker::createLabelVectorCached(double tickStep, const QVector<double> &ticks, const QLocale &locale, QChar formatChar, int precision)
+{
+  QVector<QString> result;
+  if (mLabelCacheValid && tickStep == mCachedLabelTickStep && formatChar == mCachedFormatChar && precision == mCachedPrecision && locale == mCachedLocale)
+  {
+    // find ticks that don't have a memoized label yet:
+    QVector<double> newTicks;
+    QVector<int> newTickIndices;
+    result.resize(ticks.size());
+    int cacheIndex = 0;
+    for (int i=0; i<ticks.size(); ++i)
+    {
+      const double tick = ticks.at(i);
+      while (cacheIndex < mCachedTicks.size() && mCachedTicks.at(cacheIndex) < tick)
+        ++cacheIndex;
+      if (cacheIndex < mCachedTicks.size() && mCachedTicks.at(cacheIndex) == tick)
+        result[i] = mCachedTickLabels.at(cacheIndex);
+      else
+      {
+        newTicks.append(tick);
+        newTickIndices.append(i);
+      }
+    }
+    if (!newTicks.isEmpty())
+    {
+      const QVector<QString> newLabels = createLabelVector(newTicks, locale, formatChar, precision);
+      for (int i=0; i<newTickIndices.size() && i<newLabels.size(); ++i)
+        result[newTickIndices.at(i)] = newLabels.at(i);
+    }
+  } else
+  {
+    result = createLabelVector(ticks, locale, formatChar, precision);
+    mCachedLabelTickStep = tickStep;
+    mCachedLocale = locale;
+    mCachedFormatChar = formatChar;
+    mCachedPrecision = precision;
+  }
+  
+  if (result.size() == ticks.size())
+  {
+    mCachedTicks = ticks;
+    mCachedTickLabels = result;
+    mLabelCacheValid = true;
+  } else // createLabelVector reimplementation doesn't map labels to ticks by index, don't memoize
+    mLabelCacheValid = false;
+  return result;
+}
+
+/*! \internal
+  
+  Returns whether the fast label formatter may be used for \a locale (see \ref
+  setFastLabelFormatting). If \a numbers is false, only the digits are checked, which is
+  sufficient for numeric date/time fields. Otherwise also the decimal point, signs, exponential
+  character and number options must match the "C" locale.
+  
+  The result is remembered for the last passed locale, since it's the same for all ticks.
+*/
+bool QCPAxisTicker::canFormatFast(const QLocale &locale, bool numbers)
+{
+  if (!mFastLabelFormatting)
+    return false;
+  if (!mFastFormatLocaleChecked || locale != mFastFormatLocale)
+  {
+    mFastFormatLocale = locale;
+    mFastFormatLocaleChecked = true;
+    mFastFormatDigits = QString(locale.zeroDigit()) == QLatin1String("0");
+    mFastFormatNumbers = mFastFormatDigits &&
+        QString(locale.decimalPoint()) == QLatin1String(".") &&
+        QString(locale.negativeSign()) == QLatin1String("-") &&
+        QString(locale.positiveSign()) == QLatin1String("+") &&
+        QString(locale.exponential()) == QLatin1String("e") &&
+        locale.numberOptions() == QLocale::NumberOptions(QLocale::OmitGroupSeparator);
+  }
+  return numbers ? mFastFormatNumbers : mFastFormatDigits;
+}
+
+/*! \internal
+  
+  Returns \a value formatted like QLocale::toString with the given \a formatChar ('f', 'e' or
+  'g') and \a precision.
+  
+  If possible (see \ref setFastLabelFormatting), the string is generated with \c std::to_chars
+  into a stack buffer, which produces the same result as QLocale for the supported locales without
+  any intermediate allocations. Otherwise this falls back to QLocale::toString.
+*/
+QString QCPAxisTicker::formatNumber(double value, const QLocale &locale, QChar formatChar, int precision)
+{
+#ifdef QCP_TO_CHARS_SUPPORTED
+  if (precision >= 0 && precision <= 64 && qIsFinite(value) && canFormatFast(locale, true))
+  {
+    std::chars_format format;
+    switch (formatChar.toLatin1())
+    {
+      case 'f': format = std::chars_format::fixed; break;
+      case 'e': format = std::chars_format::scientific; break;
+      case 'g': format = std::chars_format::general; break;
+      default: return locale.toString(value, formatChar.toLatin1(), precision);
+    }
+    char buffer[400]; // fixed notation of the largest doubles needs 309 integer digits plus precision
+    const std::to_chars_result result = std::to_chars(buffer, buffer+sizeof(buffer), value, format, precision);
+    if (result.ec == std::errc())
+      return QString::fromLatin1(buffer, int(result.ptr-buffer));
+  }
+#endif
+  return locale.toString(value, formatChar.toLatin1(), precision);
+}
 /* end of 'src/axis/axisticker.cpp' */
 
 
@@ -6527,9 +7035,11 @@ double QCPAxisTicker::cleanMantissa(double input) const
 QCPAxisTickerDateTime::QCPAxisTickerDateTime() :
   mDateTimeFormat(QLatin1String("hh:mm:ss\ndd.MM.yy")),
   mDateTimeSpec(Qt::LocalTime),
-  mDateStrategy(dsNone)
+  mDateStrategy(dsNone),
+  mFormatTokensValid(false)
 {
   setTickCount(4);
+  parseDateTimeFormat();
 }
 
 /*!
@@ -6572,6 +7082,8 @@ QCPAxisTickerDateTime::QCPAxisTickerDateTime() :
 void QCPAxisTickerDateTime::setDateTimeFormat(const QString &format)
 {
   mDateTimeFormat = format;
+  parseDateTimeFormat();
+  invalidateCache();
 }
 
 /*!
@@ -6590,6 +7102,8 @@ void QCPAxisTickerDateTime::setDateTimeFormat(const QString &format)
 void QCPAxisTickerDateTime::setDateTimeSpec(Qt::TimeSpec spec)
 {
   mDateTimeSpec = spec;
+  mUtcOffsetCache.clear();
+  invalidateCache();
 }
 
 # if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
@@ -6603,6 +7117,8 @@ void QCPAxisTickerDateTime::setTimeZone(const QTimeZone &zone)
 {
   mTimeZone = zone;
   mDateTimeSpec = Qt::TimeZone;
+  mUtcOffsetCache.clear();
+  invalidateCache();
 }
 #endif
 
@@ -6713,12 +7229,18 @@ int QCPAxisTickerDateTime::getSubTickCount(double tickStep)
   (\ref setDateTimeFormat), time spec (\ref setDateTimeSpec), and possibly time zone (\ref
   setTimeZone).
   
+  If the format only consists of numeric fields, the label is generated by \ref
+  formatDateTimeFast instead of going through QDateTime (see \ref setFastLabelFormatting).
+  
   \seebaseclassmethod
 */
 QString QCPAxisTickerDateTime::getTickLabel(double tick, const QLocale &locale, QChar formatChar, int precision)
 {
   Q_UNUSED(precision)
   Q_UNUSED(formatChar)
+  QString result;
+  if (canFormatFast(locale, false) && formatDateTimeFast(tick, result))
+    return result;
 # if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
   if (mDateTimeSpec == Qt::TimeZone)
     return locale.toString(keyToDateTime(tick).toTimeZone(mTimeZone), mDateTimeFormat);
@@ -6729,6 +7251,225 @@ QString QCPAxisTickerDateTime::getTickLabel(double tick, const QLocale &locale,
 # endif
 }
 
+/*! \internal
+  
+  Splits the date time format (\ref setDateTimeFormat) into numeric fields and literal text, to be
+  used by \ref formatDateTimeFast. Quoting follows the rules of QDateTime::toString.
+  
+  If the format contains fields whose text depends on the locale or the time zone database (day
+  and month names, AM/PM, time zone abbreviations, or the Qt 6 variant of \c z), the tokens are
+  marked invalid and labels are always generated via QDateTime.
+*/
+void QCPAxisTickerDateTime::parseDateTimeFormat()
+{
+  mFormatTokens.clear();
+  mFormatTokensValid = true;
+  const QString fieldChars = QLatin1String("dMyhHmszaAt");
+  const int n = mDateTimeFormat.size();
+  QString literal;
+  int i = 0;
+  while (i < n)
+  {
+    const QChar c = mDateTimeFormat.at(i);
+    if (c == QLatin1Char('\''))
+    {
+      if (i+1 < n && mDateTimeFormat.at(i+1) == QLatin1Char('\'')) // two consecutive quotes yield a single quote
+      {
+        literal.append(c);
+        i += 2;
+        continue;
+      }
+      ++i;
+      while (i < n)
+      {
+        if (mDateTimeFormat.at(i) == QLatin1Char('\''))
+        {
+          if (i+1 < n && mDateTimeFormat.at(i+1) == QLatin1Char('\''))
+          {
+            literal.append(QLatin1Char('\''));
+            i += 2;
+          } else
+          {
+            ++i;
+            break;
+          }
+        } else
+          literal.append(mDateTimeFormat.at(i++));
+      }
+    } else if (fieldChars.contains(c))
+    {
+      int width = 1;
+      while (i+width < n && mDateTimeFormat.at(i+width) == c)
+        ++width;
+      const char field = c.toLatin1();
+      bool supported = false;
+      switch (field)
+      {
+        case 'd': case 'M': case 'h': case 'H': case 'm': case 's': supported = width <= 2; break;
+        case 'y': supported = width == 2 || width == 4; break;
+        case 'z': supported = width == 3; break;
+        default: break; // AM/PM and time zone fields depend on the locale and time zone database
+      }
+      if (!supported)
+      {
+        mFormatTokens.clear();
+        mFormatTokensValid = false;
+        return;
+      }
+      if (!literal.isEmpty())
+      {
+        FormatToken literalToken = {'\0', 0, literal};
+        mFormatTokens.append(literalToken);
+        literal.clear();
+      }
+      FormatToken fieldToken = {field, width, QString()};
+      mFormatTokens.append(fieldToken);
+      i += width;
+    } else
+      literal.append(mDateTimeFormat.at(i++));
+  }
+  if (!literal.isEmpty())
+  {
+    FormatToken literalToken = {'\0', 0, literal};
+    mFormatTokens.append(literalToken);
+  }
+}
+
+/*! \internal
+  
+  Returns the offset from UTC in seconds, which is in effect at \a msecs (milliseconds since
+  Epoch) for the current time spec (\ref setDateTimeSpec) and time zone (\ref setTimeZone).
+*/
+int QCPAxisTickerDateTime::computeUtcOffset(qint64 msecs) const
+{
+# if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+  const QDateTime dateTime = QDateTime::fromMSecsSinceEpoch(msecs);
+  if (mDateTimeSpec == Qt::TimeZone)
+    return mTimeZone.offsetFromUtc(dateTime);
+  else if (mDateTimeSpec == Qt::LocalTime)
+    return dateTime.offsetFromUtc();
+# else
+  Q_UNUSED(msecs)
+# endif
+  return 0;
+}
+
+/*! \internal
+  
+  Sets \a offsetSeconds to the offset from UTC which is in effect at \a msecs (milliseconds since
+  Epoch), and returns true. If the offset can't be determined without QDateTime for the current
+  time spec, returns false.
+  
+  Since querying the time zone database is expensive and all ticks of an axis usually share only a
+  few days, offsets are cached per UTC day. Days which contain a daylight saving time transition
+  aren't cached and are resolved per call instead.
+*/
+bool QCPAxisTickerDateTime::utcOffset(qint64 msecs, int &offsetSeconds)
+{
+  if (mDateTimeSpec == Qt::UTC)
+  {
+    offsetSeconds = 0;
+    return true;
+  }
+# if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+  if (mDateTimeSpec == Qt::LocalTime || (mDateTimeSpec == Qt::TimeZone && mTimeZone.isValid()))
+  {
+    const qint64 msecsPerDay = 86400000;
+    qint64 day = msecs/msecsPerDay;
+    if (msecs%msecsPerDay < 0)
+      --day;
+    QHash<qint64, int>::const_iterator it = mUtcOffsetCache.constFind(day);
+    if (it == mUtcOffsetCache.constEnd())
+    {
+      if (mUtcOffsetCache.size() > 4096)
+        mUtcOffsetCache.clear();
+      const int startOffset = computeUtcOffset(day*msecsPerDay);
+      const int endOffset = computeUtcOffset((day+1)*msecsPerDay-1);
+      it = mUtcOffsetCache.insert(day, startOffset == endOffset ? startOffset : std::numeric_limits<int>::min());
+    }
+    if (it.value() != std::numeric_limits<int>::min())
+      offsetSeconds = it.value();
+    else // transition day, offset varies within the day
+      offsetSeconds = computeUtcOffset(msecs);
+    return true;
+  }
+# endif
+  return false;
+}
+
+/*! \internal
+  
+  Generates the tick label for \a tick into \a result without constructing a QDateTime, by
+  applying the cached UTC offset (\ref utcOffset) and converting the days since Epoch to a
+  proleptic Gregorian calendar date arithmetically.
+  
+  Returns false if the format or the date can't be handled this way (see \ref
+  parseDateTimeFormat), in which case the caller must fall back to QDateTime::toString.
+*/
+bool QCPAxisTickerDateTime::formatDateTimeFast(double tick, QString &result)
+{
+  if (!mFormatTokensValid || !(qAbs(tick) < 1e14)) // also rejects NaN
+    return false;
+  const qint64 msecs = qint64(tick*1000.0); // same conversion as keyToDateTime
+  int offsetSeconds;
+  if (!utcOffset(msecs, offsetSeconds))
+    return false;
+  
+  const qint64 msecsPerDay = 86400000;
+  const qint64 localMsecs = msecs + qint64(offsetSeconds)*1000;
+  qint64 days = localMsecs/msecsPerDay;
+  qint64 msecsOfDay = localMsecs%msecsPerDay;
+  if (msecsOfDay < 0)
+  {
+    msecsOfDay += msecsPerDay;
+    --days;
+  }
+  // convert days since 1970-01-01 to year, month and day (shifted to eras starting on March 1st):
+  const qint64 z = days + 719468;
+  const qint64 era = (z >= 0 ? z : z-146096)/146097;
+  const qint64 dayOfEra = z - era*146097;
+  const qint64 yearOfEra = (dayOfEra - dayOfEra/1460 + dayOfEra/36524 - dayOfEra/146096)/365;
+  const qint64 dayOfYear = dayOfEra - (365*yearOfEra + yearOfEra/4 - yearOfEra/100);
+  const qint64 shiftedMonth = (5*dayOfYear + 2)/153;
+  const int day = int(dayOfYear - (153*shiftedMonth + 2)/5 + 1);
+  const int month = int(shiftedMonth < 10 ? shiftedMonth+3 : shiftedMonth-9);
+  const qint64 year = yearOfEra + era*400 + (month <= 2 ? 1 : 0);
+  if (year < 1 || year > 9999) // leave signs and year zero handling to QDateTime
+    return false;
+  
+  result.clear();
+  result.reserve(mDateTimeFormat.size()+4);
+  char digits[8];
+  foreach (const FormatToken &token, mFormatTokens)
+  {
+    int value = 0;
+    switch (token.field)
+    {
+      case '\0': result.append(token.literal); continue;
+      case 'd': value = day; break;
+      case 'M': value = month; break;
+      case 'y': value = int(token.width == 2 ? year%100 : year); break;
+      case 'h':
+      case 'H': value = int(msecsOfDay/3600000); break;
+      case 'm': value = int(msecsOfDay/60000%60); break;
+      case 's': value = int(msecsOfDay/1000%60); break;
+      case 'z': value = int(msecsOfDay%1000); break;
+      default: return false;
+    }
+    // write value zero-padded to the field width:
+    int pos = sizeof(digits);
+    do
+    {
+      digits[--pos] = char('0' + value%10);
+      value /= 10;
+    } while (value > 0);
+    while (int(sizeof(digits))-pos < token.width)
+      digits[--pos] = '0';
+    result.append(QLatin1String(digits+pos, int(sizeof(digits))-pos));
+  }
+  return true;
+}
+
 /*! \internal
   
   Uses the passed \a tickStep as a guiding value and applies corrections in order to obtain
@@ -6939,6 +7680,7 @@ void QCPAxisTickerTime::setTimeFormat(const QString &format)
       mBiggestUnit = unit;
     }
   }
+  invalidateCache();
 }
 
 /*!
@@ -6951,6 +7693,7 @@ void QCPAxisTickerTime::setTimeFormat(const QString &format)
 void QCPAxisTickerTime::setFieldWidth(QCPAxisTickerTime::TimeUnit unit, int width)
 {
   mFieldWidth[unit] = qMax(width, 1);
+  invalidateCache();
 }
 
 /*! \internal
@@ -7131,8 +7874,10 @@ QCPAxisTickerFixed::QCPAxisTickerFixed() :
 void QCPAxisTickerFixed::setTickStep(double step)
 {
   if (step > 0)
+  {
     mTickStep = step;
-  else
+    invalidateCache();
+  } else
     qDebug() << Q_FUNC_INFO << "tick step must be greater than zero:" << step;
 }
 
@@ -7146,6 +7891,7 @@ void QCPAxisTickerFixed::setTickStep(double step)
 void QCPAxisTickerFixed::setScaleStrategy(QCPAxisTickerFixed::ScaleStrategy strategy)
 {
   mScaleStrategy = strategy;
+  invalidateCache();
 }
 
 /*! \internal
@@ -7220,6 +7966,10 @@ double QCPAxisTickerFixed::getTickStep(const QCPRange &range)
 
   You can access the map directly in order to add, remove or manipulate ticks, as an alternative to
   using the methods provided by QCPAxisTickerText, such as \ref setTicks and \ref addTick.
+
+  Calling this method discards the memoized tick labels of the previous tick generation. Don't
+  keep the returned reference around to modify the ticks after the next replot, call this method
+  again instead.
 */
 
 /* end of documentation of inline functions */
@@ -7246,6 +7996,7 @@ QCPAxisTickerText::QCPAxisTickerText() :
 void QCPAxisTickerText::setTicks(const QMap<double, QString> &ticks)
 {
   mTicks = ticks;
+  invalidateCache();
 }
 
 /*! \overload
@@ -7286,6 +8037,7 @@ void QCPAxisTickerText::setSubTickCount(int subTicks)
 void QCPAxisTickerText::clear()
 {
   mTicks.clear();
+  invalidateCache();
 }
 
 /*!
@@ -7297,6 +8049,7 @@ void QCPAxisTickerText::clear()
 void QCPAxisTickerText::addTick(double position, const QString &label)
 {
   mTicks.insert(position, label);
+  invalidateCache();
 }
 
 /*! \overload
@@ -7316,6 +8069,7 @@ void QCPAxisTickerText::addTicks(const QMap<double, QString> &ticks)
 #else
   mTicks.insert(ticks);
 #endif
+  invalidateCache();
 }
 
 /*! \overload
@@ -7336,6 +8090,7 @@ void QCPAxisTickerText::addTicks(const QVector<double> &positions, const QVector
   int n = qMin(positions.size(), labels.size());
   for (int i=0; i<n; ++i)
     mTicks.insert(positions.at(i), labels.at(i));
+  invalidateCache();
 }
 
 /*!
@@ -7448,6 +8203,7 @@ QCPAxisTickerPi::QCPAxisTickerPi() :
 void QCPAxisTickerPi::setPiSymbol(QString symbol)
 {
   mPiSymbol = symbol;
+  invalidateCache();
 }
 
 /*!
@@ -7459,6 +8215,7 @@ void QCPAxisTickerPi::setPiSymbol(QString symbol)
 void QCPAxisTickerPi::setPiValue(double pi)
 {
   mPiValue = pi;
+  invalidateCache();
 }
 
 /*!
@@ -7472,6 +8229,7 @@ void QCPAxisTickerPi::setPiValue(double pi)
 void QCPAxisTickerPi::setPeriodicity(int multiplesOfPi)
 {
   mPeriodicity = qAbs(multiplesOfPi);
+  invalidateCache();
 }
 
 /*!
@@ -7481,6 +8239,7 @@ void QCPAxisTickerPi::setPeriodicity(int multiplesOfPi)
 void QCPAxisTickerPi::setFractionStyle(QCPAxisTickerPi::FractionStyle style)
 {
   mFractionStyle = style;
+  invalidateCache();
 }
 
 /*! \internal
@@ -7742,6 +8501,7 @@ void QCPAxisTickerLog::setLogBase(double base)
   {
     mLogBase = base;
     mLogBaseLnInv = 1.0/qLn(mLogBase);
+    invalidateCache();
   } else
     qDebug() << Q_FUNC_INFO << "log base has to be greater than zero:" << base;
 }
@@ -9915,8 +10675,7 @@ QCPAxisPainterPrivate::QCPAxisPainterPrivate(QCustomPlot *parentPlot) :
   offset(0),
   abbreviateDecimalPowers(false),
   reversedEndings(false),
-  mParentPlot(parentPlot),
-  mLabelCache(16) // cache at most 16 (tick) labels
+  mParentPlot(parentPlot)
 {
 }
 
@@ -9933,12 +10692,7 @@ QCPAxisPainterPrivate::~QCPAxisPainterPrivate()
 */
 void QCPAxisPainterPrivate::draw(QCPPainter *painter)
 {
-  QByteArray newHash = generateLabelParameterHash();
-  if (newHash != mLabelParameterHash)
-  {
-    mLabelCache.clear();
-    mLabelParameterHash = newHash;
-  }
+  mLabelParameterHash = generateLabelParameterHash();
   
   QPoint origin;
   switch (type)
@@ -10128,12 +10882,7 @@ int QCPAxisPainterPrivate::size()
 {
   int result = 0;
 
-  QByteArray newHash = generateLabelParameterHash();
-  if (newHash != mLabelParameterHash)
-  {
-    mLabelCache.clear();
-    mLabelParameterHash = newHash;
-  }
+  mLabelParameterHash = generateLabelParameterHash();
   
   // get length of tick marks pointing outwards:
   if (!tickPositions.isEmpty())
@@ -10166,32 +10915,39 @@ int QCPAxisPainterPrivate::size()
 
 /*! \internal
   
-  Clears the internal label cache. Upon the next \ref draw, all labels will be created new. This
-  method is called automatically in \ref draw, if any parameters have changed that invalidate the
-  cached labels, such as font, color, etc.
+  Clears the label cache of the parent plot. Since the cache is shared by all axes of the plot,
+  this also affects the labels of other axes. Usually you won't need to call this method manually,
+  because cached labels are looked up with a key that contains all label parameters (see \ref
+  generateLabelParameterHash), so changed fonts, colors, etc. never hit outdated labels.
 */
 void QCPAxisPainterPrivate::clearCache()
 {
-  mLabelCache.clear();
+  mParentPlot->mLabelCache->clear();
 }
 
 /*! \internal
   
-  Returns a hash that allows uniquely identifying whether the label parameters have changed such
-  that the cached labels must be refreshed (\ref clearCache). It is used in \ref draw. If the
-  return value of this method hasn't changed since the last redraw, the respective label parameters
-  haven't changed and cached labels may be used.
+  Returns a hash of all tick label parameters that influence the label pixmaps. It is used as
+  prefix of the keys in the plot-wide label cache, so axes with identical tick label appearance
+  share their cached labels, while labels with different appearance don't collide. It is
+  regenerated in \ref draw and \ref size.
+  
+  Parameters that only influence where a label is placed relative to its tick (axis type, tick
+  label side) are not part of the hash, because the placement offset is calculated from the cached
+  label bounds for each axis individually. The buffer device pixel ratio isn't part of the hash
+  either, because the label cache is flushed when it changes.
 */
 QByteArray QCPAxisPainterPrivate::generateLabelParameterHash() const
 {
-  QByteArray result;
-  result.append(QByteArray::number(mParentPlot->bufferDevicePixelRatio()));
+  QByteArray result("A");
   result.append(QByteArray::number(tickLabelRotation));
-  result.append(QByteArray::number(int(tickLabelSide)));
   result.append(QByteArray::number(int(substituteExponent)));
   result.append(QByteArray::number(int(numberMultiplyCross)));
+  result.append(QByteArray::number(int(abbreviateDecimalPowers)));
+  result.append(QString(mParentPlot->locale().exponential()).toUtf8());
   result.append(tickLabelColor.name().toLatin1()+QByteArray::number(tickLabelColor.alpha(), 16));
   result.append(tickLabelFont.toString().toLatin1());
+  result.append('|');
   return result;
 }
 
@@ -10229,44 +10985,50 @@ void QCPAxisPainterPrivate::placeTickLabel(QCPPainter *painter, double position,
   }
   if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && !painter->modes().testFlag(QCPPainter::pmNoCaching)) // label caching enabled
   {
-    CachedLabel *cachedLabel = mLabelCache.take(text); // attempt to get label from cache
-    if (!cachedLabel)  // no cached label existed, create it
+    const QByteArray key = mLabelParameterHash+text.toUtf8();
+    QCPLabelCachePrivate::CachedLabel cachedLabel;
+    if (!mParentPlot->mLabelCache->findLabel(key, &cachedLabel))  // no cached label existed, create it
     {
-      cachedLabel = new CachedLabel;
       TickLabelData labelData = getTickLabelData(painter->font(), text);
-      cachedLabel->offset = getTickLabelDrawOffset(labelData)+labelData.rotatedTotalBounds.topLeft();
+      cachedLabel.totalBounds = labelData.totalBounds;
+      cachedLabel.rotatedTotalBounds = labelData.rotatedTotalBounds;
       if (!qFuzzyCompare(1.0, mParentPlot->bufferDevicePixelRatio()))
       {
-        cachedLabel->pixmap = QPixmap(labelData.rotatedTotalBounds.size()*mParentPlot->bufferDevicePixelRatio());
+        cachedLabel.pixmap = QPixmap(labelData.rotatedTotalBounds.size()*mParentPlot->bufferDevicePixelRatio());
 #ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
 #  ifdef QCP_DEVICEPIXELRATIO_FLOAT
-        cachedLabel->pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatioF());
+        cachedLabel.pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatioF());
 #  else
-        cachedLabel->pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatio());
+        cachedLabel.pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatio());
 #  endif
 #endif
       } else
-        cachedLabel->pixmap = QPixmap(labelData.rotatedTotalBounds.size());
-      cachedLabel->pixmap.fill(Qt::transparent);
-      QCPPainter cachePainter(&cachedLabel->pixmap);
+        cachedLabel.pixmap = QPixmap(labelData.rotatedTotalBounds.size());
+      cachedLabel.pixmap.fill(Qt::transparent);
+      QCPPainter cachePainter(&cachedLabel.pixmap);
       cachePainter.setPen(painter->pen());
       drawTickLabel(&cachePainter, -labelData.rotatedTotalBounds.topLeft().x(), -labelData.rotatedTotalBounds.topLeft().y(), labelData);
+      mParentPlot->mLabelCache->insertLabel(key, cachedLabel);
     }
+    // the cached label is independent of the axis type, so the offset to the tick is calculated from its bounds for this axis:
+    TickLabelData boundsData;
+    boundsData.totalBounds = cachedLabel.totalBounds;
+    boundsData.rotatedTotalBounds = cachedLabel.rotatedTotalBounds;
+    const QPointF offset = getTickLabelDrawOffset(boundsData)+cachedLabel.rotatedTotalBounds.topLeft();
     // if label would be partly clipped by widget border on sides, don't draw it (only for outside tick labels):
     bool labelClippedByBorder = false;
     if (tickLabelSide == QCPAxis::lsOutside)
     {
       if (QCPAxis::orientation(type) == Qt::Horizontal)
-        labelClippedByBorder = labelAnchor.x()+cachedLabel->offset.x()+cachedLabel->pixmap.width()/mParentPlot->bufferDevicePixelRatio() > viewportRect.right() || labelAnchor.x()+cachedLabel->offset.x() < viewportRect.left();
+        labelClippedByBorder = labelAnchor.x()+offset.x()+cachedLabel.pixmap.width()/mParentPlot->bufferDevicePixelRatio() > viewportRect.right() || labelAnchor.x()+offset.x() < viewportRect.left();
       else
-        labelClippedByBorder = labelAnchor.y()+cachedLabel->offset.y()+cachedLabel->pixmap.height()/mParentPlot->bufferDevicePixelRatio() > viewportRect.bottom() || labelAnchor.y()+cachedLabel->offset.y() < viewportRect.top();
+        labelClippedByBorder = labelAnchor.y()+offset.y()+cachedLabel.pixmap.height()/mParentPlot->bufferDevicePixelRatio() > viewportRect.bottom() || labelAnchor.y()+offset.y() < viewportRect.top();
     }
     if (!labelClippedByBorder)
     {
-      painter->drawPixmap(labelAnchor+cachedLabel->offset, cachedLabel->pixmap);
-      finalSize = cachedLabel->pixmap.size()/mParentPlot->bufferDevicePixelRatio();
+      painter->drawPixmap(labelAnchor+offset, cachedLabel.pixmap);
+      finalSize = cachedLabel.pixmap.size()/mParentPlot->bufferDevicePixelRatio();
     }
-    mLabelCache.insert(text, cachedLabel); // return label to cache or insert for the first time if newly created
   } else // label caching disabled, draw text directly on surface:
   {
     TickLabelData labelData = getTickLabelData(painter->font(), text);
@@ -10315,18 +11077,19 @@ void QCPAxisPainterPrivate::drawTickLabel(QCPPainter *painter, double x, double
     painter->rotate(tickLabelRotation);
   
   // draw text:
+  QCPLabelCachePrivate *labelCache = mParentPlot->mLabelCache;
   if (!labelData.expPart.isEmpty()) // indicator that beautiful powers must be used
   {
     painter->setFont(labelData.baseFont);
-    painter->drawText(0, 0, 0, 0, Qt::TextDontClip, labelData.basePart);
+    labelCache->drawText(painter, QRectF(0, 0, 0, 0), Qt::TextDontClip, labelData.basePart);
     if (!labelData.suffixPart.isEmpty())
-      painter->drawText(labelData.baseBounds.width()+1+labelData.expBounds.width(), 0, 0, 0, Qt::TextDontClip, labelData.suffixPart);
+      labelCache->drawText(painter, QRectF(labelData.baseBounds.width()+1+labelData.expBounds.width(), 0, 0, 0), Qt::TextDontClip, labelData.suffixPart);
     painter->setFont(labelData.expFont);
-    painter->drawText(labelData.baseBounds.width()+1, 0, labelData.expBounds.width(), labelData.expBounds.height(), Qt::TextDontClip,  labelData.expPart);
+    labelCache->drawText(painter, QRectF(labelData.baseBounds.width()+1, 0, labelData.expBounds.width(), labelData.expBounds.height()), Qt::TextDontClip,  labelData.expPart);
   } else
   {
     painter->setFont(labelData.baseFont);
-    painter->drawText(0, 0, labelData.totalBounds.width(), labelData.totalBounds.height(), Qt::TextDontClip | Qt::AlignHCenter, labelData.basePart);
+    labelCache->drawText(painter, QRectF(0, 0, labelData.totalBounds.width(), labelData.totalBounds.height()), Qt::TextDontClip | Qt::AlignHCenter, labelData.basePart);
   }
   
   // reset painter settings to what it was before:
@@ -10529,10 +11292,10 @@ void QCPAxisPainterPrivate::getMaxTickLabelSize(const QFont &font, const QString
 {
   // note: this function must return the same tick label sizes as the placeTickLabel function.
   QSize finalSize;
-  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && mLabelCache.contains(text)) // label caching enabled and have cached label
+  QCPLabelCachePrivate::CachedLabel cachedLabel;
+  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && mParentPlot->mLabelCache->findLabel(mLabelParameterHash+text.toUtf8(), &cachedLabel)) // label caching enabled and have cached label
   {
-    const CachedLabel *cachedLabel = mLabelCache.object(text);
-    finalSize = cachedLabel->pixmap.size()/mParentPlot->bufferDevicePixelRatio();
+    finalSize = cachedLabel.pixmap.size()/mParentPlot->bufferDevicePixelRatio();
   } else // label caching disabled or no label with this text cached:
   {
     TickLabelData labelData = getTickLabelData(font, text);
@@ -11021,6 +11784,283 @@ void QCPScatterStyle::drawShape(QCPPainter *painter, double x, double y) const
 /* end of 'src/scatterstyle.cpp' */
 
 
+/* including file 'src/datacontainer.cpp'   */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPTimeSeriesCodec
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPTimeSeriesCodec
+  \brief Lossless compression of columns of double values, in the style of the Gorilla codec
+  
+  This class compresses a column of doubles, e.g. the keys or the values of consecutive data
+  points, into a bit stream. It is used by \ref QCPDataArchive to store rarely accessed data
+  points, but can also be used directly.
+  
+  Each column starts with its first value in full. The following values are stored depending on
+  the \ref Encoding:
+  
+  \li \ref eDeltaOfDelta interprets the values as 64 bit integers and stores how the difference to
+  the previous value changed, with a short bit sequence for small changes. Evenly spaced keys need
+  only a single bit per value.
+  \li \ref eXor stores the bits that changed with respect to the previous value. Unchanged values
+  need a single bit, and values that differ only in a few mantissa bits need only those bits
+  plus a short header.
+  
+  Both encodings are lossless, including NaN and infinite values. The compressed column is padded
+  to a whole byte, so several columns can be appended to the same QByteArray and decoded one after
+  the other.
+*/
+
+/*! \internal
+  
+  Appends bit sequences, most significant bit first, to a QByteArray.
+*/
+class QCPTimeSeriesCodec::BitWriter
+{
+public:
+  explicit BitWriter(QByteArray &output) : mOutput(output), mCurrent(0), mFill(0) {}
+  
+  void write(quint64 bits, int count)
+  {
+    while (count > 0)
+    {
+      const int space = 8-mFill;
+      const int n = qMin(space, count);
+      mCurrent |= uchar(((bits >> (count-n)) & ((1u << n)-1)) << (space-n));
+      mFill += n;
+      count -= n;
+      if (mFill == 8)
+      {
+        mOutput.append(char(mCurrent));
+        mCurrent = 0;
+        mFill = 0;
+      }
+    }
+  }
+  
+  void flush()
+  {
+    if (mFill > 0)
+    {
+      mOutput.append(char(mCurrent));
+      mCurrent = 0;
+      mFill = 0;
+    }
+  }
+  
+private:
+  QByteArray &mOutput;
+  uchar mCurrent;
+  int mFill;
+};
+
+/*! \internal
+  
+  Reads bit sequences written by \ref BitWriter. Reading past the end of the input yields zero
+  bits and sets \ref overrun.
+*/
+class QCPTimeSeriesCodec::BitReader
+{
+public:
+  BitReader(const QByteArray &input, int offset) :
+    mData(reinterpret_cast<const uchar*>(input.constData())), mSize(input.size()), mByte(offset), mBit(0), mOverrun(false) {}
+  
+  quint64 read(int count)
+  {
+    quint64 result = 0;
+    while (count > 0)
+    {
+      if (mByte >= mSize)
+      {
+        mOverrun = true;
+        return count < 64 ? result << count : 0;
+      }
+      const int available = 8-mBit;
+      const int n = qMin(available, count);
+      result = (result << n) | ((mData[mByte] >> (available-n)) & ((1u << n)-1));
+      mBit += n;
+      count -= n;
+      if (mBit == 8)
+      {
+        ++mByte;
+        mBit = 0;
+      }
+    }
+    return result;
+  }
+  
+  bool readBit() { return read(1) != 0; }
+  bool overrun() const { return mOverrun; }
+  int endOffset() const { return mBit > 0 ? mByte+1 : mByte; }
+  
+private:
+  const uchar *mData;
+  int mSize;
+  int mByte;
+  int mBit;
+  bool mOverrun;
+};
+
+/*!
+  Compresses \a count doubles with the specified \a encoding and appends them to \a output. The
+  doubles are read from \a data, \a data + \a stride, \a data + 2*\a stride, and so on. This allows
+  compressing one member of an array of data points directly.
+  
+  \see decode
+*/
+void QCPTimeSeriesCodec::encode(const double *data, int count, int stride, Encoding encoding, QByteArray &output)
+{
+  if (count <= 0)
+    return;
+  BitWriter writer(output);
+  quint64 previous;
+  memcpy(&previous, data, sizeof(previous));
+  writer.write(previous, 64);
+  if (encoding == eDeltaOfDelta)
+  {
+    quint64 previousDelta = 0;
+    for (int i=1; i<count; ++i)
+    {
+      quint64 current;
+      memcpy(&current, data+qint64(i)*stride, sizeof(current));
+      const quint64 delta = current-previous;
+      if (i == 1)
+      {
+        writer.write(delta, 64);
+      } else
+      {
+        // zigzag encoding maps small positive and negative changes to small unsigned numbers:
+        const qint64 deltaOfDelta = qint64(delta-previousDelta);
+        const quint64 zigzag = (quint64(deltaOfDelta) << 1) ^ quint64(deltaOfDelta >> 63);
+        if (zigzag == 0)
+          writer.write(0, 1);
+        else if (zigzag < (quint64(1) << 7))
+          writer.write((quint64(0x2) << 7) | zigzag, 2+7);
+        else if (zigzag < (quint64(1) << 9))
+          writer.write((quint64(0x6) << 9) | zigzag, 3+9);
+        else if (zigzag < (quint64(1) << 12))
+          writer.write((quint64(0xE) << 12) | zigzag, 4+12);
+        else if (zigzag < (quint64(1) << 32))
+        {
+          writer.write(0x1E, 5);
+          writer.write(zigzag, 32);
+        } else
+        {
+          writer.write(0x1F, 5);
+          writer.write(zigzag, 64);
+        }
+      }
+      previousDelta = delta;
+      previous = current;
+    }
+  } else // eXor
+  {
+    int previousLeading = -1; // no meaningful bit window yet
+    int previousTrailing = 0;
+    for (int i=1; i<count; ++i)
+    {
+      quint64 current;
+      memcpy(&current, data+qint64(i)*stride, sizeof(current));
+      const quint64 xorValue = current ^ previous;
+      if (xorValue == 0)
+      {
+        writer.write(0, 1);
+      } else
+      {
+        const int leading = qMin(31, int(qCountLeadingZeroBits(xorValue)));
+        const int trailing = int(qCountTrailingZeroBits(xorValue));
+        if (previousLeading >= 0 && leading >= previousLeading && trailing >= previousTrailing)
+        {
+          // changed bits fit into the window of the previous value:
+          writer.write(0x2, 2);
+          writer.write(xorValue >> previousTrailing, 64-previousLeading-previousTrailing);
+        } else
+        {
+          const int meaningful = 64-leading-trailing;
+          writer.write(0x3, 2);
+          writer.write(quint64(leading), 5);
+          writer.write(quint64(meaningful & 0x3F), 6); // 64 meaningful bits are stored as 0
+          writer.write(xorValue >> trailing, meaningful);
+          previousLeading = leading;
+          previousTrailing = trailing;
+        }
+      }
+      previous = current;
+    }
+  }
+  writer.flush();
+}
+
+/*!
+  Decompresses \a count doubles that were compressed with \ref encode and the same \a encoding,
+  starting at byte \a offset of \a input. The doubles are written to \a data, \a data + \a stride,
+  \a data + 2*\a stride, and so on.
+  
+  Returns the offset of the byte after the compressed column, where a following column starts.
+  Returns -1 if \a input ends before \a count doubles were decoded.
+*/
+int QCPTimeSeriesCodec::decode(const QByteArray &input, int offset, double *data, int count, int stride, Encoding encoding)
+{
+  if (count <= 0)
+    return offset;
+  BitReader reader(input, offset);
+  quint64 previous = reader.read(64);
+  memcpy(data, &previous, sizeof(previous));
+  if (encoding == eDeltaOfDelta)
+  {
+    quint64 delta = 0;
+    for (int i=1; i<count; ++i)
+    {
+      if (i == 1)
+      {
+        delta = reader.read(64);
+      } else if (reader.readBit())
+      {
+        quint64 zigzag;
+        if (!reader.readBit())
+          zigzag = reader.read(7);
+        else if (!reader.readBit())
+          zigzag = reader.read(9);
+        else if (!reader.readBit())
+          zigzag = reader.read(12);
+        else if (!reader.readBit())
+          zigzag = reader.read(32);
+        else
+          zigzag = reader.read(64);
+        delta += (zigzag >> 1) ^ (0-(zigzag & 1));
+      }
+      previous += delta;
+      memcpy(data+qint64(i)*stride, &previous, sizeof(previous));
+    }
+  } else // eXor
+  {
+    int leading = 0;
+    int trailing = 0;
+    for (int i=1; i<count; ++i)
+    {
+      if (reader.readBit())
+      {
+        if (reader.readBit())
+        {
+          leading = int(reader.read(5));
+          int meaningful = int(reader.read(6));
+          if (meaningful == 0)
+            meaningful = 64;
+          trailing = 64-leading-meaningful;
+          if (trailing < 0)
+            return -1;
+        }
+        previous ^= reader.read(64-leading-trailing) << trailing;
+      }
+      memcpy(data+qint64(i)*stride, &previous, sizeof(previous));
+    }
+  }
+  return reader.overrun() ? -1 : reader.endOffset();
+}
+/* end of 'src/datacontainer.cpp' */
+
+
 /* including file 'src/plottable.cpp'       */
 /* modified 2022-11-06T12:45:56, size 38818 */
 
@@ -11452,6 +12492,8 @@ QCPAbstractPlottable::~QCPAbstractPlottable()
 void QCPAbstractPlottable::setName(const QString &name)
 {
   mName = name;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -13267,6 +14309,207 @@ QCP::Interaction QCPAbstractItem::selectionCategory() const
 /* including file 'src/core.cpp'             */
 /* modified 2022-11-06T12:45:56, size 127625 */
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPReplotProfile
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPReplotProfile
+  \brief Holds the timings of the steps of a replot
+  
+  When profiling is enabled with \ref QCustomPlot::setProfiling, each \ref QCustomPlot::replot
+  records how long its steps took, with nanosecond resolution. The profile of the last replot is
+  available via \ref QCustomPlot::replotProfile and is passed to the \ref
+  QCustomPlot::replotProfiled signal.
+  
+  Each step is an \ref Event with one of the following categories:
+  
+  \li \c "phase": the top level phases of the replot, i.e. \c "updateLayout" (with the nested
+  steps \c "preparation", where the axes generate their ticks, and \c "margins and layout"), \c
+  "setupPaintBuffers" and \c "drawLayers"
+  \li \c "layer": drawing one layer into its paint buffer (\ref QCPLayer::drawToPaintBuffer)
+  \li \c "plottable" and \c "layerable": drawing one plottable or other layerable (axis rect, grid,
+  axis, legend, item,...) of a layer
+  \li \c "data": the data preparation of a plottable, e.g. \ref QCPGraph determining the visible
+  data points and applying adaptive sampling. These events carry the number of data points before
+  (\ref Event::dataCount) and after (\ref Event::sampledCount) sampling.
+  \li \c "painting": the actual painting calls of a plottable, e.g. stroking the line of a \ref
+  QCPGraph
+  \li \c "composite": copying the paint buffers to the widget surface in \ref
+  QCustomPlot::paintEvent. If the widget repaint was queued (see \ref QCustomPlot::replot), this
+  event is appended when the repaint happens, after the \ref QCustomPlot::replotProfiled signal.
+  
+  Use \ref toChromeTrace or \ref saveChromeTrace to inspect the profile as a flame graph in a
+  trace viewer like \c chrome://tracing or Perfetto.
+*/
+
+/*!
+  Creates an empty profile.
+*/
+QCPReplotProfile::QCPReplotProfile() :
+  mDuration(0),
+  mDepth(0),
+  mRecording(false)
+{
+}
+
+/*!
+  Returns the events of the specified \a category, in the order they started.
+*/
+QVector<QCPReplotProfile::Event> QCPReplotProfile::events(const QString &category) const
+{
+  QVector<Event> result;
+  foreach (const Event &event, mEvents)
+  {
+    if (event.category == category)
+      result.append(event);
+  }
+  return result;
+}
+
+/*!
+  Returns the summed duration in nanoseconds of all events of the specified \a category.
+*/
+qint64 QCPReplotProfile::totalDuration(const QString &category) const
+{
+  qint64 result = 0;
+  foreach (const Event &event, mEvents)
+  {
+    if (event.category == category)
+      result += event.duration;
+  }
+  return result;
+}
+
+/*!
+  Returns the profile in the Chrome trace event format, as complete events (phase type \c "X")
+  with timestamps in microseconds.
+  
+  \see saveChromeTrace
+*/
+QByteArray QCPReplotProfile::toChromeTrace() const
+{
+  QByteArray result("{\"traceEvents\":[");
+  for (int i=0; i<mEvents.size(); ++i)
+  {
+    const Event &event = mEvents.at(i);
+    if (i > 0)
+      result += ',';
+    result += "\n{\"name\":" + jsonString(event.name) + ",\"cat\":" + jsonString(event.category);
+    result += ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" + QByteArray::number(event.start/1000.0, 'f', 3);
+    result += ",\"dur\":" + QByteArray::number(event.duration/1000.0, 'f', 3);
+    if (event.dataCount >= 0)
+      result += ",\"args\":{\"dataCount\":" + QByteArray::number(event.dataCount) + ",\"sampledCount\":" + QByteArray::number(event.sampledCount) + "}";
+    result += '}';
+  }
+  result += "\n],\"displayTimeUnit\":\"ns\"}\n";
+  return result;
+}
+
+/*!
+  Writes the profile in the Chrome trace event format to the file \a fileName. Returns whether the
+  file could be written.
+  
+  \see toChromeTrace
+*/
+bool QCPReplotProfile::saveChromeTrace(const QString &fileName) const
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    qDebug() << Q_FUNC_INFO << "failed to open file" << fileName << file.errorString();
+    return false;
+  }
+  const QByteArray trace = toChromeTrace();
+  return file.write(trace) == trace.size();
+}
+
+/*!
+  Discards all events and starts the time measurement of a new replot. This is called by \ref
+  QCustomPlot::replot.
+*/
+void QCPReplotProfile::start()
+{
+  mEvents.clear();
+  mDuration = 0;
+  mDepth = 0;
+  mRecording = true;
+  mTimer.start();
+}
+
+/*!
+  Stores the total duration of the replot. This is called by \ref QCustomPlot::replot. Events can
+  still be added afterwards, e.g. for the queued widget repaint.
+*/
+void QCPReplotProfile::finish()
+{
+  mDuration = mTimer.nsecsElapsed();
+}
+
+/*!
+  Starts a new event with the specified \a name and \a category, nested into all events which were
+  started but not yet ended. Returns the index of the event, which must be passed to \ref endEvent.
+  
+  Returns -1 if no replot was recorded yet (see \ref start).
+*/
+int QCPReplotProfile::beginEvent(const QString &name, const QString &category)
+{
+  if (!mRecording)
+    return -1;
+  Event event;
+  event.name = name;
+  event.category = category;
+  event.start = mTimer.nsecsElapsed();
+  event.duration = 0;
+  event.depth = mDepth++;
+  event.dataCount = -1;
+  event.sampledCount = -1;
+  mEvents.append(event);
+  return int(mEvents.size())-1;
+}
+
+/*!
+  Ends the \a event which was started with \ref beginEvent. Optionally, the number of processed
+  data points (\a dataCount) and the number of points that remained after adaptive sampling (\a
+  sampledCount) can be stored with the event.
+*/
+void QCPReplotProfile::endEvent(int event, qint64 dataCount, qint64 sampledCount)
+{
+  if (event < 0 || event >= mEvents.size())
+    return;
+  Event &e = mEvents[event];
+  e.duration = mTimer.nsecsElapsed()-e.start;
+  e.dataCount = dataCount;
+  e.sampledCount = sampledCount;
+  --mDepth;
+}
+
+/*! \internal
+  
+  Returns \a text as a quoted JSON string, with the characters that JSON requires escaped.
+*/
+QByteArray QCPReplotProfile::jsonString(const QString &text)
+{
+  const QByteArray utf8 = text.toUtf8();
+  QByteArray result;
+  result.reserve(utf8.size()+2);
+  result += '"';
+  for (int i=0; i<utf8.size(); ++i)
+  {
+    const uchar c = uchar(utf8.at(i));
+    if (c == '"' || c == '\\')
+    {
+      result += '\\';
+      result += char(c);
+    } else if (c < 0x20)
+      result += "\\u00" + QByteArray::number(c, 16).rightJustified(2, '0');
+    else
+      result += char(c);
+  }
+  result += '"';
+  return result;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCustomPlot
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -13618,16 +14861,21 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
   mSelectionRectMode(QCP::srmNone),
   mSelectionRect(nullptr),
   mOpenGl(false),
+  mProfiling(false),
   mMouseHasMoved(false),
   mMouseEventLayerable(nullptr),
   mMouseSignalLayerable(nullptr),
   mReplotting(false),
   mReplotQueued(false),
+  mLayoutValid(false),
   mReplotTime(0),
   mReplotTimeAverage(0),
   mOpenGlMultisamples(16),
   mOpenGlAntialiasedElementsBackup(QCP::aeNone),
-  mOpenGlCacheLabelsBackup(true)
+  mOpenGlCacheLabelsBackup(true),
+  mLabelCache(new QCPLabelCachePrivate),
+  mScaledBackgroundSmooth(false),
+  mBackgroundRescaleTimer(new QTimer(this))
 {
   setAttribute(Qt::WA_NoMousePropagation);
   setFocusPolicy(Qt::ClickFocus);
@@ -13635,6 +14883,9 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
   QLocale currentLocale = locale();
   currentLocale.setNumberOptions(QLocale::OmitGroupSeparator);
   setLocale(currentLocale);
+  mBackgroundRescaleTimer->setSingleShot(true);
+  mBackgroundRescaleTimer->setInterval(200);
+  connect(mBackgroundRescaleTimer, SIGNAL(timeout()), this, SLOT(rescaleBackgroundSmooth()));
 #ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
 #  ifdef QCP_DEVICEPIXELRATIO_FLOAT
   setBufferDevicePixelRatio(QWidget::devicePixelRatioF());
@@ -13706,6 +14957,9 @@ QCustomPlot::~QCustomPlot()
   mCurrentLayer = nullptr;
   qDeleteAll(mLayers); // don't use removeLayer, because it would prevent the last layer to be removed
   mLayers.clear();
+  
+  delete mLabelCache;
+  mLabelCache = nullptr;
 }
 
 /*!
@@ -14101,6 +15355,47 @@ void QCustomPlot::setOpenGl(bool enabled, int multisampling)
 #endif
 }
 
+/*!
+  Sets the maximum memory in \a kilobytes that cached tick label pixmaps may occupy (see \ref
+  QCP::phCacheLabels). The default is 4096 kilobytes.
+
+  The label cache is shared by all axes and polar axes of this QCustomPlot, so tick labels with
+  identical text and appearance are only rendered once, even if they appear on many axes (e.g. in a
+  grid of linked axis rects). When the limit is exceeded, the least recently used labels are
+  discarded.
+
+  \see labelCacheSize
+*/
+void QCustomPlot::setLabelCacheSize(int kilobytes)
+{
+  mLabelCache->setMaximumMemory(kilobytes);
+}
+
+/*!
+  Sets whether each \ref replot records the durations of its steps, like the layout update, the
+  drawing of each layer and plottable, and the data preparation and adaptive sampling of the
+  plottables. The profile of the last replot is available via \ref replotProfile and is passed to
+  the \ref replotProfiled signal.
+  
+  Profiling adds a small overhead to each replot, so it is disabled by default.
+  
+  \see QCPReplotProfile
+*/
+void QCustomPlot::setProfiling(bool enabled)
+{
+  mProfiling = enabled;
+}
+
+/*!
+  Returns the maximum memory in kilobytes that cached tick label pixmaps may occupy.
+
+  \see setLabelCacheSize
+*/
+int QCustomPlot::labelCacheSize() const
+{
+  return mLabelCache->maximumMemory();
+}
+
 /*!
   Sets the viewport of this QCustomPlot. Usually users of QCustomPlot don't need to change the
   viewport manually.
@@ -14119,6 +15414,8 @@ void QCustomPlot::setOpenGl(bool enabled, int multisampling)
 */
 void QCustomPlot::setViewport(const QRect &rect)
 {
+  if (mViewport != rect)
+    mLayoutValid = false;
   mViewport = rect;
   if (mPlotLayout)
     mPlotLayout->setOuterRect(mViewport);
@@ -14143,7 +15440,8 @@ void QCustomPlot::setBufferDevicePixelRatio(double ratio)
     mBufferDevicePixelRatio = ratio;
     foreach (QSharedPointer<QCPAbstractPaintBuffer> buffer, mPaintBuffers)
       buffer->setDevicePixelRatio(mBufferDevicePixelRatio);
-    // Note: axis label cache has devicePixelRatio as part of cache hash, so no need to manually clear cache here
+    // cached labels were rendered for the old device pixel ratio, and the label cache keys don't contain it:
+    mLabelCache->clear();
 #else
     qDebug() << Q_FUNC_INFO << "Device pixel ratios not supported for Qt versions before 5.4";
     mBufferDevicePixelRatio = 1.0;
@@ -14163,6 +15461,10 @@ void QCustomPlot::setBufferDevicePixelRatio(double ratio)
   If a background brush was set with \ref setBackground(const QBrush &brush), the viewport will
   first be filled with that brush, before drawing the background pixmap. This can be useful for
   background pixmaps with translucent areas.
+  
+  The pixmap is drawn into the paint buffer of the lowest layer during the next \ref replot. If
+  that layer is set to \ref QCPLayer::lmBuffered, replotting other buffered layers individually
+  (\ref QCPLayer::replot) doesn't redraw the background.
 
   \see setBackgroundScaled, setBackgroundScaledMode
 */
@@ -15133,6 +16435,10 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
   mReplotQueued = false;
   emit beforeReplot();
   
+  QCPReplotProfile *profile = activeProfile();
+  if (profile)
+    profile->start();
+  
 # if QT_VERSION < QT_VERSION_CHECK(4, 8, 0)
   QTime replotTimer;
   replotTimer.start();
@@ -15141,13 +16447,31 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
   replotTimer.start();
 # endif
   
+  int profileEvent = profile ? profile->beginEvent(QLatin1String("updateLayout"), QLatin1String("phase")) : -1;
   updateLayout();
+  if (profile)
+  {
+    profile->endEvent(profileEvent);
+    profileEvent = profile->beginEvent(QLatin1String("setupPaintBuffers"), QLatin1String("phase"));
+  }
   // draw all layered objects (grid, axes, plottables, items, legend,...) into their buffers:
   setupPaintBuffers();
+  if (profile)
+  {
+    profile->endEvent(profileEvent);
+    profileEvent = profile->beginEvent(QLatin1String("drawLayers"), QLatin1String("phase"));
+  }
   foreach (QCPLayer *layer, mLayers)
+  {
+    const int layerEvent = profile ? profile->beginEvent(layer->name(), QLatin1String("layer")) : -1;
     layer->drawToPaintBuffer();
+    if (profile)
+      profile->endEvent(layerEvent);
+  }
   foreach (QSharedPointer<QCPAbstractPaintBuffer> buffer, mPaintBuffers)
     buffer->setInvalidated(false);
+  if (profile)
+    profile->endEvent(profileEvent);
   
   if ((refreshPriority == rpRefreshHint && mPlottingHints.testFlag(QCP::phImmediateRefresh)) || refreshPriority==rpImmediateRefresh)
     repaint();
@@ -15164,6 +16488,11 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
   else
     mReplotTimeAverage = mReplotTime; // no previous replots to average with, so initialize with replot time
   
+  if (profile)
+  {
+    profile->finish();
+    emit replotProfiled(*profile);
+  }
   emit afterReplot();
   mReplotting = false;
 }
@@ -15179,6 +16508,25 @@ double QCustomPlot::replotTime(bool average) const
   return average ? mReplotTimeAverage : mReplotTime;
 }
 
+/*!
+  Marks the layout as changed, so the next \ref replot performs the margin and layout update
+  phases (see \ref QCPLayoutElement::UpdatePhase) again.
+  
+  To save time on every replot, the positions and margins of the layout elements are only
+  recalculated when something that influences them has changed. Changes of the viewport size, of
+  axis tick labels and other axis properties that affect the margins, insertion and removal of
+  layout elements, size constraints, and fonts and texts of legends and text elements are detected
+  automatically.
+  
+  You only need to call this method if you change something else that affects the size hints of
+  layout elements, e.g. in a custom QCPLayoutElement subclass whose \ref
+  QCPLayoutElement::minimumOuterSizeHint depends on own properties.
+*/
+void QCustomPlot::invalidateLayout()
+{
+  mLayoutValid = false;
+}
+
 /*!
   Rescales the axes such that all plottables (like graphs) in the plot are fully visible.
   
@@ -15491,11 +16839,14 @@ void QCustomPlot::paintEvent(QPaintEvent *event)
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
   painter.setRenderHint(QPainter::HighQualityAntialiasing); // to make Antialiasing look good if using the OpenGL graphicssystem
 #endif
+    const int profileEvent = mProfiling ? mReplotProfile.beginEvent(QLatin1String("paintEvent"), QLatin1String("composite")) : -1;
     if (mBackgroundBrush.style() != Qt::NoBrush)
       painter.fillRect(mViewport, mBackgroundBrush);
-    drawBackground(&painter);
+    // the background pixmap was already drawn into the lowest paint buffer by QCPLayer::drawToPaintBuffer
     foreach (QSharedPointer<QCPAbstractPaintBuffer> buffer, mPaintBuffers)
       buffer->draw(&painter);
+    if (mProfiling)
+      mReplotProfile.endEvent(profileEvent);
   }
 }
 
@@ -15503,10 +16854,15 @@ void QCustomPlot::paintEvent(QPaintEvent *event)
   
   Event handler for a resize of the QCustomPlot widget. The viewport (which becomes the outer rect
   of mPlotLayout) is resized appropriately. Finally a \ref replot is performed.
+  
+  While resize events keep coming in, e.g. because the user drags the window border, the
+  background pixmap is scaled with a fast transformation. Once the resizing stopped for a moment,
+  \ref rescaleBackgroundSmooth replaces it with a smoothly scaled version.
 */
 void QCustomPlot::resizeEvent(QResizeEvent *event)
 {
   Q_UNUSED(event)
+  mBackgroundRescaleTimer->start();
   // resize and repaint the buffer:
   setViewport(rect());
   replot(rpQueuedRefresh); // queued refresh is important here, to prevent painting issues in some contexts (e.g. MDI subwindow)
@@ -15767,17 +17123,78 @@ void QCustomPlot::draw(QCPPainter *painter)
 
   Here, the layout elements calculate their positions and margins, and prepare for the following
   draw call.
+  
+  The preparation phase (which e.g. generates the axis ticks) is always performed. The margin and
+  layout phases are skipped if the result from the previous call is still valid, i.e. the layout
+  wasn't invalidated (see \ref invalidateLayout) and the margins of all axes are unchanged (see
+  \ref axisMarginsValid).
 */
 void QCustomPlot::updateLayout()
 {
+  QCPReplotProfile *profile = activeProfile();
   // run through layout phases:
+  int profileEvent = profile ? profile->beginEvent(QLatin1String("preparation"), QLatin1String("phase")) : -1;
   mPlotLayout->update(QCPLayoutElement::upPreparation);
-  mPlotLayout->update(QCPLayoutElement::upMargins);
-  mPlotLayout->update(QCPLayoutElement::upLayout);
+  if (profile)
+    profile->endEvent(profileEvent);
+  if (!mLayoutValid || !axisMarginsValid())
+  {
+    profileEvent = profile ? profile->beginEvent(QLatin1String("margins and layout"), QLatin1String("phase")) : -1;
+    mPlotLayout->update(QCPLayoutElement::upMargins);
+    mPlotLayout->update(QCPLayoutElement::upLayout);
+    mLayoutValid = true; // changes caused by the layout pass itself are already accounted for
+    if (profile)
+      profile->endEvent(profileEvent);
+  }
 
   emit afterLayout();
 }
 
+/*! \internal
+  
+  Returns whether the cached margins of all axes in the layout (including the axes of color
+  scales) are still valid. This is the case if neither their tick labels changed in the last
+  preparation phase, nor any property which affects the margin (see \ref QCPAxis::calculateMargin).
+  
+  Axes on axis rect sides with manual margins are ignored, since their margin isn't calculated.
+*/
+bool QCustomPlot::axisMarginsValid() const
+{
+  const QList<QCP::MarginSide> allMarginSides = QList<QCP::MarginSide>() << QCP::msLeft << QCP::msRight << QCP::msTop << QCP::msBottom;
+  QStack<QCPLayoutElement*> elementStack;
+  if (mPlotLayout)
+    elementStack.push(mPlotLayout);
+  
+  while (!elementStack.isEmpty())
+  {
+    foreach (QCPLayoutElement *element, elementStack.pop()->elements(false))
+    {
+      if (element)
+      {
+        elementStack.push(element);
+        if (QCPAxisRect *ar = qobject_cast<QCPAxisRect*>(element))
+        {
+          foreach (QCP::MarginSide side, allMarginSides)
+          {
+            if (!ar->autoMargins().testFlag(side))
+              continue;
+            foreach (QCPAxis *axis, ar->axes(QCPAxis::marginSideToAxisType(side)))
+            {
+              if (axis->visible() && !axis->mCachedMarginValid)
+                return false;
+            }
+          }
+        } else if (QCPColorScale *cs = qobject_cast<QCPColorScale*>(element))
+        {
+          if (cs->axis() && cs->axis()->visible() && !cs->axis()->mCachedMarginValid)
+            return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
 /*! \internal
   
   Draws the viewport background pixmap of the plot.
@@ -15786,9 +17203,18 @@ void QCustomPlot::updateLayout()
   depending on \ref setBackgroundScaled and \ref setBackgroundScaledMode and then draws it inside
   the viewport with the provided \a painter. The scaled version is buffered in
   mScaledBackgroundPixmap to prevent expensive rescaling at every redraw. It is only updated, when
-  the axis rect has changed in a way that requires a rescale of the background pixmap (this is
-  dependent on the \ref setBackgroundScaledMode), or when a differend axis background pixmap was
-  set.
+  the viewport or the device pixel ratio of the paint buffers has changed in a way that requires a
+  rescale of the background pixmap (this is dependent on the \ref setBackgroundScaledMode), or when
+  a differend background pixmap was set.
+  
+  The scaled version has the resolution of the paint buffers, so it is drawn without further
+  scaling, also on high-DPI screens. While the widget is being resized, a fast transformation is
+  used for scaling, which is replaced by a smooth one once the resizing stopped (see \ref
+  resizeEvent).
+  
+  During a replot, this function is called by \ref QCPLayer::drawToPaintBuffer of the lowest layer,
+  so the pixmap is part of that layer's paint buffer and isn't drawn again when the widget is
+  repainted without a replot.
   
   Note that this function does not draw a fill with the background brush
   (\ref setBackground(const QBrush &brush)) beneath the pixmap.
@@ -15805,11 +17231,17 @@ void QCustomPlot::drawBackground(QCPPainter *painter)
     if (mBackgroundScaled)
     {
       // check whether mScaledBackground needs to be updated:
+      const QSize targetSize = mViewport.size()*mBufferDevicePixelRatio;
       QSize scaledSize(mBackgroundPixmap.size());
-      scaledSize.scale(mViewport.size(), mBackgroundScaledMode);
-      if (mScaledBackgroundPixmap.size() != scaledSize)
-        mScaledBackgroundPixmap = mBackgroundPixmap.scaled(mViewport.size(), mBackgroundScaledMode, Qt::SmoothTransformation);
-      painter->drawPixmap(mViewport.topLeft(), mScaledBackgroundPixmap, QRect(0, 0, mViewport.width(), mViewport.height()) & mScaledBackgroundPixmap.rect());
+      scaledSize.scale(targetSize, mBackgroundScaledMode);
+      const bool resizing = mBackgroundRescaleTimer->isActive();
+      if (mScaledBackgroundPixmap.size() != scaledSize || (!mScaledBackgroundSmooth && !resizing))
+      {
+        mScaledBackgroundPixmap = mBackgroundPixmap.scaled(targetSize, mBackgroundScaledMode, resizing ? Qt::FastTransformation : Qt::SmoothTransformation);
+        mScaledBackgroundSmooth = !resizing;
+      }
+      const QRect sourceRect = QRect(QPoint(0, 0), targetSize) & mScaledBackgroundPixmap.rect();
+      painter->drawPixmap(QRectF(mViewport.topLeft(), QSizeF(sourceRect.size())/mBufferDevicePixelRatio), mScaledBackgroundPixmap, QRectF(sourceRect));
     } else
     {
       painter->drawPixmap(mViewport.topLeft(), mBackgroundPixmap, QRect(0, 0, mViewport.width(), mViewport.height()));
@@ -15817,6 +17249,29 @@ void QCustomPlot::drawBackground(QCPPainter *painter)
   }
 }
 
+/*! \internal
+  
+  Returns the profile that the steps of the current replot shall be recorded to, or \c nullptr if
+  profiling is disabled (see \ref setProfiling) or no replot is in progress, e.g. when exporting.
+*/
+QCPReplotProfile *QCustomPlot::activeProfile()
+{
+  return mProfiling && mReplotting ? &mReplotProfile : nullptr;
+}
+
+/*! \internal
+  
+  Called when the widget wasn't resized for a moment. If the background pixmap was scaled with a
+  fast transformation during the resizing, queues a replot which scales it smoothly.
+  
+  \see resizeEvent, drawBackground
+*/
+void QCustomPlot::rescaleBackgroundSmooth()
+{
+  if (!mBackgroundPixmap.isNull() && mBackgroundScaled && !mScaledBackgroundSmooth)
+    replot(rpQueuedReplot);
+}
+
 /*! \internal
 
   Goes through the layers and makes sure this QCustomPlot instance holds the correct number of
@@ -16014,6 +17469,7 @@ void QCustomPlot::axisRemoved(QCPAxis *axis)
     yAxis = nullptr;
   if (yAxis2 == axis)
     yAxis2 = nullptr;
+  mLayoutValid = false;
   
   // Note: No need to take care of range drag axes and range zoom axes, because they are stored in smart pointers
 }
@@ -18771,6 +20227,8 @@ QCPAbstractLegendItem::QCPAbstractLegendItem(QCPLegend *parent) :
 void QCPAbstractLegendItem::setFont(const QFont &font)
 {
   mFont = font;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -18792,6 +20250,8 @@ void QCPAbstractLegendItem::setTextColor(const QColor &color)
 void QCPAbstractLegendItem::setSelectedFont(const QFont &font)
 {
   mSelectedFont = font;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -18832,6 +20292,8 @@ void QCPAbstractLegendItem::setSelected(bool selected)
   if (mSelected != selected)
   {
     mSelected = selected;
+    if (mParentPlot) // the selected font may have a different size
+      mParentPlot->invalidateLayout();
     emit selectionChanged(mSelected);
   }
 }
@@ -19184,6 +20646,8 @@ void QCPLegend::setTextColor(const QColor &color)
 void QCPLegend::setIconSize(const QSize &size)
 {
   mIconSize = size;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*! \overload
@@ -19192,6 +20656,8 @@ void QCPLegend::setIconSize(int width, int height)
 {
   mIconSize.setWidth(width);
   mIconSize.setHeight(height);
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -19202,6 +20668,8 @@ void QCPLegend::setIconSize(int width, int height)
 void QCPLegend::setIconTextPadding(int padding)
 {
   mIconTextPadding = padding;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -19797,6 +21265,8 @@ QCPTextElement::QCPTextElement(QCustomPlot *parentPlot, const QString &text, con
 void QCPTextElement::setText(const QString &text)
 {
   mText = text;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -19822,6 +21292,8 @@ void QCPTextElement::setText(const QString &text)
 void QCPTextElement::setTextFlags(int flags)
 {
   mTextFlags = flags;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -19832,6 +21304,8 @@ void QCPTextElement::setTextFlags(int flags)
 void QCPTextElement::setFont(const QFont &font)
 {
   mFont = font;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -20232,6 +21706,8 @@ void QCPColorScale::setType(QCPAxis::AxisType type)
     connect(mColorAxis.data(), SIGNAL(scaleTypeChanged(QCPAxis::ScaleType)), this, SLOT(setDataScaleType(QCPAxis::ScaleType)));
     mAxisRect.data()->setRangeDragAxes(QList<QCPAxis*>() << mColorAxis.data());
   }
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -20326,6 +21802,8 @@ void QCPColorScale::setLabel(const QString &str)
 void QCPColorScale::setBarWidth(int width)
 {
   mBarWidth = width;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -20880,7 +22358,8 @@ QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   QCPAbstractPlottable1D<QCPGraphData>(keyAxis, valueAxis),
   mLineStyle{},
   mScatterSkip{},
-  mAdaptiveSampling{}
+  mAdaptiveSampling{},
+  mSamplingIndices(nullptr)
 {
   // special handling for QCPGraphs to maintain the simple graph interface:
   mParentPlot->registerGraph(this);
@@ -21130,17 +22609,67 @@ void QCPGraph::draw(QCPPainter *painter)
   if (mLineStyle == lsNone && mScatterStyle.isNone()) return;
   
   QVector<QPointF> lines, scatters; // line and (if necessary) scatter pixel coordinates will be stored here while iterating over segments
+  QCPReplotProfile *profile = mParentPlot->activeProfile();
   
-  // loop over and draw segments of unselected/selected data:
   QList<QCPDataRange> selectedSegments, unselectedSegments, allSegments;
   getDataSegments(selectedSegments, unselectedSegments);
   allSegments << unselectedSegments << selectedSegments;
+  
+  // sample the visible data once for all segments. Sampling intervals are closed at the segment
+  // borders, so each segment can be cut out of the shared points via their data indices. For lines,
+  // the data points next to a border are kept as single points, because unselected segments extend
+  // their lines to the bordering selected data point:
+  QVector<int> lineBorders, scatterBorders;
+  for (int i=0; i<allSegments.size(); ++i)
+  {
+    const int borders[] = {allSegments.at(i).begin(), allSegments.at(i).end()};
+    for (int k=0; k<2; ++k)
+    {
+      lineBorders << borders[k]-1 << borders[k] << borders[k]+1;
+      scatterBorders << borders[k];
+    }
+  }
+  std::sort(lineBorders.begin(), lineBorders.end());
+  lineBorders.erase(std::unique(lineBorders.begin(), lineBorders.end()), lineBorders.end());
+  std::sort(scatterBorders.begin(), scatterBorders.end());
+  scatterBorders.erase(std::unique(scatterBorders.begin(), scatterBorders.end()), scatterBorders.end());
+  
+  QCPGraphDataContainer::const_iterator visibleBegin, visibleEnd;
+  getVisibleDataBounds(visibleBegin, visibleEnd, mDataContainer->dataRange());
+  QVector<QCPGraphData> lineData, scatterData;
+  QVector<int> lineDataIndices, scatterDataIndices;
+  bool scatterDataSampled = false;
+  int profileEvent = profile ? profile->beginEvent(QLatin1String("getOptimizedLineData"), QLatin1String("data")) : -1;
+  if (mLineStyle != lsNone && visibleBegin != visibleEnd)
+  {
+    mSamplingBorders = lineBorders;
+    mSamplingIndices = &lineDataIndices;
+    getOptimizedLineData(&lineData, visibleBegin, visibleEnd);
+    mSamplingIndices = nullptr;
+    mSamplingBorders.clear();
+  }
+  // a reimplementation of getOptimizedLineData may not provide data indices, then each segment is sampled separately:
+  const bool sharedLineData = lineDataIndices.size() == lineData.size();
+  if (profile)
+    profile->endEvent(profileEvent, visibleEnd-visibleBegin, lineData.size());
+  updateChannelFillLines();
+  
+  // loop over and draw segments of unselected/selected data:
   for (int i=0; i<allSegments.size(); ++i)
   {
     bool isSelectedSegment = i >= unselectedSegments.size();
     // get line pixel points appropriate to line style:
     QCPDataRange lineDataRange = isSelectedSegment ? allSegments.at(i) : allSegments.at(i).adjusted(-1, 1); // unselected segments extend lines to bordering selected data point (safe to exceed total data bounds in first/last segment, getLines takes care)
-    getLines(&lines, lineDataRange);
+    profileEvent = profile ? profile->beginEvent(QLatin1String("getLines"), QLatin1String("data")) : -1;
+    if (sharedLineData)
+      getLines(&lines, lineData, lineDataIndices, lineDataRange);
+    else
+      getLines(&lines, lineDataRange);
+    if (profile)
+    {
+      profile->endEvent(profileEvent, -1, lines.size());
+      profileEvent = profile->beginEvent(QLatin1String("drawFill and drawLinePlot"), QLatin1String("painting"));
+    }
     
     // check data validity if flag set:
 #ifdef QCUSTOMPLOT_CHECK_DATA
@@ -21173,6 +22702,8 @@ void QCPGraph::draw(QCPPainter *painter)
       else
         drawLinePlot(painter, lines); // also step plots can be drawn as a line plot
     }
+    if (profile)
+      profile->endEvent(profileEvent);
     
     // draw scatters:
     QCPScatterStyle finalScatterStyle = mScatterStyle;
@@ -21180,8 +22711,28 @@ void QCPGraph::draw(QCPPainter *painter)
       finalScatterStyle = mSelectionDecorator->getFinalScatterStyle(mScatterStyle);
     if (!finalScatterStyle.isNone())
     {
-      getScatters(&scatters, allSegments.at(i));
+      profileEvent = profile ? profile->beginEvent(QLatin1String("getScatters"), QLatin1String("data")) : -1;
+      if (!scatterDataSampled && visibleBegin != visibleEnd)
+      {
+        mSamplingBorders = scatterBorders;
+        mSamplingIndices = &scatterDataIndices;
+        getOptimizedScatterData(&scatterData, visibleBegin, visibleEnd);
+        mSamplingIndices = nullptr;
+        mSamplingBorders.clear();
+      }
+      scatterDataSampled = true;
+      if (scatterDataIndices.size() == scatterData.size())
+        getScatters(&scatters, scatterData, scatterDataIndices, allSegments.at(i));
+      else // reimplemented getOptimizedScatterData without data indices
+        getScatters(&scatters, allSegments.at(i));
+      if (profile)
+      {
+        profile->endEvent(profileEvent, -1, scatters.size());
+        profileEvent = profile->beginEvent(QLatin1String("drawScatterPlot"), QLatin1String("painting"));
+      }
       drawScatterPlot(painter, scatters, finalScatterStyle);
+      if (profile)
+        profile->endEvent(profileEvent);
     }
   }
   
@@ -21259,19 +22810,32 @@ void QCPGraph::getLines(QVector<QPointF> *lines, const QCPDataRange &dataRange)
   QVector<QCPGraphData> lineData;
   if (mLineStyle != lsNone)
     getOptimizedLineData(&lineData, begin, end);
-  
-  if (mKeyAxis->rangeReversed() != (mKeyAxis->orientation() == Qt::Vertical)) // make sure key pixels are sorted ascending in lineData (significantly simplifies following processing)
-    std::reverse(lineData.begin(), lineData.end());
+  dataToStyledLines(lines, lineData);
+}
 
-  switch (mLineStyle)
+/*! \internal
+
+  This is an overload of \ref getLines which doesn't sample the data itself, but cuts the points
+  belonging to \a dataRange out of the already sampled \a lineData. \a dataIndices must hold the
+  data index of each point in \a lineData, as returned by \ref sampleLineData, and the begin and
+  end of \a dataRange must have been passed to it as segment borders.
+  
+  \ref draw samples the visible data once and uses this overload for every selected and unselected
+  segment, so a graph with many selected ranges costs the same sampling effort as an unselected one.
+  As in \ref getLines, \a dataRange may exceed the total data bounds.
+*/
+void QCPGraph::getLines(QVector<QPointF> *lines, const QVector<QCPGraphData> &lineData, const QVector<int> &dataIndices, const QCPDataRange &dataRange) const
+{
+  if (!lines) return;
+  const int first = int(std::lower_bound(dataIndices.constBegin(), dataIndices.constEnd(), dataRange.begin())-dataIndices.constBegin());
+  const int last = int(std::lower_bound(dataIndices.constBegin()+first, dataIndices.constEnd(), dataRange.end())-dataIndices.constBegin());
+  if (first >= last)
   {
-    case lsNone: lines->clear(); break;
-    case lsLine: *lines = dataToLines(lineData); break;
-    case lsStepLeft: *lines = dataToStepLeftLines(lineData); break;
-    case lsStepRight: *lines = dataToStepRightLines(lineData); break;
-    case lsStepCenter: *lines = dataToStepCenterLines(lineData); break;
-    case lsImpulse: *lines = dataToImpulseLines(lineData); break;
+    lines->clear();
+    return;
   }
+  QVector<QCPGraphData> segmentData = lineData.mid(first, last-first);
+  dataToStyledLines(lines, segmentData);
 }
 
 /*! \internal
@@ -21303,8 +22867,70 @@ void QCPGraph::getScatters(QVector<QPointF> *scatters, const QCPDataRange &dataR
   
   QVector<QCPGraphData> data;
   getOptimizedScatterData(&data, begin, end);
+  dataToScatters(scatters, data);
+}
+
+/*! \internal
+
+  This is an overload of \ref getScatters which doesn't sample the data itself, but cuts the points
+  belonging to \a dataRange out of the already sampled \a scatterData. \a dataIndices must hold
+  the data index of each point in \a scatterData, as returned by \ref sampleScatterData, and the
+  begin and end of \a dataRange must have been passed to it as segment borders.
   
-  if (mKeyAxis->rangeReversed() != (mKeyAxis->orientation() == Qt::Vertical)) // make sure key pixels are sorted ascending in data (significantly simplifies following processing)
+  \see getLines(QVector<QPointF> *lines, const QVector<QCPGraphData> &lineData, const QVector<int> &dataIndices, const QCPDataRange &dataRange) const
+*/
+void QCPGraph::getScatters(QVector<QPointF> *scatters, const QVector<QCPGraphData> &scatterData, const QVector<int> &dataIndices, const QCPDataRange &dataRange) const
+{
+  if (!scatters) return;
+  const int first = int(std::lower_bound(dataIndices.constBegin(), dataIndices.constEnd(), dataRange.begin())-dataIndices.constBegin());
+  const int last = int(std::lower_bound(dataIndices.constBegin()+first, dataIndices.constEnd(), dataRange.end())-dataIndices.constBegin());
+  if (first >= last)
+  {
+    scatters->clear();
+    return;
+  }
+  QVector<QCPGraphData> segmentData = scatterData.mid(first, last-first);
+  dataToScatters(scatters, segmentData);
+}
+
+/*! \internal
+
+  Converts the sampled line points in \a lineData to pixel coordinates according to the line
+  style of the graph, and returns them via \a lines. \a lineData is expected in data order and
+  may be reordered by this method.
+  
+  This is the common last step of both \ref getLines overloads.
+*/
+void QCPGraph::dataToStyledLines(QVector<QPointF> *lines, QVector<QCPGraphData> &lineData) const
+{
+  if (mKeyAxis->rangeReversed() != (mKeyAxis->orientation() == Qt::Vertical)) // make sure key pixels are sorted ascending in lineData (significantly simplifies following processing)
+    std::reverse(lineData.begin(), lineData.end());
+
+  switch (mLineStyle)
+  {
+    case lsNone: lines->clear(); break;
+    case lsLine: *lines = dataToLines(lineData); break;
+    case lsStepLeft: *lines = dataToStepLeftLines(lineData); break;
+    case lsStepRight: *lines = dataToStepRightLines(lineData); break;
+    case lsStepCenter: *lines = dataToStepCenterLines(lineData); break;
+    case lsImpulse: *lines = dataToImpulseLines(lineData); break;
+  }
+}
+
+/*! \internal
+
+  Converts the sampled scatter points in \a data to pixel coordinates and returns them via \a
+  scatters. \a data is expected in data order and may be reordered by this method.
+  
+  This is the common last step of both \ref getScatters overloads.
+*/
+void QCPGraph::dataToScatters(QVector<QPointF> *scatters, QVector<QCPGraphData> &data) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; scatters->clear(); return; }
+  
+  if (keyAxis->rangeReversed() != (keyAxis->orientation() == Qt::Vertical)) // make sure key pixels are sorted ascending in data (significantly simplifies following processing)
     std::reverse(data.begin(), data.end());
   
   scatters->resize(data.size());
@@ -21585,6 +23211,26 @@ QVector<QPointF> QCPGraph::dataToImpulseLines(const QVector<QCPGraphData> &data)
   return result;
 }
 
+/*! \internal
+  
+  Retrieves the lines of the channel fill graph (see \ref setChannelFillGraph) and their non-NaN
+  segments, and keeps them for \ref drawFill. This is called once at the beginning of \ref draw,
+  so the channel fill graph is sampled only once per replot, no matter how many selected and
+  unselected segments this graph is drawn in.
+*/
+void QCPGraph::updateChannelFillLines()
+{
+  const bool hasFill = mBrush.style() != Qt::NoBrush || (mSelectionDecorator && !mSelection.isEmpty() && mSelectionDecorator->brush().style() != Qt::NoBrush);
+  if (!mChannelFillGraph || mLineStyle == lsImpulse || !hasFill)
+  {
+    mChannelFillLines.clear();
+    mChannelFillSegments.clear();
+    return;
+  }
+  mChannelFillGraph->getLines(&mChannelFillLines, QCPDataRange(0, mChannelFillGraph->dataCount()));
+  mChannelFillSegments = getNonNanSegments(&mChannelFillLines, mChannelFillGraph->keyAxis()->orientation());
+}
+
 /*! \internal
   
   Draws the fill of the graph using the specified \a painter, with the currently set brush.
@@ -21596,7 +23242,9 @@ QVector<QPointF> QCPGraph::dataToImpulseLines(const QVector<QCPGraphData> &data)
   this method first determines a list of non-NaN segments with \ref getNonNanSegments, on which to
   operate. In the channel fill case, \ref getOverlappingSegments is used to consolidate the non-NaN
   segments of the two involved graphs, before passing the overlapping pairs to \ref
-  getChannelFillPolygon.
+  getChannelFillPolygon. The lines of the channel fill graph are taken from \ref
+  updateChannelFillLines, which \ref draw calls once per replot, and all polygons of one fill are
+  built in the same reused buffer.
   
   Pass the points of this graph's line as \a lines, in pixel coordinates.
 
@@ -21616,15 +23264,15 @@ void QCPGraph::drawFill(QCPPainter *painter, QVector<QPointF> *lines) const
       painter->drawPolygon(getFillPolygon(lines, segment));
   } else
   {
-    // draw fill between this graph and mChannelFillGraph:
-    QVector<QPointF> otherLines;
-    mChannelFillGraph->getLines(&otherLines, QCPDataRange(0, mChannelFillGraph->dataCount()));
-    if (!otherLines.isEmpty())
+    // draw fill between this graph and mChannelFillGraph, whose lines were prepared once per replot by updateChannelFillLines:
+    if (!mChannelFillLines.isEmpty())
     {
-      QVector<QCPDataRange> otherSegments = getNonNanSegments(&otherLines, mChannelFillGraph->keyAxis()->orientation());
-      QVector<QPair<QCPDataRange, QCPDataRange> > segmentPairs = getOverlappingSegments(segments, lines, otherSegments, &otherLines);
+      QVector<QPair<QCPDataRange, QCPDataRange> > segmentPairs = getOverlappingSegments(segments, lines, mChannelFillSegments, &mChannelFillLines);
       for (int i=0; i<segmentPairs.size(); ++i)
-        painter->drawPolygon(getChannelFillPolygon(lines, segmentPairs.at(i).first, &otherLines, segmentPairs.at(i).second));
+      {
+        if (getChannelFillPolygon(&mChannelFillPolygon, lines, segmentPairs.at(i).first, &mChannelFillLines, segmentPairs.at(i).second))
+          painter->drawPolygon(mChannelFillPolygon);
+      }
     }
   }
 }
@@ -21689,17 +23337,40 @@ void QCPGraph::drawImpulsePlot(QCPPainter *painter, const QVector<QPointF> &line
   further by \a begin and \a end, e.g. to only plot a certain segment of the data (see \ref
   getDataSegments).
 
-  This method is used by \ref getLines to retrieve the basic working set of data.
+  This method is used by \ref getLines to retrieve the basic working set of data. The sampling
+  itself is done by \ref sampleLineData.
 
   \see getOptimizedScatterData
 */
 void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const
+{
+  sampleLineData(lineData, begin, end, mSamplingBorders, mSamplingIndices);
+}
+
+/*! \internal
+
+  Samples the data between \a begin and \a end for \ref getOptimizedLineData. Adaptive sampling
+  consolidates the data points of each pixel to a cluster, but a cluster is also closed at every
+  data index in \a segmentBorders (ascending), so no cluster mixes data points of different
+  selection segments. Clusters delimited by a border are placed within the keys of their own first
+  and last data point (see \ref appendBorderCluster), which keeps the keys of the output
+  ascending.
+
+  If \a dataIndices is provided, it receives the index of the first data point of the interval
+  each returned point belongs to. Because no interval crosses a border, a segment starting and
+  ending at borders can be cut out of the returned points by their indices, see \ref getLines.
+  \a lineData and \a dataIndices are expected to be empty.
+
+  \see sampleScatterData
+*/
+void QCPGraph::sampleLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end, const QVector<int> &segmentBorders, QVector<int> *dataIndices) const
 {
   if (!lineData) return;
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
   if (begin == end) return;
+  const QCPGraphDataContainer::const_iterator dataBegin = mDataContainer->constBegin();
   
   int dataCount = int(end-begin);
   int maxCount = (std::numeric_limits<int>::max)();
@@ -21723,10 +23394,13 @@ void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGr
     double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
     bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
     int intervalDataCount = 1;
+    int borderIndex = int(std::upper_bound(segmentBorders.constBegin(), segmentBorders.constEnd(), int(begin-dataBegin))-segmentBorders.constBegin()); // next border ahead of the first data point
+    bool intervalAtBorder = false; // whether the current interval was started by a segment border instead of a new pixel
     ++it; // advance iterator to second data point because adaptive sampling works in 1 point retrospect
     while (it != end)
     {
-      if (it->key < currentIntervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this cluster if necessary
+      const bool atBorder = passSegmentBorder(segmentBorders, borderIndex, int(it-dataBegin));
+      if (!atBorder && it->key < currentIntervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this cluster if necessary
       {
         if (it->value < minValue)
           minValue = it->value;
@@ -21735,7 +23409,10 @@ void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGr
         ++intervalDataCount;
       } else // new pixel interval started
       {
-        if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
+        if (intervalDataCount >= 2 && (intervalAtBorder || atBorder)) // cluster is delimited by a segment border, so keep it within the keys of its own data points
+        {
+          appendBorderCluster(lineData, *currentIntervalFirstPoint, *(it-1), minValue, maxValue);
+        } else if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
         {
           if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
             lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint->value));
@@ -21745,6 +23422,9 @@ void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGr
             lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.8, (it-1)->value));
         } else
           lineData->append(QCPGraphData(currentIntervalFirstPoint->key, currentIntervalFirstPoint->value));
+        if (dataIndices) // all points of an interval are assigned to its first data point
+          dataIndices->insert(dataIndices->size(), lineData->size()-dataIndices->size(), int(currentIntervalFirstPoint-dataBegin));
+        intervalAtBorder = atBorder;
         lastIntervalEndKey = (it-1)->key;
         minValue = it->value;
         maxValue = it->value;
@@ -21757,7 +23437,10 @@ void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGr
       ++it;
     }
     // handle last interval:
-    if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
+    if (intervalDataCount >= 2 && intervalAtBorder) // cluster is delimited by a segment border, so keep it within the keys of its own data points
+    {
+      appendBorderCluster(lineData, *currentIntervalFirstPoint, *(end-1), minValue, maxValue);
+    } else if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
     {
       if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point wasn't a cluster, so first point of this cluster must be at a real data point
         lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint->value));
@@ -21765,11 +23448,20 @@ void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGr
       lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
     } else
       lineData->append(QCPGraphData(currentIntervalFirstPoint->key, currentIntervalFirstPoint->value));
+    if (dataIndices)
+      dataIndices->insert(dataIndices->size(), lineData->size()-dataIndices->size(), int(currentIntervalFirstPoint-dataBegin));
     
   } else // don't use adaptive sampling algorithm, transfer points one-to-one from the data container into the output
   {
     lineData->resize(dataCount);
     std::copy(begin, end, lineData->begin());
+    if (dataIndices)
+    {
+      const int beginIndex = int(begin-dataBegin);
+      dataIndices->resize(dataCount);
+      for (int i=0; i<dataCount; ++i)
+        (*dataIndices)[i] = beginIndex+i;
+    }
   }
 }
 
@@ -21781,11 +23473,26 @@ void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGr
   further by \a begin and \a end, e.g. to only plot a certain segment of the data (see \ref
   getDataSegments).
 
-  This method is used by \ref getScatters to retrieve the basic working set of data.
+  This method is used by \ref getScatters to retrieve the basic working set of data. The sampling
+  itself is done by \ref sampleScatterData.
 
   \see getOptimizedLineData
 */
 void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGraphDataContainer::const_iterator begin, QCPGraphDataContainer::const_iterator end) const
+{
+  sampleScatterData(scatterData, begin, end, mSamplingBorders, mSamplingIndices);
+}
+
+/*! \internal
+
+  Samples the data between \a begin and \a end for \ref getOptimizedScatterData. As in \ref
+  sampleLineData, adaptive sampling intervals are closed at every data index in \a
+  segmentBorders, so each selection segment thins out its own data points. If \a dataIndices is
+  provided, it receives the data index of each returned point, in ascending order.
+
+  \see sampleLineData
+*/
+void QCPGraph::sampleScatterData(QVector<QCPGraphData> *scatterData, QCPGraphDataContainer::const_iterator begin, QCPGraphDataContainer::const_iterator end, const QVector<int> &segmentBorders, QVector<int> *dataIndices) const
 {
   if (!scatterData) return;
   QCPAxis *keyAxis = mKeyAxis.data();
@@ -21827,10 +23534,13 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
     double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
     bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
     int intervalDataCount = 1;
+    int borderIndex = int(std::upper_bound(segmentBorders.constBegin(), segmentBorders.constEnd(), beginIndex)-segmentBorders.constBegin()); // next border ahead of the first data point
     // advance iterator to second (non-skipped) data point because adaptive sampling works in 1 point retrospect:
     if (!doScatterSkip)
+    {
       ++it;
-    else
+      ++itIndex;
+    } else
     {
       itIndex += scatterModulo;
       if (itIndex < endIndex) // make sure we didn't jump over end
@@ -21844,7 +23554,8 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
     // main loop over data points:
     while (it != end)
     {
-      if (it->key < currentIntervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this pixel if necessary
+      const bool atBorder = passSegmentBorder(segmentBorders, borderIndex, itIndex); // with scatter skip, it may jump over a border, which then also starts a new interval
+      if (!atBorder && it->key < currentIntervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this pixel if necessary
       {
         if (it->value < minValue && it->value > valueMinRange && it->value < valueMaxRange)
         {
@@ -21868,7 +23579,11 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
           while (intervalIt != it)
           {
             if ((c % dataModulo == 0 || intervalIt == minValueIt || intervalIt == maxValueIt) && intervalIt->value > valueMinRange && intervalIt->value < valueMaxRange)
+            {
               scatterData->append(*intervalIt);
+              if (dataIndices)
+                dataIndices->append(int(intervalIt-mDataContainer->constBegin()));
+            }
             ++c;
             if (!doScatterSkip)
               ++intervalIt;
@@ -21876,7 +23591,11 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
               intervalIt += scatterModulo; // since we know indices of "currentIntervalStart", "intervalIt" and "it" are multiples of scatterModulo, we can't accidentally jump over "it" here
           }
         } else if (currentIntervalStart->value > valueMinRange && currentIntervalStart->value < valueMaxRange)
+        {
           scatterData->append(*currentIntervalStart);
+          if (dataIndices)
+            dataIndices->append(int(currentIntervalStart-mDataContainer->constBegin()));
+        }
         minValue = it->value;
         maxValue = it->value;
         currentIntervalStart = it;
@@ -21887,8 +23606,10 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
       }
       // advance to next data point:
       if (!doScatterSkip)
+      {
         ++it;
-      else
+        ++itIndex;
+      } else
       {
         itIndex += scatterModulo;
         if (itIndex < endIndex) // make sure we didn't jump over end
@@ -21912,7 +23633,11 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
       while (intervalIt != it)
       {
         if ((c % dataModulo == 0 || intervalIt == minValueIt || intervalIt == maxValueIt) && intervalIt->value > valueMinRange && intervalIt->value < valueMaxRange)
+        {
           scatterData->append(*intervalIt);
+          if (dataIndices)
+            dataIndices->append(int(intervalIt-mDataContainer->constBegin()));
+        }
         ++c;
         if (!doScatterSkip)
           ++intervalIt;
@@ -21929,16 +23654,24 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
         }
       }
     } else if (currentIntervalStart->value > valueMinRange && currentIntervalStart->value < valueMaxRange)
+    {
       scatterData->append(*currentIntervalStart);
+      if (dataIndices)
+        dataIndices->append(int(currentIntervalStart-mDataContainer->constBegin()));
+    }
     
   } else // don't use adaptive sampling algorithm, transfer points one-to-one from the data container into the output
   {
     QCPGraphDataContainer::const_iterator it = begin;
     int itIndex = beginIndex;
     scatterData->reserve(dataCount);
+    if (dataIndices)
+      dataIndices->reserve(dataCount);
     while (it != end)
     {
       scatterData->append(*it);
+      if (dataIndices)
+        dataIndices->append(int(it-mDataContainer->constBegin()));
       // advance to next data point:
       if (!doScatterSkip)
         ++it;
@@ -21957,6 +23690,41 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
   }
 }
 
+/*! \internal
+
+  Used by \ref sampleLineData and \ref sampleScatterData while walking over the data. Advances \a
+  borderIndex past all entries of the ascending \a segmentBorders up to \a dataIndex, and returns
+  whether any border was passed, i.e. whether a new sampling interval must start at \a dataIndex.
+*/
+bool QCPGraph::passSegmentBorder(const QVector<int> &segmentBorders, int &borderIndex, int dataIndex)
+{
+  bool passed = false;
+  while (borderIndex < segmentBorders.size() && segmentBorders.at(borderIndex) <= dataIndex)
+  {
+    passed = true;
+    ++borderIndex;
+  }
+  return passed;
+}
+
+/*! \internal
+
+  Appends the line points of an adaptive sampling cluster which is delimited by a segment border
+  (see \ref sampleLineData) to \a lineData. Unlike regular clusters, which are placed at fixed
+  fractions of their pixel, the cluster starts at its first data point \a first and ends at its
+  last data point \a last, with the value extremes \a minValue and \a maxValue in between. This
+  keeps the keys ascending even if several clusters share a pixel, and lets the lines of
+  neighbouring segments meet at real data points.
+*/
+void QCPGraph::appendBorderCluster(QVector<QCPGraphData> *lineData, const QCPGraphData &first, const QCPGraphData &last, double minValue, double maxValue)
+{
+  const double keySpan = last.key-first.key;
+  lineData->append(QCPGraphData(first.key, first.value));
+  lineData->append(QCPGraphData(first.key+keySpan*0.25, minValue));
+  lineData->append(QCPGraphData(first.key+keySpan*0.75, maxValue));
+  lineData->append(QCPGraphData(last.key, last.value));
+}
+
 /*!
   This method outputs the currently visible data range via \a begin and \a end. The returned range
   will also never exceed \a rangeRestriction.
@@ -22236,107 +24004,127 @@ const QPolygonF QCPGraph::getFillPolygon(const QVector<QPointF> *lineData, QCPDa
   \ref getOverlappingSegments, to make sure only segments that actually have key coordinate overlap
   need to be processed here.
   
-  For increased performance due to implicit sharing, keep the returned QPolygonF const.
+  For increased performance due to implicit sharing, keep the returned QPolygonF const. \ref
+  drawFill uses the overload writing into a reused polygon instead.
   
   \see drawFill, getOverlappingSegments, getNonNanSegments
 */
 const QPolygonF QCPGraph::getChannelFillPolygon(const QVector<QPointF> *thisData, QCPDataRange thisSegment, const QVector<QPointF> *otherData, QCPDataRange otherSegment) const
 {
-  if (!mChannelFillGraph)
+  QPolygonF result;
+  if (!getChannelFillPolygon(&result, thisData, thisSegment, otherData, otherSegment))
     return QPolygonF();
+  return result;
+}
+
+/*! \internal
+  
+  This is an overload of \ref getChannelFillPolygon which writes the channel fill polygon into \a
+  polygon, reusing its allocated memory. Returns false if the segments produce no fill, in which
+  case the content of \a polygon is undefined.
+  
+  Both segments are cropped to the key range they have in common, further limited to the key
+  extent of the axis rect. The crop positions are found with a binary search and the boundary
+  points are linearly interpolated, so the polygon is assembled in a single pass over the points
+  inside the common key range, without copying the segments first.
+*/
+bool QCPGraph::getChannelFillPolygon(QPolygonF *polygon, const QVector<QPointF> *thisData, QCPDataRange thisSegment, const QVector<QPointF> *otherData, QCPDataRange otherSegment) const
+{
+  if (!mChannelFillGraph)
+    return false;
   
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
-  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return QPolygonF(); }
-  if (!mChannelFillGraph.data()->mKeyAxis) { qDebug() << Q_FUNC_INFO << "channel fill target key axis invalid"; return QPolygonF(); }
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return false; }
+  if (!mChannelFillGraph.data()->mKeyAxis) { qDebug() << Q_FUNC_INFO << "channel fill target key axis invalid"; return false; }
   
   if (mChannelFillGraph.data()->mKeyAxis.data()->orientation() != keyAxis->orientation())
-    return QPolygonF(); // don't have same axis orientation, can't fill that (Note: if keyAxis fits, valueAxis will fit too, because it's always orthogonal to keyAxis)
-  
-  if (thisData->isEmpty()) return QPolygonF();
-  QVector<QPointF> thisSegmentData(thisSegment.size());
-  QVector<QPointF> otherSegmentData(otherSegment.size());
-  std::copy(thisData->constBegin()+thisSegment.begin(), thisData->constBegin()+thisSegment.end(), thisSegmentData.begin());
-  std::copy(otherData->constBegin()+otherSegment.begin(), otherData->constBegin()+otherSegment.end(), otherSegmentData.begin());
-  // pointers to be able to swap them, depending which data range needs cropping:
-  QVector<QPointF> *staticData = &thisSegmentData;
-  QVector<QPointF> *croppedData = &otherSegmentData;
-  
-  // crop both vectors to ranges in which the keys overlap (which coord is key, depends on axisType):
-  if (keyAxis->orientation() == Qt::Horizontal)
+    return false; // don't have same axis orientation, can't fill that (Note: if keyAxis fits, valueAxis will fit too, because it's always orthogonal to keyAxis)
+  
+  if (thisData->isEmpty() || otherData->isEmpty() || thisSegment.size() < 2 || otherSegment.size() < 2)
+    return false;
+  
+  // determine the key range both segments have in common, limited to the axis rect (keys are ascending in pixels, see getLines):
+  const bool verticalKey = keyAxis->orientation() == Qt::Vertical;
+  const QPointF &thisFirst = thisData->at(thisSegment.begin());
+  const QPointF &thisLast = thisData->at(thisSegment.end()-1);
+  const QPointF &otherFirst = otherData->at(otherSegment.begin());
+  const QPointF &otherLast = otherData->at(otherSegment.end()-1);
+  double lower = verticalKey ? qMax(thisFirst.y(), otherFirst.y()) : qMax(thisFirst.x(), otherFirst.x());
+  double upper = verticalKey ? qMin(thisLast.y(), otherLast.y()) : qMin(thisLast.x(), otherLast.x());
+  const QRect axisRect = keyAxis->axisRect()->rect();
+  lower = qMax(lower, verticalKey ? axisRect.top()-1.0 : axisRect.left()-1.0);
+  upper = qMin(upper, verticalKey ? axisRect.bottom()+1.0 : axisRect.right()+1.0);
+  if (!(lower < upper))
+    return false; // key ranges have no overlap (inside the axis rect)
+  
+  // points strictly inside (lower, upper) are copied, the points at lower and upper are interpolated from the enclosing pairs:
+  const int thisBegin = qMax(thisSegment.begin()+1, findKeyIndex(thisData, thisSegment, lower, verticalKey, false));
+  const int thisEnd = qMin(thisSegment.end()-1, findKeyIndex(thisData, thisSegment, upper, verticalKey, true));
+  const int otherBegin = qMax(otherSegment.begin()+1, findKeyIndex(otherData, otherSegment, lower, verticalKey, false));
+  const int otherEnd = qMin(otherSegment.end()-1, findKeyIndex(otherData, otherSegment, upper, verticalKey, true));
+  const int thisCount = qMax(0, thisEnd-thisBegin);
+  const int otherCount = qMax(0, otherEnd-otherBegin);
+  
+  polygon->resize(thisCount+otherCount+4);
+  QPointF *out = polygon->data();
+  // this segment forward:
+  *out++ = interpolateAtKey(thisData->at(thisBegin-1), thisData->at(thisBegin), lower, verticalKey);
+  out = std::copy(thisData->constBegin()+thisBegin, thisData->constBegin()+thisBegin+thisCount, out);
+  *out++ = interpolateAtKey(thisData->at(thisBegin+thisCount-1), thisData->at(thisBegin+thisCount), upper, verticalKey);
+  // other segment reversed, otherwise the polygon will be twisted:
+  *out++ = interpolateAtKey(otherData->at(otherBegin+otherCount-1), otherData->at(otherBegin+otherCount), upper, verticalKey);
+  out = std::reverse_copy(otherData->constBegin()+otherBegin, otherData->constBegin()+otherBegin+otherCount, out);
+  *out++ = interpolateAtKey(otherData->at(otherBegin-1), otherData->at(otherBegin), lower, verticalKey);
+  return true;
+}
+
+/*! \internal
+  
+  Returns the index of the first point within \a segment of \a data whose key pixel coordinate is
+  above \a key, or at or above \a key if \a includeEqual is true. If there is no such point,
+  returns \a segment's end. The key is the y coordinate if \a verticalKey is true, and the x
+  coordinate otherwise. Like \ref findIndexAboveX, this assumes ascending keys, but uses a binary
+  search.
+  
+  Used to calculate the channel fill polygon, see \ref getChannelFillPolygon.
+*/
+int QCPGraph::findKeyIndex(const QVector<QPointF> *data, QCPDataRange segment, double key, bool verticalKey, bool includeEqual)
+{
+  int low = segment.begin();
+  int high = segment.end();
+  while (low < high)
   {
-    // x is key
-    // crop lower bound:
-    if (staticData->first().x() < croppedData->first().x()) // other one must be cropped
-      qSwap(staticData, croppedData);
-    const int lowBound = findIndexBelowX(croppedData, staticData->first().x());
-    if (lowBound == -1) return QPolygonF(); // key ranges have no overlap
-    croppedData->remove(0, lowBound);
-    // set lowest point of cropped data to fit exactly key position of first static data point via linear interpolation:
-    if (croppedData->size() < 2) return QPolygonF(); // need at least two points for interpolation
-    double slope;
-    if (!qFuzzyCompare(croppedData->at(1).x(), croppedData->at(0).x()))
-      slope = (croppedData->at(1).y()-croppedData->at(0).y())/(croppedData->at(1).x()-croppedData->at(0).x());
-    else
-      slope = 0;
-    (*croppedData)[0].setY(croppedData->at(0).y()+slope*(staticData->first().x()-croppedData->at(0).x()));
-    (*croppedData)[0].setX(staticData->first().x());
-    
-    // crop upper bound:
-    if (staticData->last().x() > croppedData->last().x()) // other one must be cropped
-      qSwap(staticData, croppedData);
-    int highBound = findIndexAboveX(croppedData, staticData->last().x());
-    if (highBound == -1) return QPolygonF(); // key ranges have no overlap
-    croppedData->remove(highBound+1, croppedData->size()-(highBound+1));
-    // set highest point of cropped data to fit exactly key position of last static data point via linear interpolation:
-    if (croppedData->size() < 2) return QPolygonF(); // need at least two points for interpolation
-    const int li = croppedData->size()-1; // last index
-    if (!qFuzzyCompare(croppedData->at(li).x(), croppedData->at(li-1).x()))
-      slope = (croppedData->at(li).y()-croppedData->at(li-1).y())/(croppedData->at(li).x()-croppedData->at(li-1).x());
+    const int mid = low+(high-low)/2;
+    const double midKey = verticalKey ? data->at(mid).y() : data->at(mid).x();
+    if (midKey < key || (!includeEqual && midKey == key))
+      low = mid+1;
     else
-      slope = 0;
-    (*croppedData)[li].setY(croppedData->at(li-1).y()+slope*(staticData->last().x()-croppedData->at(li-1).x()));
-    (*croppedData)[li].setX(staticData->last().x());
-  } else // mKeyAxis->orientation() == Qt::Vertical
-  {
-    // y is key
-    // crop lower bound:
-    if (staticData->first().y() < croppedData->first().y()) // other one must be cropped
-      qSwap(staticData, croppedData);
-    int lowBound = findIndexBelowY(croppedData, staticData->first().y());
-    if (lowBound == -1) return QPolygonF(); // key ranges have no overlap
-    croppedData->remove(0, lowBound);
-    // set lowest point of cropped data to fit exactly key position of first static data point via linear interpolation:
-    if (croppedData->size() < 2) return QPolygonF(); // need at least two points for interpolation
-    double slope;
-    if (!qFuzzyCompare(croppedData->at(1).y(), croppedData->at(0).y())) // avoid division by zero in step plots
-      slope = (croppedData->at(1).x()-croppedData->at(0).x())/(croppedData->at(1).y()-croppedData->at(0).y());
-    else
-      slope = 0;
-    (*croppedData)[0].setX(croppedData->at(0).x()+slope*(staticData->first().y()-croppedData->at(0).y()));
-    (*croppedData)[0].setY(staticData->first().y());
-    
-    // crop upper bound:
-    if (staticData->last().y() > croppedData->last().y()) // other one must be cropped
-      qSwap(staticData, croppedData);
-    int highBound = findIndexAboveY(croppedData, staticData->last().y());
-    if (highBound == -1) return QPolygonF(); // key ranges have no overlap
-    croppedData->remove(highBound+1, croppedData->size()-(highBound+1));
-    // set highest point of cropped data to fit exactly key position of last static data point via linear interpolation:
-    if (croppedData->size() < 2) return QPolygonF(); // need at least two points for interpolation
-    int li = croppedData->size()-1; // last index
-    if (!qFuzzyCompare(croppedData->at(li).y(), croppedData->at(li-1).y())) // avoid division by zero in step plots
-      slope = (croppedData->at(li).x()-croppedData->at(li-1).x())/(croppedData->at(li).y()-croppedData->at(li-1).y());
-    else
-      slope = 0;
-    (*croppedData)[li].setX(croppedData->at(li-1).x()+slope*(staticData->last().y()-croppedData->at(li-1).y()));
-    (*croppedData)[li].setY(staticData->last().y());
+      high = mid;
   }
+  return low;
+}
+
+/*! \internal
   
-  // return joined:
-  for (int i=otherSegmentData.size()-1; i>=0; --i) // insert reversed, otherwise the polygon will be twisted
-    thisSegmentData << otherSegmentData.at(i);
-  return QPolygonF(thisSegmentData);
+  Returns the point at the key pixel coordinate \a key on the line from \a a to \a b, which is
+  linearly interpolated in the value coordinate. If \a a and \a b share the same key (e.g. at a
+  step of a step plot), the value of \a a is used. \a verticalKey specifies whether the key is the
+  y or x coordinate.
+  
+  Used to calculate the channel fill polygon, see \ref getChannelFillPolygon.
+*/
+QPointF QCPGraph::interpolateAtKey(const QPointF &a, const QPointF &b, double key, bool verticalKey)
+{
+  if (verticalKey)
+  {
+    const double slope = !qFuzzyCompare(b.y(), a.y()) ? (b.x()-a.x())/(b.y()-a.y()) : 0; // avoid division by zero in step plots
+    return {a.x()+slope*(key-a.y()), key};
+  } else
+  {
+    const double slope = !qFuzzyCompare(b.x(), a.x()) ? (b.y()-a.y())/(b.x()-a.x()) : 0;
+    return {key, a.y()+slope*(key-a.x())};
+  }
 }
 
 /*! \internal
@@ -22438,18 +24226,35 @@ double QCPGraph::pointDistance(const QPointF &pixelPoint, QCPGraphDataContainer:
   // iterate over found data points and then choose the one with the shortest distance to pos:
   QCPGraphDataContainer::const_iterator begin = mDataContainer->findBegin(posKeyMin, true);
   QCPGraphDataContainer::const_iterator end = mDataContainer->findEnd(posKeyMax, true);
-  for (QCPGraphDataContainer::const_iterator it=begin; it!=end; ++it)
+  if (spatialIndex())
   {
-    const double currentDistSqr = QCPVector2D(coordsToPixels(it->key, it->value)-pixelPoint).lengthSquared();
-    if (currentDistSqr < minDistSqr)
+    const int closestIndex = indexedClosestData(pixelPoint, QCPDataRange(int(begin-mDataContainer->constBegin()), int(end-mDataContainer->constBegin())), false, minDistSqr);
+    if (closestIndex >= 0)
+      closestData = mDataContainer->constBegin()+closestIndex;
+  } else
+  {
+    for (QCPGraphDataContainer::const_iterator it=begin; it!=end; ++it)
     {
-      minDistSqr = currentDistSqr;
-      closestData = it;
+      const double currentDistSqr = QCPVector2D(coordsToPixels(it->key, it->value)-pixelPoint).lengthSquared();
+      if (currentDistSqr < minDistSqr)
+      {
+        minDistSqr = currentDistSqr;
+        closestData = it;
+      }
     }
   }
     
   // calculate distance to graph line if there is one (if so, will probably be smaller than distance to closest data point):
-  if (mLineStyle != lsNone)
+  if (mLineStyle != lsNone && mLineStyle != lsImpulse && spatialIndex())
+  {
+    // only visit line segments whose index node may be closer than the closest segment found so far:
+    QCPGraphDataContainer::const_iterator visibleBegin, visibleEnd;
+    getVisibleDataBounds(visibleBegin, visibleEnd, QCPDataRange(0, dataCount()));
+    const int segmentBegin = int(visibleBegin-mDataContainer->constBegin());
+    const int segmentEnd = int(visibleEnd-mDataContainer->constBegin())-1; // last visible data point doesn't start a segment
+    if (segmentEnd > segmentBegin)
+      minDistSqr = indexedLineDistanceSqr(pixelPoint, QCPDataRange(segmentBegin, segmentEnd), minDistSqr);
+  } else if (mLineStyle != lsNone)
   {
     // line displayed, calculate distance to line segments:
     QVector<QPointF> lineData;
@@ -22467,6 +24272,55 @@ double QCPGraph::pointDistance(const QPointF &pixelPoint, QCPGraphDataContainer:
   return qSqrt(minDistSqr);
 }
 
+/*! \internal
+  
+  Reimplements the segment distance used by the indexed hit test (see \ref setSpatialIndexing), to
+  take the step line styles into account. The step corners are calculated in pixel coordinates
+  just like in \ref dataToStepLeftLines, \ref dataToStepRightLines and \ref dataToStepCenterLines.
+  
+  \seebaseclassmethod
+*/
+double QCPGraph::indexedSegmentDistanceSqr(const QCPVector2D &pixelPoint, QCPGraphDataContainer::const_iterator segmentStart) const
+{
+  const QCPGraphDataContainer::const_iterator segmentEnd = segmentStart+1;
+  if (qIsNaN(segmentStart->key) || qIsNaN(segmentStart->value) || qIsNaN(segmentEnd->key) || qIsNaN(segmentEnd->value))
+    return (std::numeric_limits<double>::max)();
+  const QPointF start = coordsToPixels(segmentStart->key, segmentStart->value);
+  const QPointF end = coordsToPixels(segmentEnd->key, segmentEnd->value);
+  const bool keyIsVertical = mKeyAxis->orientation() == Qt::Vertical;
+  switch (mLineStyle)
+  {
+    case lsStepLeft: // value of start is held until key of end
+    {
+      const QPointF corner = keyIsVertical ? QPointF(start.x(), end.y()) : QPointF(end.x(), start.y());
+      return qMin(pixelPoint.distanceSquaredToLine(start, corner), pixelPoint.distanceSquaredToLine(corner, end));
+    }
+    case lsStepRight: // value of end is already reached at key of start
+    {
+      const QPointF corner = keyIsVertical ? QPointF(end.x(), start.y()) : QPointF(start.x(), end.y());
+      return qMin(pixelPoint.distanceSquaredToLine(start, corner), pixelPoint.distanceSquaredToLine(corner, end));
+    }
+    case lsStepCenter: // value changes halfway between the keys
+    {
+      QPointF corner1, corner2;
+      if (keyIsVertical)
+      {
+        const double keyCenter = (start.y()+end.y())*0.5;
+        corner1 = QPointF(start.x(), keyCenter);
+        corner2 = QPointF(end.x(), keyCenter);
+      } else
+      {
+        const double keyCenter = (start.x()+end.x())*0.5;
+        corner1 = QPointF(keyCenter, start.y());
+        corner2 = QPointF(keyCenter, end.y());
+      }
+      return qMin(qMin(pixelPoint.distanceSquaredToLine(start, corner1), pixelPoint.distanceSquaredToLine(corner1, corner2)), pixelPoint.distanceSquaredToLine(corner2, end));
+    }
+    default:
+      return pixelPoint.distanceSquaredToLine(start, end);
+  }
+}
+
 /*! \internal
   
   Finds the highest index of \a data, whose points y value is just below \a y. Assumes y values in
@@ -22653,7 +24507,8 @@ QCPCurveData::QCPCurveData(double t, double key, double value) :
 QCPCurve::QCPCurve(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   QCPAbstractPlottable1D<QCPCurveData>(keyAxis, valueAxis),
   mScatterSkip{},
-  mLineStyle{}
+  mLineStyle{},
+  mAdaptiveSampling(true)
 {
   // modify inherited properties from abstract plottable:
   setPen(QPen(Qt::blue, 0));
@@ -22763,6 +24618,24 @@ void QCPCurve::setLineStyle(QCPCurve::LineStyle style)
   mLineStyle = style;
 }
 
+/*!
+  Sets whether adaptive sampling shall be used when drawing the line of this curve.
+  
+  If enabled, consecutive points of the line that lie within one pixel of each other are combined.
+  Of each such group of points only the first and last point and the points with extreme pixel
+  coordinates are kept, so the drawn line still covers the same pixels. This way, curves with
+  millions of points, e.g. long trajectories or Lissajous figures, are drawn with a number of line
+  segments that depends on the length of the curve on screen rather than the number of points.
+  
+  Scatters (\ref setScatterStyle) are not affected. By default, adaptive sampling is enabled.
+  
+  \see QCPGraph::setAdaptiveSampling
+*/
+void QCPCurve::setAdaptiveSampling(bool enabled)
+{
+  mAdaptiveSampling = enabled;
+}
+
 /*! \overload
   
   Adds the provided points in \a t, \a keys and \a values to the current data. The provided vectors
@@ -23062,6 +24935,10 @@ void QCPCurve::drawScatterPlot(QCPPainter *painter, const QVector<QPointF> &poin
 
   Methods that are also involved in the algorithm are: \ref getRegion, \ref getOptimizedPoint, \ref
   getOptimizedCornerPoints \ref mayTraverse, \ref getTraverse, \ref getTraverseCornerPoints.
+  
+  The regions of all points are determined up front in a single branch-free pass, equivalent to
+  \ref getRegion. If adaptive sampling is enabled (\ref setAdaptiveSampling), the resulting points
+  are finally thinned out by \ref decimateCurveLines.
 
   \see drawCurveLine, drawScatterPlot
 */
@@ -23084,13 +24961,21 @@ void QCPCurve::getCurveLines(QVector<QPointF> *lines, const QCPDataRange &dataRa
   mDataContainer->limitIteratorsToDataRange(itBegin, itEnd, dataRange);
   if (itBegin == itEnd)
     return;
+  
+  // classify all points into the regions of getRegion, as 1 + 3*column + row:
+  QVector<quint8> regions(int(itEnd-itBegin));
+  quint8 *region = regions.data();
+  for (QCPCurveDataContainer::const_iterator regionIt=itBegin; regionIt!=itEnd; ++regionIt, ++region)
+    *region = quint8(1 + 3*(int(!(regionIt->key < keyMin)) + int(regionIt->key > keyMax)) + int(!(regionIt->value > valueMax)) + int(regionIt->value < valueMin));
+  region = regions.data();
+  
   QCPCurveDataContainer::const_iterator it = itBegin;
   QCPCurveDataContainer::const_iterator prevIt = itEnd-1;
-  int prevRegion = getRegion(prevIt->key, prevIt->value, keyMin, valueMax, keyMax, valueMin);
+  int prevRegion = regions.last();
   QVector<QPointF> trailingPoints; // points that must be applied after all other points (are generated only when handling first point to get virtual segment between last and first point right)
   while (it != itEnd)
   {
-    const int currentRegion = getRegion(it->key, it->value, keyMin, valueMax, keyMax, valueMin);
+    const int currentRegion = *region++;
     if (currentRegion != prevRegion) // changed region, possibly need to add some optimized edge points or original points if entering R
     {
       if (currentRegion != 5) // segment doesn't end in R, so it's a candidate for removal
@@ -23146,6 +25031,55 @@ void QCPCurve::getCurveLines(QVector<QPointF> *lines, const QCPDataRange &dataRa
     ++it;
   }
   *lines << trailingPoints;
+  if (mAdaptiveSampling)
+    decimateCurveLines(lines, 1.0);
+}
+
+/*! \internal
+
+  Called by \ref getCurveLines to thin out the pixel coordinates in \a lines, if adaptive sampling
+  is enabled (\ref setAdaptiveSampling).
+
+  Consecutive points that lie within \a tolerance pixels (horizontally and vertically) of the first
+  point of their group are combined. Of each group, the first and last point and the points with
+  the smallest and largest x and y coordinates are kept, in their original order. The line thus
+  keeps its extrema, and the connection to the neighbouring groups stays unchanged. \a lines is
+  modified in place.
+*/
+void QCPCurve::decimateCurveLines(QVector<QPointF> *lines, double tolerance) const
+{
+  const int count = int(lines->size());
+  if (count < 3)
+    return;
+  QPointF *points = lines->data();
+  int writeIndex = 0;
+  int groupBegin = 0;
+  while (groupBegin < count)
+  {
+    const QPointF anchor = points[groupBegin];
+    int minX = groupBegin, maxX = groupBegin, minY = groupBegin, maxY = groupBegin;
+    int groupEnd = groupBegin+1;
+    while (groupEnd < count && qAbs(points[groupEnd].x()-anchor.x()) <= tolerance && qAbs(points[groupEnd].y()-anchor.y()) <= tolerance)
+    {
+      const QPointF &point = points[groupEnd];
+      if (point.x() < points[minX].x()) minX = groupEnd;
+      if (point.x() > points[maxX].x()) maxX = groupEnd;
+      if (point.y() < points[minY].y()) minY = groupEnd;
+      if (point.y() > points[maxY].y()) maxY = groupEnd;
+      ++groupEnd;
+    }
+    // keep the points of the group that matter, in order. Since they are read from indices at or
+    // beyond writeIndex, the compaction can happen in place:
+    int keep[6] = {groupBegin, minX, maxX, minY, maxY, groupEnd-1};
+    std::sort(keep, keep+6);
+    for (int i=0; i<6; ++i)
+    {
+      if (i == 0 || keep[i] != keep[i-1])
+        points[writeIndex++] = points[keep[i]];
+    }
+    groupBegin = groupEnd;
+  }
+  lines->resize(writeIndex);
 }
 
 /*! \internal
@@ -23922,18 +25856,30 @@ double QCPCurve::pointDistance(const QPointF &pixelPoint, QCPCurveDataContainer:
   // iterate over found data points and then choose the one with the shortest distance to pos:
   QCPCurveDataContainer::const_iterator begin = mDataContainer->constBegin();
   QCPCurveDataContainer::const_iterator end = mDataContainer->constEnd();
-  for (QCPCurveDataContainer::const_iterator it=begin; it!=end; ++it)
+  if (spatialIndex())
   {
-    const double currentDistSqr = QCPVector2D(coordsToPixels(it->key, it->value)-pixelPoint).lengthSquared();
-    if (currentDistSqr < minDistSqr)
+    const int closestIndex = indexedClosestData(pixelPoint, QCPDataRange(0, dataCount()), false, minDistSqr);
+    if (closestIndex >= 0)
+      closestData = mDataContainer->constBegin()+closestIndex;
+  } else
+  {
+    for (QCPCurveDataContainer::const_iterator it=begin; it!=end; ++it)
     {
-      minDistSqr = currentDistSqr;
-      closestData = it;
+      const double currentDistSqr = QCPVector2D(coordsToPixels(it->key, it->value)-pixelPoint).lengthSquared();
+      if (currentDistSqr < minDistSqr)
+      {
+        minDistSqr = currentDistSqr;
+        closestData = it;
+      }
     }
   }
   
   // calculate distance to line if there is one (if so, will probably be smaller than distance to closest data point):
-  if (mLineStyle != lsNone)
+  if (mLineStyle != lsNone && spatialIndex())
+  {
+    // only visit line segments whose index node may be closer than the closest segment found so far:
+    minDistSqr = indexedLineDistanceSqr(pixelPoint, QCPDataRange(0, dataCount()-1), minDistSqr);
+  } else if (mLineStyle != lsNone)
   {
     QVector<QPointF> lines;
     getCurveLines(&lines, QCPDataRange(0, dataCount()), mParentPlot->selectionTolerance()*1.2); // optimized lines outside axis rect shouldn't respond to clicks at the edge, so use 1.2*tolerance as pen width
@@ -24446,7 +26392,15 @@ QCPBars::QCPBars(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   mWidthType(wtPlotCoords),
   mBarsGroup(nullptr),
   mBaseValue(0),
-  mStackingGap(1)
+  mStackingGap(1),
+  mAdaptiveSampling(true),
+  mStackBottomValue(0),
+  mStackVersion(0),
+  mStackDataRevision(0),
+  mStackDataSize(0),
+  mStackBelow(nullptr),
+  mStackBelowVersion(0),
+  mStackBaseValue(0)
 {
   // modify inherited properties from abstract plottable:
   mPen.setColor(Qt::blue);
@@ -24568,6 +26522,26 @@ void QCPBars::setStackingGap(double pixels)
   mStackingGap = pixels;
 }
 
+/*!
+  Sets whether adaptive sampling shall be used when drawing these bars.
+  
+  If enabled, bars that are narrower than one pixel in key direction are not drawn one by one.
+  Instead, all such bars that fall into the same pixel column are merged into one envelope bar per
+  sign, reaching from the lowest base to the highest top of the positive bars, and likewise for the
+  negative bars. Stacking (\ref moveAbove) is taken into account. This way the drawing cost of
+  dense bar charts, e.g. histograms with hundreds of thousands of bins, is bounded by the size of
+  the axis rect rather than the number of bars, while the appearance stays practically the same.
+  
+  Bars that are at least one pixel wide are always drawn individually. By default, adaptive
+  sampling is enabled.
+  
+  \see QCPGraph::setAdaptiveSampling
+*/
+void QCPBars::setAdaptiveSampling(bool enabled)
+{
+  mAdaptiveSampling = enabled;
+}
+
 /*! \overload
   
   Adds the provided points in \a keys and \a values to the current data. The provided vectors
@@ -24686,6 +26660,8 @@ QCPDataSelection QCPBars::selectTestRect(const QRectF &rect, bool onlySelectable
     return result;
   if (!mKeyAxis || !mValueAxis)
     return result;
+  if (mBarBelow)
+    mBarBelow.data()->updateStackCache();
   
   QCPBarsDataContainer::const_iterator visibleBegin, visibleEnd;
   getVisibleDataBounds(visibleBegin, visibleEnd);
@@ -24717,6 +26693,8 @@ double QCPBars::selectTest(const QPointF &pos, bool onlySelectable, QVariant *de
   
   if (mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()) || mParentPlot->interactions().testFlag(QCP::iSelectPlottablesBeyondAxisRect))
   {
+    if (mBarBelow)
+      mBarBelow.data()->updateStackCache();
     // get visible data range:
     QCPBarsDataContainer::const_iterator visibleBegin, visibleEnd;
     getVisibleDataBounds(visibleBegin, visibleEnd);
@@ -24792,6 +26770,8 @@ QCPRange QCPBars::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain,
     itBegin = mDataContainer->findBegin(inKeyRange.lower, false);
     itEnd = mDataContainer->findEnd(inKeyRange.upper, false);
   }
+  if (mBarBelow)
+    mBarBelow.data()->updateStackCache();
   for (QCPBarsDataContainer::const_iterator it = itBegin; it != itEnd; ++it)
   {
     const double current = it->value + getStackedBaseValue(it->key, it->value >= 0);
@@ -24824,6 +26804,8 @@ QPointF QCPBars::dataPixelPosition(int index) const
     QCPAxis *valueAxis = mValueAxis.data();
     if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return {}; }
     
+    if (mBarBelow)
+      mBarBelow.data()->updateStackCache();
     const QCPDataContainer<QCPBarsData>::const_iterator it = mDataContainer->constBegin()+index;
     const double valuePixel = valueAxis->coordToPixel(getStackedBaseValue(it->key, it->value >= 0) + it->value);
     const double keyPixel = keyAxis->coordToPixel(it->key) + (mBarsGroup ? mBarsGroup->keyPixelOffset(this, it->key) : 0);
@@ -24843,6 +26825,8 @@ void QCPBars::draw(QCPPainter *painter)
 {
   if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
   if (mDataContainer->isEmpty()) return;
+  if (mBarBelow)
+    mBarBelow.data()->updateStackCache();
   
   QCPBarsDataContainer::const_iterator visibleBegin, visibleEnd;
   getVisibleDataBounds(visibleBegin, visibleEnd);
@@ -24860,6 +26844,22 @@ void QCPBars::draw(QCPPainter *painter)
     if (begin == end)
       continue;
     
+    if (isSelectedSegment && mSelectionDecorator)
+    {
+      mSelectionDecorator->applyBrush(painter);
+      mSelectionDecorator->applyPen(painter);
+    } else
+    {
+      painter->setBrush(mBrush);
+      painter->setPen(mPen);
+    }
+    applyDefaultAntialiasingHint(painter);
+    
+    // bars narrower than a pixel are merged per pixel column into envelopes (see setAdaptiveSampling):
+    const bool keyIsHorizontal = mKeyAxis.data()->orientation() == Qt::Horizontal;
+    QRectF positiveEnvelope, negativeEnvelope;
+    bool hasPositiveEnvelope = false, hasNegativeEnvelope = false;
+    int envelopeColumn = 0;
     for (QCPBarsDataContainer::const_iterator it=begin; it!=end; ++it)
     {
       // check data validity if flag set:
@@ -24867,19 +26867,36 @@ void QCPBars::draw(QCPPainter *painter)
       if (QCP::isInvalidData(it->key, it->value))
         qDebug() << Q_FUNC_INFO << "Data point at" << it->key << "of drawn range invalid." << "Plottable name:" << name();
 #endif
-      // draw bar:
-      if (isSelectedSegment && mSelectionDecorator)
+      const QRectF barRect = getBarRect(it->key, it->value);
+      if (mAdaptiveSampling && (keyIsHorizontal ? barRect.width() : barRect.height()) < 1.0)
       {
-        mSelectionDecorator->applyBrush(painter);
-        mSelectionDecorator->applyPen(painter);
+        const int column = qFloor(keyIsHorizontal ? barRect.center().x() : barRect.center().y());
+        if (column != envelopeColumn)
+        {
+          if (hasPositiveEnvelope)
+            painter->drawPolygon(positiveEnvelope);
+          if (hasNegativeEnvelope)
+            painter->drawPolygon(negativeEnvelope);
+          hasPositiveEnvelope = false;
+          hasNegativeEnvelope = false;
+          envelopeColumn = column;
+        }
+        if (it->value >= 0)
+        {
+          positiveEnvelope = hasPositiveEnvelope ? positiveEnvelope.united(barRect) : barRect;
+          hasPositiveEnvelope = true;
+        } else
+        {
+          negativeEnvelope = hasNegativeEnvelope ? negativeEnvelope.united(barRect) : barRect;
+          hasNegativeEnvelope = true;
+        }
       } else
-      {
-        painter->setBrush(mBrush);
-        painter->setPen(mPen);
-      }
-      applyDefaultAntialiasingHint(painter);
-      painter->drawPolygon(getBarRect(it->key, it->value));
+        painter->drawPolygon(barRect);
     }
+    if (hasPositiveEnvelope)
+      painter->drawPolygon(positiveEnvelope);
+    if (hasNegativeEnvelope)
+      painter->drawPolygon(negativeEnvelope);
   }
   
   // draw other selection decoration that isn't just line/scatter pens and brushes:
@@ -25059,32 +27076,140 @@ void QCPBars::getPixelWidth(double key, double &lower, double &upper) const
   positive and negative bars are separated per stack (positive are stacked above baseValue upwards,
   negative are stacked below baseValue downwards). This can be indicated with \a positive. So if the
   bar for which we need the base value is negative, set \a positive to false.
+  
+  The value is looked up in the stack cache of the bar below, so that cache must be up to date, see
+  \ref updateStackCache.
 */
 double QCPBars::getStackedBaseValue(double key, bool positive) const
 {
   if (mBarBelow)
+    return mBarBelow.data()->stackTopValue(key, positive);
+  else
+    return mBaseValue;
+}
+
+/*! \internal
+  
+  Makes sure the stack cache of this bar and of all bars stacked below it is up to date.
+  
+  The stack cache holds, for every key occupied by this bar or any bar below it, the value at which
+  the positive and the negative part of the stack ends on top of this bar. Bars at keys closer than
+  \ref stackKeyEpsilon are merged, and of several bars at one key, the largest positive and smallest
+  negative one count, as in the stacking logic of \ref getStackedBaseValue.
+  
+  The cache is built by merging the data of this bar with the cache of the bar below, so drawing
+  or querying a stack of K bars with N data points each takes O(K*N) instead of repeatedly walking
+  down the whole stack for every single bar. It is rebuilt only when the data of this bar, its base
+  value (if it is the bottom bar) or the bars below it have changed.
+*/
+void QCPBars::updateStackCache() const
+{
+  static quint64 lastStackVersion = 0;
+  const QCPBars *below = mBarBelow.data();
+  if (below)
+    below->updateStackCache();
+  const quint64 belowVersion = below ? below->mStackVersion : 0;
+  if (mStackVersion > 0 && mStackData.toStrongRef() == mDataContainer && mStackDataRevision == mDataContainer->revision() &&
+      mStackDataSize == mDataContainer->size() && mStackBelow == below && mStackBelowVersion == belowVersion &&
+      (below || mStackBaseValue == mBaseValue))
+    return;
+  
+  const QVector<StackTop> emptyTops;
+  const QVector<StackTop> &belowTops = below ? below->mStackTops : emptyTops;
+  mStackBottomValue = below ? below->mStackBottomValue : mBaseValue;
+  QVector<StackTop> tops;
+  tops.reserve(belowTops.size()+mDataContainer->size());
+  QCPBarsDataContainer::const_iterator it = mDataContainer->constBegin();
+  const QCPBarsDataContainer::const_iterator itEnd = mDataContainer->constEnd();
+  int belowIndex = 0;
+  while (it != itEnd || belowIndex < belowTops.size())
   {
-    double max = 0; // don't initialize with mBaseValue here because only base value of bottom-most bar has meaning in a bar stack
-    // find bars of mBarBelow that are approximately at key and find largest one:
-    double epsilon = qAbs(key)*(sizeof(key)==4 ? 1e-6 : 1e-14); // should be safe even when changed to use float at some point
-    if (key == 0)
-      epsilon = (sizeof(key)==4 ? 1e-6 : 1e-14);
-    QCPBarsDataContainer::const_iterator it = mBarBelow.data()->mDataContainer->findBegin(key-epsilon);
-    QCPBarsDataContainer::const_iterator itEnd = mBarBelow.data()->mDataContainer->findEnd(key+epsilon);
-    while (it != itEnd)
+    if (it != itEnd && qIsNaN(it->key))
     {
-      if (it->key > key-epsilon && it->key < key+epsilon)
-      {
-        if ((positive && it->value > max) ||
-            (!positive && it->value < max))
-          max = it->value;
-      }
       ++it;
+      continue;
     }
-    // recurse down the bar-stack to find the total height:
-    return max + mBarBelow.data()->getStackedBaseValue(key, positive);
-  } else
-    return mBaseValue;
+    StackTop top;
+    if (it == itEnd)
+      top.key = belowTops.at(belowIndex).key;
+    else if (belowIndex == belowTops.size())
+      top.key = it->key;
+    else
+      top.key = qMin(it->key, belowTops.at(belowIndex).key);
+    const double epsilon = stackKeyEpsilon(top.key);
+    // start from the top of the bars below at this key:
+    if (belowIndex < belowTops.size() && belowTops.at(belowIndex).key < top.key+epsilon)
+    {
+      top.positive = belowTops.at(belowIndex).positive;
+      top.negative = belowTops.at(belowIndex).negative;
+      ++belowIndex;
+    } else
+    {
+      top.positive = mStackBottomValue;
+      top.negative = mStackBottomValue;
+    }
+    // add the largest positive and smallest negative bar of this bar at this key:
+    double maxPositive = 0, minNegative = 0;
+    while (it != itEnd && it->key < top.key+epsilon)
+    {
+      if (it->value > maxPositive)
+        maxPositive = it->value;
+      if (it->value < minNegative)
+        minNegative = it->value;
+      ++it;
+    }
+    top.positive += maxPositive;
+    top.negative += minNegative;
+    tops.append(top);
+  }
+  
+  mStackTops.swap(tops);
+  mStackVersion = ++lastStackVersion;
+  mStackData = mDataContainer;
+  mStackDataRevision = mDataContainer->revision();
+  mStackDataSize = mDataContainer->size();
+  mStackBelow = below;
+  mStackBelowVersion = belowVersion;
+  mStackBaseValue = mBaseValue;
+}
+
+/*! \internal
+  
+  Returns the value at which the stack ends on top of this bar at \a key, i.e. the base value for a
+  bar stacked directly above this one. \a positive selects the positive or negative part of the
+  stack, see \ref getStackedBaseValue.
+  
+  The value is found with a binary search in the stack cache, which must be up to date (see \ref
+  updateStackCache). If neither this bar nor any bar below it has data at \a key, the base value of
+  the bottom bar is returned.
+*/
+double QCPBars::stackTopValue(double key, bool positive) const
+{
+  const double epsilon = stackKeyEpsilon(key);
+  int low = 0;
+  int high = mStackTops.size();
+  while (low < high)
+  {
+    const int mid = (low+high)/2;
+    if (mStackTops.at(mid).key <= key-epsilon)
+      low = mid+1;
+    else
+      high = mid;
+  }
+  if (low < mStackTops.size() && mStackTops.at(low).key < key+epsilon)
+    return positive ? mStackTops.at(low).positive : mStackTops.at(low).negative;
+  return mStackBottomValue;
+}
+
+/*! \internal
+  
+  Returns the distance below which two keys are considered to be the same key when stacking bars.
+*/
+double QCPBars::stackKeyEpsilon(double key)
+{
+  if (key == 0)
+    return (sizeof(key)==4 ? 1e-6 : 1e-14); // should be safe even when changed to use float at some point
+  return qAbs(key)*(sizeof(key)==4 ? 1e-6 : 1e-14);
 }
 
 /*! \internal
@@ -25508,6 +27633,49 @@ void QCPStatisticalBox::addData(double key, double minimum, double lowerQuartile
   mDataContainer->add(QCPStatisticalBoxData(key, minimum, lowerQuartile, median, upperQuartile, maximum, outliers));
 }
 
+/*!
+  Adds one statistical box per entry of \a keys, computed from the raw measurements in the
+  corresponding entry of \a samples. If the two vectors have different sizes, the surplus entries of
+  the longer one are ignored, and boxes without any (non-NaN) samples are skipped.
+  
+  The boxes are computed with \ref samplesToBox, see there for the meaning of \a whiskerFactor and
+  \a maxOutliers. The computation is distributed over as many threads as the hardware provides,
+  with each thread handling a subset of the boxes.
+*/
+void QCPStatisticalBox::addSamples(const QVector<double> &keys, const QVector<QVector<double> > &samples, double whiskerFactor, int maxOutliers)
+{
+  const int n = qMin(keys.size(), samples.size());
+  if (n == 0)
+    return;
+  
+  const int threadCount = qBound(1, int(std::thread::hardware_concurrency()), n);
+  QVector<QVector<QCPStatisticalBoxData> > threadBoxes(threadCount);
+  if (threadCount == 1)
+  {
+    samplesToBoxes(&keys, &samples, 0, 1, whiskerFactor, maxOutliers, threadBoxes.data());
+  } else
+  {
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (int i=0; i<threadCount; ++i)
+      threads.emplace_back(&QCPStatisticalBox::samplesToBoxes, &keys, &samples, i, threadCount, whiskerFactor, maxOutliers, threadBoxes.data()+i);
+    for (std::size_t i=0; i<threads.size(); ++i)
+      threads[i].join();
+  }
+  
+  QVector<QCPStatisticalBoxData> boxes;
+  boxes.reserve(n);
+  for (int i=0; i<threadCount; ++i)
+  {
+    for (int k=0; k<threadBoxes.at(i).size(); ++k)
+    {
+      if (!qIsNaN(threadBoxes.at(i).at(k).median))
+        boxes.append(threadBoxes.at(i).at(k));
+    }
+  }
+  mDataContainer->add(boxes, false);
+}
+
 /*!
   \copydoc QCPPlottableInterface1D::selectTestRect
 */
@@ -25668,6 +27836,115 @@ void QCPStatisticalBox::draw(QCPPainter *painter)
     mSelectionDecorator->drawDecoration(painter, selection());
 }
 
+/*!
+  Computes the statistical box at \a key from the raw measurements in \a samples. NaN samples are
+  ignored. If there are no other samples, all values of the returned box are NaN.
+  
+  The median and the quartiles are determined with a selection algorithm (\c std::nth_element)
+  instead of sorting, so the computation takes linear time in the number of samples. Quantiles that
+  fall between two samples are interpolated linearly.
+  
+  The whiskers extend to the smallest and largest samples that lie within \a whiskerFactor times the
+  interquartile range below the lower and above the upper quartile (the common choice of 1.5 gives
+  Tukey's box plot). Samples beyond are returned as outliers. If \a whiskerFactor is negative, the
+  whiskers span all samples and there are no outliers.
+  
+  To keep the data small when there are many outliers, at most \a maxOutliers of them are kept: the
+  lowest and the highest one, and the others evenly sampled in between. Pass -1 to keep all
+  outliers.
+  
+  \see addSamples
+*/
+QCPStatisticalBoxData QCPStatisticalBox::samplesToBox(double key, const QVector<double> &samples, double whiskerFactor, int maxOutliers)
+{
+  QCPStatisticalBoxData result(key, qQNaN(), qQNaN(), qQNaN(), qQNaN(), qQNaN());
+  std::vector<double> values;
+  values.reserve(std::size_t(samples.size()));
+  for (int i=0; i<samples.size(); ++i)
+  {
+    if (!qIsNaN(samples.at(i)))
+      values.push_back(samples.at(i));
+  }
+  if (values.empty())
+    return result;
+  
+  result.median = selectQuantile(values, 0.5);
+  result.lowerQuartile = selectQuantile(values, 0.25);
+  result.upperQuartile = selectQuantile(values, 0.75);
+  double lowerFence = -std::numeric_limits<double>::infinity();
+  double upperFence = std::numeric_limits<double>::infinity();
+  if (whiskerFactor >= 0)
+  {
+    const double interquartileRange = result.upperQuartile-result.lowerQuartile;
+    lowerFence = result.lowerQuartile-whiskerFactor*interquartileRange;
+    upperFence = result.upperQuartile+whiskerFactor*interquartileRange;
+  }
+  
+  // whisker ends and outliers:
+  result.minimum = result.lowerQuartile;
+  result.maximum = result.upperQuartile;
+  QVector<double> outliers;
+  for (std::size_t i=0; i<values.size(); ++i)
+  {
+    const double value = values[i];
+    if (value < lowerFence || value > upperFence)
+      outliers.append(value);
+    else if (value < result.minimum)
+      result.minimum = value;
+    else if (value > result.maximum)
+      result.maximum = value;
+  }
+  if (maxOutliers >= 0 && outliers.size() > maxOutliers)
+  {
+    std::sort(outliers.begin(), outliers.end());
+    QVector<double> sampled;
+    sampled.reserve(maxOutliers);
+    if (maxOutliers == 1)
+      sampled.append(qAbs(outliers.last()-result.median) > qAbs(outliers.first()-result.median) ? outliers.last() : outliers.first());
+    else
+    {
+      for (int i=0; i<maxOutliers; ++i)
+        sampled.append(outliers.at(int(qint64(i)*(outliers.size()-1)/(maxOutliers-1))));
+    }
+    outliers = sampled;
+  }
+  result.outliers = outliers;
+  return result;
+}
+
+/*! \internal
+  
+  Returns the quantile \a p (between 0 and 1) of \a values, interpolating linearly between the two
+  closest samples. \a values is reordered in the process, using \c std::nth_element.
+  
+  \a values must not be empty.
+*/
+double QCPStatisticalBox::selectQuantile(std::vector<double> &values, double p)
+{
+  const double position = (values.size()-1)*p;
+  const std::size_t lowerIndex = std::size_t(position);
+  std::nth_element(values.begin(), values.begin()+std::ptrdiff_t(lowerIndex), values.end());
+  const double lower = values[lowerIndex];
+  if (lowerIndex+1 >= values.size() || position == double(lowerIndex))
+    return lower;
+  // after nth_element, the next sample in order is the smallest one above the lower index:
+  const double upper = *std::min_element(values.begin()+std::ptrdiff_t(lowerIndex)+1, values.end());
+  return lower+(position-double(lowerIndex))*(upper-lower);
+}
+
+/*! \internal
+  
+  Computes the boxes with the indices \a first, \a first + \a stride, \a first + 2 \a stride, ... of
+  \a keys and \a samples with \ref samplesToBox, and appends them to \a boxes. This is the worker of
+  \ref addSamples, called on each thread.
+*/
+void QCPStatisticalBox::samplesToBoxes(const QVector<double> *keys, const QVector<QVector<double> > *samples, int first, int stride, double whiskerFactor, int maxOutliers, QVector<QCPStatisticalBoxData> *boxes)
+{
+  const int n = qMin(keys->size(), samples->size());
+  for (int i=first; i<n; i+=stride)
+    boxes->append(samplesToBox(keys->at(i), samples->at(i), whiskerFactor, maxOutliers));
+}
+
 /* inherits documentation from base class */
 void QCPStatisticalBox::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
 {
@@ -25706,11 +27983,30 @@ void QCPStatisticalBox::drawStatisticalBox(QCPPainter *painter, QCPStatisticalBo
   painter->drawLines(getWhiskerBackboneLines(it));
   painter->setPen(mWhiskerBarPen);
   painter->drawLines(getWhiskerBarLines(it));
-  // draw outliers:
+  // draw outliers, at most one per pixel:
+  if (it->outliers.isEmpty() || !mKeyAxis || !mValueAxis)
+    return;
   applyScattersAntialiasingHint(painter);
   outlierStyle.applyTo(painter, mPen);
+  const double keyPixel = mKeyAxis.data()->coordToPixel(it->key);
+  QVector<double> outlierPixels;
+  outlierPixels.reserve(it->outliers.size());
   for (int i=0; i<it->outliers.size(); ++i)
-    outlierStyle.drawShape(painter, coordsToPixels(it->key, it->outliers.at(i)));
+  {
+    const double valuePixel = mValueAxis.data()->coordToPixel(it->outliers.at(i));
+    if (!qIsNaN(valuePixel))
+      outlierPixels.append(valuePixel);
+  }
+  std::sort(outlierPixels.begin(), outlierPixels.end());
+  for (int i=0; i<outlierPixels.size(); ++i)
+  {
+    if (i > 0 && qRound(qBound(-1e9, outlierPixels.at(i), 1e9)) == qRound(qBound(-1e9, outlierPixels.at(i-1), 1e9)))
+      continue;
+    if (mKeyAxis.data()->orientation() == Qt::Horizontal)
+      outlierStyle.drawShape(painter, keyPixel, outlierPixels.at(i));
+    else
+      outlierStyle.drawShape(painter, outlierPixels.at(i), keyPixel);
+  }
 }
 
 /*!  \internal
@@ -27104,7 +29400,13 @@ QCPFinancial::QCPFinancial(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   mBrushPositive(QBrush(QColor(50, 160, 0))),
   mBrushNegative(QBrush(QColor(180, 0, 15))),
   mPenPositive(QPen(QColor(40, 150, 0))),
-  mPenNegative(QPen(QColor(170, 5, 5)))
+  mPenNegative(QPen(QColor(170, 5, 5))),
+  mAdaptiveBinning(false),
+  mMinimumCandleWidth(3),
+  mBaseBinSize(0),
+  mBinLevelsRevision(0),
+  mBinLevelsSize(0),
+  mWidthScale(1)
 {
   mSelectionDecorator->setBrush(QBrush(QColor(160, 160, 255)));
 }
@@ -27251,6 +29553,55 @@ void QCPFinancial::setPenNegative(const QPen &pen)
   mPenNegative = pen;
 }
 
+/*!
+  Sets whether the data points shall be combined into coarser candles, when they become too narrow
+  at the current key axis range.
+  
+  If enabled, QCPFinancial maintains a hierarchy of coarser resolutions of its data, each level
+  combining the data points of the previous one into wider bins (see \ref setBinSizes). When
+  drawing, the finest resolution whose bins are at least \ref setMinimumCandleWidth pixels wide is
+  used. The resolutions are built once per data change, so zooming out on a long series of
+  e.g. one-minute candles keeps the number of drawn candles and thus the replot time bounded, and the
+  chart readable.
+  
+  The combined candles take the open of their first and the close of their last data point, and the
+  extremes of the highs and lows, like \ref QCPFinancialAggregator::rebin. With \ref wtPlotCoords,
+  their width scales with the bin size. Selection still refers to the original data points: a
+  combined candle is drawn as selected if it contains selected data points.
+  
+  By default, adaptive binning is disabled.
+*/
+void QCPFinancial::setAdaptiveBinning(bool enabled)
+{
+  mAdaptiveBinning = enabled;
+}
+
+/*!
+  Sets the minimum width in \a pixels a bin must have at the current key axis range, to be drawn
+  when adaptive binning is enabled (\ref setAdaptiveBinning). The finest resolution satisfying this
+  is drawn.
+*/
+void QCPFinancial::setMinimumCandleWidth(double pixels)
+{
+  mMinimumCandleWidth = pixels;
+}
+
+/*!
+  Sets the bin sizes of the coarser resolutions used for adaptive binning (\ref
+  setAdaptiveBinning), in key coordinates. For example, if the data consists of one-minute candles
+  with keys in seconds, pass 300, 3600 and 86400 to get five-minute, hourly and daily candles.
+  
+  Each resolution is built from the next finer one, so the bin sizes should be multiples of each
+  other. If \a binSizes is empty (the default), the bin sizes are chosen automatically, each four
+  times as large as the previous one, starting at the smallest key distance of the data.
+*/
+void QCPFinancial::setBinSizes(const QVector<double> &binSizes)
+{
+  mBinSizes = binSizes;
+  std::sort(mBinSizes.begin(), mBinSizes.end());
+  mBinLevelsData.clear(); // force rebuild of the resolutions
+}
+
 /*! \overload
   
   Adds the provided points in \a keys, \a open, \a high, \a low and \a close to the current data.
@@ -27401,6 +29752,9 @@ QCPRange QCPFinancial::getValueRange(bool &foundRange, QCP::SignDomain inSignDom
   value passed as \a timeBinOffset doesn't need to be in the range encompassed by the \a time keys.
   It merely defines the mathematical offset/phase of the bins that will be used to process the
   data.
+  
+  To build candles incrementally from live data, or to process very large time series on multiple
+  threads, use \ref QCPFinancialAggregator instead.
 */
 QCPFinancialDataContainer QCPFinancial::timeSeriesToOhlc(const QVector<double> &time, const QVector<double> &value, double timeBinSize, double timeBinOffset)
 {
@@ -27444,6 +29798,19 @@ QCPFinancialDataContainer QCPFinancial::timeSeriesToOhlc(const QVector<double> &
 /* inherits documentation from base class */
 void QCPFinancial::draw(QCPPainter *painter)
 {
+  // draw coarser candles if the data points are too narrow at the current key range:
+  if (mAdaptiveBinning)
+  {
+    const int level = binLevelForRange();
+    if (level >= 0)
+    {
+      drawBinLevel(painter, mBinLevels.at(level));
+      if (mSelectionDecorator)
+        mSelectionDecorator->drawDecoration(painter, selection());
+      return;
+    }
+  }
+  
   // get visible data range:
   QCPFinancialDataContainer::const_iterator visibleBegin, visibleEnd;
   getVisibleDataBounds(visibleBegin, visibleEnd);
@@ -27592,6 +29959,153 @@ void QCPFinancial::drawOhlcPlot(QCPPainter *painter, const QCPFinancialDataConta
   }
 }
 
+/*! \internal
+  
+  Makes sure the coarser resolutions used for adaptive binning (\ref setAdaptiveBinning) match the
+  current data, and rebuilds them if not.
+  
+  Each resolution is built in a single pass over the next finer one, so all resolutions together
+  take about as long to build as one pass over the data.
+*/
+void QCPFinancial::updateBinLevels()
+{
+  if (mBinLevelsData.toStrongRef() == mDataContainer && mBinLevelsRevision == mDataContainer->revision() && mBinLevelsSize == mDataContainer->size())
+    return;
+  mBinLevels.clear();
+  mBaseBinSize = 0;
+  mBinLevelsData = mDataContainer;
+  mBinLevelsRevision = mDataContainer->revision();
+  mBinLevelsSize = mDataContainer->size();
+  if (mDataContainer->size() < 2)
+    return;
+  
+  // the smallest key distance serves as bin size of the original data:
+  double spacing = std::numeric_limits<double>::infinity();
+  for (QCPFinancialDataContainer::const_iterator it=mDataContainer->constBegin()+1; it!=mDataContainer->constEnd(); ++it)
+  {
+    const double distance = it->key-(it-1)->key;
+    if (distance > 0 && distance < spacing)
+      spacing = distance;
+  }
+  if (!qIsFinite(spacing))
+    return;
+  mBaseBinSize = spacing;
+  
+  QVector<double> binSizes;
+  for (int i=0; i<mBinSizes.size(); ++i)
+  {
+    if (mBinSizes.at(i) > spacing)
+      binSizes.append(mBinSizes.at(i));
+  }
+  if (binSizes.isEmpty())
+  {
+    const double span = (mDataContainer->constEnd()-1)->key-mDataContainer->constBegin()->key;
+    for (double binSize=spacing*4; qIsFinite(binSize); binSize*=4)
+    {
+      binSizes.append(binSize);
+      if (binSize >= span)
+        break;
+    }
+  }
+  
+  // build each resolution from the next finer one:
+  mBinLevels.reserve(binSizes.size());
+  for (int i=0; i<binSizes.size(); ++i)
+  {
+    const QCPFinancialDataContainer &source = i == 0 ? *mDataContainer : mBinLevels.last().data;
+    BinLevel level;
+    level.binSize = binSizes.at(i);
+    QVector<QCPFinancialData> candles;
+    for (QCPFinancialDataContainer::const_iterator it=source.constBegin(); it!=source.constEnd(); ++it)
+    {
+      if (qIsNaN(it->key))
+        continue;
+      const double key = std::floor(it->key/level.binSize+0.5)*level.binSize;
+      if (!candles.isEmpty() && candles.last().key == key)
+      {
+        QCPFinancialData &candle = candles.last();
+        if (it->high > candle.high)
+          candle.high = it->high;
+        if (it->low < candle.low)
+          candle.low = it->low;
+        candle.close = it->close;
+      } else
+      {
+        const int sourceIndex = int(it-source.constBegin());
+        candles.append(*it);
+        candles.last().key = key;
+        level.firstIndex.append(i == 0 ? sourceIndex : mBinLevels.last().firstIndex.at(sourceIndex));
+      }
+    }
+    level.data.set(candles, true);
+    mBinLevels.append(level);
+  }
+}
+
+/*! \internal
+  
+  Returns the index of the resolution in \c mBinLevels that shall be drawn at the current key axis
+  range, i.e. the finest one whose bins are at least \ref setMinimumCandleWidth pixels wide. Returns
+  -1 if the original data points are wide enough.
+*/
+int QCPFinancial::binLevelForRange()
+{
+  updateBinLevels();
+  if (mBinLevels.isEmpty() || !mKeyAxis)
+    return -1;
+  QCPAxis *keyAxis = mKeyAxis.data();
+  const double center = keyAxis->range().center();
+  const double centerPixel = keyAxis->coordToPixel(center);
+  if (qAbs(keyAxis->coordToPixel(center+mBaseBinSize)-centerPixel) >= mMinimumCandleWidth)
+    return -1;
+  for (int i=0; i<mBinLevels.size(); ++i)
+  {
+    if (qAbs(keyAxis->coordToPixel(center+mBinLevels.at(i).binSize)-centerPixel) >= mMinimumCandleWidth)
+      return i;
+  }
+  return int(mBinLevels.size())-1;
+}
+
+/*! \internal
+  
+  Draws the combined candles of the resolution \a level instead of the original data points. This
+  method is a helper function for \ref draw, used when adaptive binning is enabled.
+  
+  Selected and unselected data segments are mapped to the candles that contain their data points.
+*/
+void QCPFinancial::drawBinLevel(QCPPainter *painter, const BinLevel &level)
+{
+  if (!mKeyAxis) { qDebug() << Q_FUNC_INFO << "invalid key axis"; return; }
+  mWidthScale = level.binSize/mBaseBinSize;
+  const double halfWidth = mWidth*mWidthScale*0.5;
+  const QCPFinancialDataContainer::const_iterator visibleBegin = level.data.findBegin(mKeyAxis.data()->range().lower-halfWidth);
+  const QCPFinancialDataContainer::const_iterator visibleEnd = level.data.findEnd(mKeyAxis.data()->range().upper+halfWidth);
+  
+  QList<QCPDataRange> selectedSegments, unselectedSegments, allSegments;
+  getDataSegments(selectedSegments, unselectedSegments);
+  allSegments << unselectedSegments << selectedSegments;
+  for (int i=0; i<allSegments.size(); ++i)
+  {
+    bool isSelectedSegment = i >= unselectedSegments.size();
+    // candles whose data points intersect the segment:
+    const int first = int(std::upper_bound(level.firstIndex.constBegin(), level.firstIndex.constEnd(), allSegments.at(i).begin())-level.firstIndex.constBegin())-1;
+    const int last = int(std::lower_bound(level.firstIndex.constBegin(), level.firstIndex.constEnd(), allSegments.at(i).end())-level.firstIndex.constBegin());
+    QCPFinancialDataContainer::const_iterator begin = qMax(visibleBegin, level.data.constBegin()+qMax(0, first));
+    QCPFinancialDataContainer::const_iterator end = qMin(visibleEnd, level.data.constBegin()+last);
+    if (begin >= end)
+      continue;
+    
+    switch (mChartStyle)
+    {
+      case QCPFinancial::csOhlc:
+        drawOhlcPlot(painter, begin, end, isSelectedSegment); break;
+      case QCPFinancial::csCandlestick:
+        drawCandlestickPlot(painter, begin, end, isSelectedSegment); break;
+    }
+  }
+  mWidthScale = 1;
+}
+
 /*! \internal
   
   Draws the data from \a begin to \a end-1 as Candlesticks with the provided \a painter.
@@ -27701,7 +30215,7 @@ double QCPFinancial::getPixelWidth(double key, double keyPixel) const
     case wtPlotCoords:
     {
       if (mKeyAxis)
-        result = mKeyAxis.data()->coordToPixel(key+mWidth*0.5)-keyPixel;
+        result = mKeyAxis.data()->coordToPixel(key+mWidth*mWidthScale*0.5)-keyPixel;
       else
         qDebug() << Q_FUNC_INFO << "No key axis defined";
       break;
@@ -27878,6 +30392,329 @@ QRectF QCPFinancial::selectionHitBox(QCPFinancialDataContainer::const_iterator i
   else
     return QRectF(highPixel, keyPixel-keyWidthPixels, lowPixel-highPixel, keyWidthPixels*2).normalized();
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPFinancialAggregator
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPFinancialAggregator
+  \brief Builds OHLC data for QCPFinancial incrementally from time series data
+  
+  While \ref QCPFinancial::timeSeriesToOhlc converts a complete time series at once, this class
+  keeps the binned OHLC data (candles) in a \ref QCPFinancialDataContainer and consumes ticks as
+  they arrive. A tick that falls into the last, still open bin only updates that bin, and a tick
+  beyond it appends a new bin, so live data can be displayed without rebuilding all candles.
+  
+  The bins are defined like in \ref QCPFinancial::timeSeriesToOhlc: a tick at time \a t belongs to
+  the bin centered at <tt>timeBinOffset + n*timeBinSize</tt> that is closest to \a t, and the bin
+  center is used as the key of the candle.
+  
+  To feed the candles directly into a plottable, share its data container:
+  \code
+  QCPFinancialAggregator aggregator(60);
+  aggregator.setData(financial->data());
+  // for each incoming tick:
+  aggregator.addTick(time, price);
+  customPlot->replot();
+  \endcode
+  
+  Large amounts of historical ticks can be passed to \ref addTicks, which splits them into chunks
+  that are aggregated in parallel (see \ref setThreadCount). Coarser candles can be derived from the
+  existing finer ones with \ref rebinned, without going back to the ticks.
+*/
+
+/* start documentation of inline functions */
+
+/*! \fn QSharedPointer<QCPFinancialDataContainer> QCPFinancialAggregator::data() const
+  
+  Returns a shared pointer to the container holding the candles built by this aggregator.
+  
+  \see setData
+*/
+
+/* end documentation of inline functions */
+
+/*!
+  Creates an aggregator with an empty data container, that combines ticks into bins of width \a
+  timeBinSize, with bin centers shifted by \a timeBinOffset. See \ref
+  QCPFinancial::timeSeriesToOhlc for the meaning of the parameters.
+*/
+QCPFinancialAggregator::QCPFinancialAggregator(double timeBinSize, double timeBinOffset) :
+  mTimeBinSize(timeBinSize),
+  mTimeBinOffset(timeBinOffset),
+  mThreadCount(qMax(1, int(std::thread::hardware_concurrency()))),
+  mDataContainer(new QCPFinancialDataContainer)
+{
+  if (!(mTimeBinSize > 0))
+  {
+    qDebug() << Q_FUNC_INFO << "invalid time bin size" << timeBinSize;
+    mTimeBinSize = 1;
+  }
+}
+
+/*!
+  Makes the aggregator write its candles into the container \a data. This is typically the data
+  container of a \ref QCPFinancial (see \ref QCPFinancial::data), so that added ticks show up in the
+  plot with the next replot.
+  
+  Existing data in \a data is kept. New ticks are merged into its last data point if they fall into
+  the same bin, so \a data should have been built with the same time bin size and offset.
+*/
+void QCPFinancialAggregator::setData(QSharedPointer<QCPFinancialDataContainer> data)
+{
+  if (data)
+    mDataContainer = data;
+  else
+    qDebug() << Q_FUNC_INFO << "passed null data container";
+}
+
+/*!
+  Sets the maximum number of threads \ref addTicks uses to aggregate large amounts of ticks. By
+  default, this is the number of hardware threads. Set \a count to 1 to aggregate all ticks on the
+  calling thread.
+*/
+void QCPFinancialAggregator::setThreadCount(int count)
+{
+  mThreadCount = qMax(1, count);
+}
+
+/*!
+  Adds a single tick with \a value at \a time.
+  
+  If the tick falls into the bin of the last candle, only that candle is updated: its high and low
+  are extended and its close is set to \a value. If the tick lies beyond the last candle, a new
+  candle is appended. Late ticks that belong to an earlier bin extend the high and low of that bin,
+  or create it if it doesn't exist yet.
+  
+  Ticks with NaN time or value are ignored.
+*/
+void QCPFinancialAggregator::addTick(double time, double value)
+{
+  if (qIsNaN(time) || qIsNaN(value))
+    return;
+  const double key = binKey(time, mTimeBinSize, mTimeBinOffset);
+  if (!mDataContainer->isEmpty())
+  {
+    const double lastKey = (mDataContainer->constEnd()-1)->key;
+    if (key == lastKey) // tick in the open bin
+    {
+      mergeCandle(*(mDataContainer->end()-1), QCPFinancialData(key, value, value, value, value));
+      return;
+    } else if (key < lastKey) // late tick of an earlier bin
+    {
+      const QCPFinancialDataContainer::const_iterator it = mDataContainer->findBegin(key, false);
+      if (it != mDataContainer->constEnd() && it->key == key)
+      {
+        QCPFinancialData &candle = *(mDataContainer->begin()+int(it-mDataContainer->constBegin()));
+        candle.high = qMax(candle.high, value);
+        candle.low = qMin(candle.low, value);
+        return;
+      }
+    }
+  }
+  mDataContainer->add(QCPFinancialData(key, value, value, value, value));
+}
+
+/*!
+  Adds the ticks given by \a time and \a value. If the two vectors have different sizes, the
+  surplus entries of the longer one are ignored.
+  
+  If \a time is ascending and doesn't reach back before the last candle, the ticks are split into
+  chunks which are aggregated on up to \ref threadCount threads, and the resulting candles are
+  appended to the container in one go. This is the fast path for loading historical data. Other
+  ticks are added one by one, as with \ref addTick.
+*/
+void QCPFinancialAggregator::addTicks(const QVector<double> &time, const QVector<double> &value)
+{
+  const int count = qMin(time.size(), value.size());
+  if (count == 0)
+    return;
+  
+  // aggregate the ticks in chunks, each on its own thread:
+  const int minimumChunkSize = 1<<16;
+  const int chunkCount = qBound(1, count/minimumChunkSize, mThreadCount);
+  QVector<QVector<QCPFinancialData> > chunkCandles(chunkCount);
+  QVector<bool> chunkSorted(chunkCount, true);
+  QVector<int> chunkBegin(chunkCount+1);
+  for (int i=0; i<=chunkCount; ++i)
+    chunkBegin[i] = int(qint64(count)*i/chunkCount);
+  if (chunkCount == 1)
+  {
+    aggregateTicks(time.constData(), value.constData(), count, mTimeBinSize, mTimeBinOffset, chunkCandles.data(), chunkSorted.data());
+  } else
+  {
+    std::vector<std::thread> threads;
+    threads.reserve(chunkCount);
+    for (int i=0; i<chunkCount; ++i)
+      threads.emplace_back(&QCPFinancialAggregator::aggregateTicks, time.constData()+chunkBegin.at(i), value.constData()+chunkBegin.at(i),
+                           chunkBegin.at(i+1)-chunkBegin.at(i), mTimeBinSize, mTimeBinOffset, chunkCandles.data()+i, chunkSorted.data()+i);
+    for (std::size_t i=0; i<threads.size(); ++i)
+      threads[i].join();
+  }
+  
+  // the chunked result can only be used if the ticks are ascending and start in or after the open bin:
+  bool sorted = true;
+  double lastKey = mDataContainer->isEmpty() ? -std::numeric_limits<double>::infinity() : (mDataContainer->constEnd()-1)->key;
+  for (int i=0; i<chunkCount && sorted; ++i)
+  {
+    if (!chunkSorted.at(i))
+      sorted = false;
+    else if (!chunkCandles.at(i).isEmpty())
+    {
+      if (chunkCandles.at(i).first().key < lastKey)
+        sorted = false;
+      lastKey = chunkCandles.at(i).last().key;
+    }
+  }
+  if (!sorted)
+  {
+    for (int i=0; i<count; ++i)
+      addTick(time.at(i), value.at(i));
+    return;
+  }
+  
+  // join the candles of bins that were split between chunks:
+  QVector<QCPFinancialData> candles;
+  candles.reserve(chunkCandles.first().size()*chunkCount);
+  for (int i=0; i<chunkCount; ++i)
+  {
+    const QVector<QCPFinancialData> &chunk = chunkCandles.at(i);
+    for (int k=0; k<chunk.size(); ++k)
+    {
+      if (!candles.isEmpty() && candles.last().key == chunk.at(k).key)
+        mergeCandle(candles.last(), chunk.at(k));
+      else
+        candles.append(chunk.at(k));
+    }
+  }
+  if (candles.isEmpty())
+    return;
+  
+  // update the open bin and append the rest:
+  if (!mDataContainer->isEmpty() && (mDataContainer->constEnd()-1)->key == candles.first().key)
+  {
+    mergeCandle(*(mDataContainer->end()-1), candles.first());
+    candles.removeFirst();
+  }
+  mDataContainer->add(candles, true);
+}
+
+/*!
+  Removes all candles from the data container.
+*/
+void QCPFinancialAggregator::clear()
+{
+  mDataContainer->clear();
+}
+
+/*!
+  Returns the candles of this aggregator combined into coarser bins of width \a timeBinSize, with
+  bin centers shifted by \a timeBinOffset. The aggregator itself is not modified.
+  
+  \see rebin
+*/
+QCPFinancialDataContainer QCPFinancialAggregator::rebinned(double timeBinSize, double timeBinOffset) const
+{
+  return rebin(*mDataContainer, timeBinSize, timeBinOffset);
+}
+
+/*!
+  Combines the OHLC data points in \a candles into bins of width \a timeBinSize, with bin centers
+  shifted by \a timeBinOffset. Each candle is assigned to a bin by its key. The combined candle takes
+  the open of the first and the close of the last candle of its bin, and the extremes of their highs
+  and lows.
+  
+  This allows switching to a different bin size without going back to the original ticks. The
+  result is exact if \a timeBinSize is a multiple of the bin size of \a candles and the bin
+  boundaries line up, e.g. when going from one-minute to five-minute candles.
+*/
+QCPFinancialDataContainer QCPFinancialAggregator::rebin(const QCPFinancialDataContainer &candles, double timeBinSize, double timeBinOffset)
+{
+  QCPFinancialDataContainer result;
+  if (!(timeBinSize > 0))
+  {
+    qDebug() << Q_FUNC_INFO << "invalid time bin size" << timeBinSize;
+    return result;
+  }
+  QVector<QCPFinancialData> data;
+  for (QCPFinancialDataContainer::const_iterator it=candles.constBegin(); it!=candles.constEnd(); ++it)
+  {
+    if (qIsNaN(it->key))
+      continue;
+    const double key = binKey(it->key, timeBinSize, timeBinOffset);
+    if (!data.isEmpty() && data.last().key == key)
+    {
+      mergeCandle(data.last(), *it);
+    } else
+    {
+      data.append(*it);
+      data.last().key = key;
+    }
+  }
+  result.set(data, true);
+  return result;
+}
+
+/*! \internal
+  
+  Returns the key of the bin that \a time falls into, for bins of width \a timeBinSize with centers
+  shifted by \a timeBinOffset.
+*/
+double QCPFinancialAggregator::binKey(double time, double timeBinSize, double timeBinOffset)
+{
+  return timeBinOffset+std::floor((time-timeBinOffset)/timeBinSize+0.5)*timeBinSize;
+}
+
+/*! \internal
+  
+  Extends \a candle by the candle \a later that directly follows it in time: high and low become
+  the extremes of both, and the close is taken from \a later.
+*/
+void QCPFinancialAggregator::mergeCandle(QCPFinancialData &candle, const QCPFinancialData &later)
+{
+  if (later.high > candle.high)
+    candle.high = later.high;
+  if (later.low < candle.low)
+    candle.low = later.low;
+  candle.close = later.close;
+}
+
+/*! \internal
+  
+  Aggregates the \a count ticks given by \a time and \a value into the candles \a candles. This is
+  the worker of \ref addTicks, called for each chunk on its own thread.
+  
+  \a sorted returns whether the times are ascending. If they are not, aggregation stops early and
+  the content of \a candles is meaningless.
+*/
+void QCPFinancialAggregator::aggregateTicks(const double *time, const double *value, int count, double timeBinSize, double timeBinOffset, QVector<QCPFinancialData> *candles, bool *sorted)
+{
+  *sorted = true;
+  candles->clear();
+  double lastTime = -std::numeric_limits<double>::infinity();
+  for (int i=0; i<count; ++i)
+  {
+    if (qIsNaN(time[i]) || qIsNaN(value[i]))
+      continue;
+    if (time[i] < lastTime)
+    {
+      *sorted = false;
+      return;
+    }
+    lastTime = time[i];
+    const double key = binKey(time[i], timeBinSize, timeBinOffset);
+    if (!candles->isEmpty() && candles->last().key == key)
+    {
+      QCPFinancialData &candle = candles->last();
+      if (value[i] > candle.high)
+        candle.high = value[i];
+      if (value[i] < candle.low)
+        candle.low = value[i];
+      candle.close = value[i];
+    } else
+      candles->append(QCPFinancialData(key, value[i], value[i], value[i], value[i]));
+  }
+}
 /* end of 'src/plottables/plottable-financial.cpp' */
 
 
@@ -28382,7 +31219,6 @@ void QCPErrorBars::draw(QCPPainter *painter)
   QList<QCPDataRange> selectedSegments, unselectedSegments, allSegments;
   getDataSegments(selectedSegments, unselectedSegments);
   allSegments << unselectedSegments << selectedSegments;
-  QVector<QLineF> backbones, whiskers;
   for (int i=0; i<allSegments.size(); ++i)
   {
     QCPErrorBarsDataContainer::const_iterator begin, end;
@@ -28401,15 +31237,12 @@ void QCPErrorBars::draw(QCPPainter *painter)
       capFixPen.setCapStyle(Qt::FlatCap);
       painter->setPen(capFixPen);
     }
-    backbones.clear();
-    whiskers.clear();
-    for (QCPErrorBarsDataContainer::const_iterator it=begin; it!=end; ++it)
-    {
-      if (!checkPointVisibility || errorBarVisible(int(it-mDataContainer->constBegin())))
-        getErrorBarLines(it, backbones, whiskers);
-    }
-    painter->drawLines(backbones);
-    painter->drawLines(whiskers);
+    // line buffers keep their capacity across segments and replots:
+    mBackbones.resize(0);
+    mWhiskers.resize(0);
+    getErrorBarLines(begin, end, checkPointVisibility, mBackbones, mWhiskers);
+    painter->drawLines(mBackbones);
+    painter->drawLines(mWhiskers);
   }
   
   // draw other selection decoration that isn't just line/scatter pens and brushes:
@@ -28658,6 +31491,148 @@ void QCPErrorBars::getErrorBarLines(QCPErrorBarsDataContainer::const_iterator it
   }
 }
 
+/*! \internal
+  
+  \overload
+  
+  Calculates the lines that make up the error bars of the data points from \a begin to \a end-1, and
+  adds them to \a backbones and \a whiskers. This is the variant used by \ref draw.
+  
+  The pixel position of each data point is taken from the data plottable once. On a linear error
+  axis, the pixel length of the errors is derived from it directly, without transforming back and
+  forth between pixel and plot coordinates.
+  
+  Error bars whose data points fall into the same pixel column (or row, for \ref etKeyError)
+  are collapsed: overlapping backbones are merged into one line, and whiskers that coincide with
+  the previous whisker of the column on the same pixel are skipped. Dense data thus produces a
+  number of lines bounded by the axis rect size rather than the number of data points.
+  
+  If \a checkPointVisibility is true, each error bar is additionally checked against the visible key
+  range, like \ref errorBarVisible does, but using the already calculated pixel positions.
+*/
+void QCPErrorBars::getErrorBarLines(const QCPErrorBarsDataContainer::const_iterator &begin, const QCPErrorBarsDataContainer::const_iterator &end, bool checkPointVisibility, QVector<QLineF> &backbones, QVector<QLineF> &whiskers) const
+{
+  if (!mDataPlottable) return;
+  
+  QCPPlottableInterface1D *interface1D = mDataPlottable->interface1D();
+  QCPAxis *errorAxis = mErrorType == etValueError ? mValueAxis.data() : mKeyAxis.data();
+  QCPAxis *orthoAxis = mErrorType == etValueError ? mKeyAxis.data() : mValueAxis.data();
+  const bool errorAxisVertical = errorAxis->orientation() == Qt::Vertical;
+  const bool orthoAxisHorizontal = orthoAxis->orientation() == Qt::Horizontal;
+  const bool errorAxisReversed = errorAxis->rangeReversed();
+  const double symbolGap = mSymbolGap*0.5*errorAxis->pixelOrientation();
+  const double halfWhiskerWidth = mWhiskerWidth*0.5;
+  // on a linear axis, errors can be converted to pixel lengths with a constant factor:
+  const bool linearErrorAxis = errorAxis->scaleType() == QCPAxis::stLinear;
+  const double pixelsPerCoord = linearErrorAxis ? (errorAxis->coordToPixel(errorAxis->range().upper)-errorAxis->coordToPixel(errorAxis->range().lower))/errorAxis->range().size() : 0;
+  // visible key range in pixels, for the per-point visibility check:
+  const double keyRangePixelA = mKeyAxis->coordToPixel(mKeyAxis->range().lower);
+  const double keyRangePixelB = mKeyAxis->coordToPixel(mKeyAxis->range().upper);
+  const double keyRangePixelMin = qMin(keyRangePixelA, keyRangePixelB);
+  const double keyRangePixelMax = qMax(keyRangePixelA, keyRangePixelB);
+  
+  int column = 0;
+  bool hasColumn = false;
+  double backboneLow = 0, backboneHigh = 0, backboneOrtho = 0;
+  bool hasBackbone = false;
+  int lastPlusWhisker = 0, lastMinusWhisker = 0;
+  bool hasPlusWhisker = false, hasMinusWhisker = false;
+  for (QCPErrorBarsDataContainer::const_iterator it=begin; it!=end; ++it)
+  {
+    const QPointF centerPixel = interface1D->dataPixelPosition(int(it-mDataContainer->constBegin()));
+    if (qIsNaN(centerPixel.x()) || qIsNaN(centerPixel.y()))
+      continue;
+    const double centerErrorAxisPixel = errorAxisVertical ? centerPixel.y() : centerPixel.x();
+    const double centerOrthoAxisPixel = orthoAxisHorizontal ? centerPixel.x() : centerPixel.y();
+    double plusEnd = qQNaN(), minusEnd = qQNaN();
+    if (linearErrorAxis)
+    {
+      plusEnd = centerErrorAxisPixel+it->errorPlus*pixelsPerCoord;
+      minusEnd = centerErrorAxisPixel-it->errorMinus*pixelsPerCoord;
+    } else
+    {
+      const double centerErrorAxisCoord = errorAxis->pixelToCoord(centerErrorAxisPixel);
+      if (!qIsNaN(it->errorPlus))
+        plusEnd = errorAxis->coordToPixel(centerErrorAxisCoord+it->errorPlus);
+      if (!qIsNaN(it->errorMinus))
+        minusEnd = errorAxis->coordToPixel(centerErrorAxisCoord-it->errorMinus);
+    }
+    
+    if (checkPointVisibility)
+    {
+      double keyPixelLow, keyPixelHigh;
+      if (mErrorType == etKeyError)
+      {
+        keyPixelLow = centerErrorAxisPixel;
+        keyPixelHigh = centerErrorAxisPixel;
+        if (!qIsNaN(plusEnd)) { keyPixelLow = qMin(keyPixelLow, plusEnd); keyPixelHigh = qMax(keyPixelHigh, plusEnd); }
+        if (!qIsNaN(minusEnd)) { keyPixelLow = qMin(keyPixelLow, minusEnd); keyPixelHigh = qMax(keyPixelHigh, minusEnd); }
+      } else
+      {
+        keyPixelLow = centerOrthoAxisPixel-halfWhiskerWidth;
+        keyPixelHigh = centerOrthoAxisPixel+halfWhiskerWidth;
+      }
+      if (keyPixelHigh <= keyRangePixelMin || keyPixelLow >= keyRangePixelMax)
+        continue;
+    }
+    
+    // start a new pixel column, emitting the merged backbone of the previous one:
+    const int pointColumn = qFloor(qBound(-1e9, centerOrthoAxisPixel, 1e9));
+    if (!hasColumn || pointColumn != column)
+    {
+      if (hasBackbone)
+        backbones.append(errorAxisVertical ? QLineF(backboneOrtho, backboneLow, backboneOrtho, backboneHigh) : QLineF(backboneLow, backboneOrtho, backboneHigh, backboneOrtho));
+      hasBackbone = false;
+      hasPlusWhisker = false;
+      hasMinusWhisker = false;
+      column = pointColumn;
+      hasColumn = true;
+    }
+    
+    for (int side=0; side<2; ++side) // plus error, then minus error
+    {
+      const bool plus = side == 0;
+      const double errorEnd = plus ? plusEnd : minusEnd;
+      if (qIsNaN(errorEnd))
+        continue;
+      const double errorStart = plus ? centerErrorAxisPixel+symbolGap : centerErrorAxisPixel-symbolGap;
+      const bool pointsAway = (errorAxisVertical == plus) ? errorStart > errorEnd : errorStart < errorEnd;
+      if (pointsAway != errorAxisReversed)
+      {
+        const double low = qMin(errorStart, errorEnd);
+        const double high = qMax(errorStart, errorEnd);
+        if (hasBackbone && low <= backboneHigh+1 && high >= backboneLow-1)
+        {
+          backboneLow = qMin(backboneLow, low);
+          backboneHigh = qMax(backboneHigh, high);
+        } else
+        {
+          if (hasBackbone)
+            backbones.append(errorAxisVertical ? QLineF(backboneOrtho, backboneLow, backboneOrtho, backboneHigh) : QLineF(backboneLow, backboneOrtho, backboneHigh, backboneOrtho));
+          backboneLow = low;
+          backboneHigh = high;
+          backboneOrtho = centerOrthoAxisPixel;
+          hasBackbone = true;
+        }
+      }
+      const int whiskerPixel = qRound(errorEnd);
+      bool &hasWhisker = plus ? hasPlusWhisker : hasMinusWhisker;
+      int &lastWhisker = plus ? lastPlusWhisker : lastMinusWhisker;
+      if (!hasWhisker || whiskerPixel != lastWhisker)
+      {
+        if (errorAxisVertical)
+          whiskers.append(QLineF(centerOrthoAxisPixel-halfWhiskerWidth, errorEnd, centerOrthoAxisPixel+halfWhiskerWidth, errorEnd));
+        else
+          whiskers.append(QLineF(errorEnd, centerOrthoAxisPixel-halfWhiskerWidth, errorEnd, centerOrthoAxisPixel+halfWhiskerWidth));
+        lastWhisker = whiskerPixel;
+        hasWhisker = true;
+      }
+    }
+  }
+  if (hasBackbone)
+    backbones.append(errorAxisVertical ? QLineF(backboneOrtho, backboneLow, backboneOrtho, backboneHigh) : QLineF(backboneLow, backboneOrtho, backboneHigh, backboneOrtho));
+}
+
 /*! \internal
 
   This method outputs the currently visible data range via \a begin and \a end. The returned range
@@ -32642,7 +35617,6 @@ QCPPolarAxisAngular::QCPPolarAxisAngular(QCustomPlot *parentPlot) :
   setTickLabelMode(lmUpright);
   mLabelPainter.setAnchorReferenceType(QCPLabelPainterPrivate::artNormal);
   mLabelPainter.setAbbreviateDecimalPowers(false);
-  mLabelPainter.setCacheSize(24); // so we can cache up to 15-degree intervals, polar angular axis uses a bit larger cache than normal axes
   
   setMinimumSize(50, 50);
   setMinimumMargins(QMargins(30, 30, 30, 30));
@@ -34497,6 +37471,8 @@ QCPPolarGraph::~QCPPolarGraph()
 void QCPPolarGraph::setName(const QString &name)
 {
   mName = name;
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
 }
 
 /*!
@@ -51,6 +51,7 @@
 #include <QtCore/QPointer>
 #include <QtCore/QSharedPointer>
 #include <QtCore/QTimer>
+#include <QtCore/QFile>
 #include <QtGui/QPainter>
 #include <QtGui/QPainterPath>
 #include <QtGui/QPaintEvent>
@@ -69,6 +70,17 @@
 #include <qmath.h>
 #include <limits>
 #include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+#if defined(__has_include)
+#  if __has_include(<charconv>) && (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#    include <charconv>
+#    if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#      define QCP_TO_CHARS_SUPPORTED
+#    endif
+#  endif
+#endif
 #ifdef QCP_OPENGL_FBO
 #  include <QtGui/QOpenGLContext>
 #  if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -98,6 +110,8 @@
 #endif
 #if QT_VERSION >= QT_VERSION_CHECK(4, 8, 0)
 #  include <QtCore/QElapsedTimer>
+#  include <QtGui/QGlyphRun>
+#  include <QtGui/QTextLayout>
 #endif
 # if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
 #  include <QtCore/QTimeZone>
@@ -1026,7 +1040,14 @@ private:
   // property members:
   QList<QCPDataRange> mDataRanges;
   
+  // non-property members:
+  bool mSimplified;
+  
   inline static bool lessThanDataRangeBegin(const QCPDataRange &a, const QCPDataRange &b) { return a.begin() < b.begin(); }
+  inline static bool dataRangeBeginsBefore(const QCPDataRange &range, int index) { return range.begin() < index; }
+  inline static bool dataRangeBeginsAfter(int index, const QCPDataRange &range) { return index < range.begin(); }
+  inline static bool dataRangeEndsBefore(const QCPDataRange &range, int index) { return range.end() < index; }
+  inline static bool dataRangeEndsAtOrBefore(const QCPDataRange &range, int index) { return range.end() <= index; }
 };
 Q_DECLARE_METATYPE(QCPDataSelection)
 
@@ -1589,6 +1610,53 @@ Q_DECLARE_METATYPE(QCPLineEnding::EndingStyle)
 /* including file 'src/axis/labelpainter.h' */
 /* modified 2022-11-06T12:45:56, size 7086  */
 
+class QCPLabelCachePrivate
+{
+public:
+  struct CachedLabel
+  {
+    QPixmap pixmap;
+    QRect totalBounds; // is in a coordinate system where label top left is at (0, 0)
+    QRect rotatedTotalBounds; // is in a coordinate system where the label anchor is at (0, 0)
+  };
+
+  QCPLabelCachePrivate();
+  virtual ~QCPLabelCachePrivate();
+
+  // setters:
+  void setMaximumMemory(int kilobytes);
+  void setMaximumGlyphs(int glyphCount);
+
+  // getters:
+  int maximumMemory() const;
+  int maximumGlyphs() const;
+  int usedMemory() const;
+
+  // non-property methods:
+  bool findLabel(const QByteArray &key, CachedLabel *label);
+  void insertLabel(const QByteArray &key, const CachedLabel &label);
+  void drawText(QCPPainter *painter, const QRectF &rect, int flags, const QString &text);
+  void clear();
+
+protected:
+#if QT_VERSION >= QT_VERSION_CHECK(4, 8, 0)
+  struct ShapedText
+  {
+    QList<QGlyphRun> glyphRuns;
+    double width;
+  };
+#endif
+
+  QCache<QByteArray, CachedLabel> mLabels;
+#if QT_VERSION >= QT_VERSION_CHECK(4, 8, 0)
+  QCache<QByteArray, ShapedText> mShapedTexts;
+  
+  // non-virtual methods:
+  void drawGlyphRuns(QCPPainter *painter, const QRectF &rect, int flags, const QList<QGlyphRun> &glyphRuns, double width) const;
+#endif
+};
+
+
 class QCPLabelPainterPrivate
 {
   Q_GADGET
@@ -1639,8 +1707,7 @@ public:
   void setSubstituteExponent(bool enabled);
   void setMultiplicationSymbol(QChar symbol);
   void setAbbreviateDecimalPowers(bool enabled);
-  void setCacheSize(int labelCount);
-  
+
   // getters:
   AnchorMode anchorMode() const { return mAnchorMode; }
   AnchorSide anchorSide() const { return mAnchorSide; }
@@ -1653,8 +1720,7 @@ public:
   bool substituteExponent() const { return mSubstituteExponent; }
   QChar multiplicationSymbol() const { return mMultiplicationSymbol; }
   bool abbreviateDecimalPowers() const { return mAbbreviateDecimalPowers; }
-  int cacheSize() const;
-  
+
   //virtual int size() const;
   
   // non-property methods: 
@@ -1666,11 +1732,6 @@ public:
   static const QChar SymbolCross;
   
 protected:
-  struct CachedLabel
-  {
-    QPoint offset;
-    QPixmap pixmap;
-  };
   struct LabelData
   {
     AnchorSide side;
@@ -1698,14 +1759,13 @@ protected:
   bool mAbbreviateDecimalPowers;
   // non-property members:
   QCustomPlot *mParentPlot;
-  QByteArray mLabelParameterHash; // to determine whether mLabelCache needs to be cleared due to changed parameters
-  QCache<QString, CachedLabel> mLabelCache;
+  QByteArray mLabelParameterHash; // prefix of all keys this painter uses in the label cache of the parent plot, regenerated lazily when empty
   QRect mAxisSelectionBox, mTickLabelsSelectionBox, mLabelSelectionBox;
   int mLetterCapHeight, mLetterDescent;
   
   // introduced virtual methods:
   virtual void drawLabelMaybeCached(QCPPainter *painter, const QFont &font, const QColor &color, const QPointF &pos, AnchorSide side, double rotation, const QString &text);
-  virtual QByteArray generateLabelParameterHash() const; // TODO: get rid of this in favor of invalidation flag upon setters?
+  virtual QByteArray generateLabelParameterHash() const;
 
   // non-virtual methods:
   QPointF getAnchorPos(const QPointF &tickPos);
@@ -1713,7 +1773,7 @@ protected:
   LabelData getTickLabelData(const QFont &font, const QColor &color, double rotation, AnchorSide side, const QString &text) const;
   void applyAnchorTransform(LabelData &labelData) const;
   //void getMaxTickLabelSize(const QFont &font, const QString &text, QSize *tickLabelsSize) const;
-  CachedLabel *createCachedLabel(const LabelData &labelData) const;
+  QCPLabelCachePrivate::CachedLabel createCachedLabel(const LabelData &labelData) const;
   QByteArray cacheKey(const QString &text, const QColor &color, double rotation, AnchorSide side) const;
   AnchorSide skewedAnchorSide(const QPointF &tickPos, double sideExpandHorz, double sideExpandVert) const;
   AnchorSide rotationCorrectedSide(AnchorSide side, double rotation) const;
@@ -1752,11 +1812,13 @@ public:
   TickStepStrategy tickStepStrategy() const { return mTickStepStrategy; }
   int tickCount() const { return mTickCount; }
   double tickOrigin() const { return mTickOrigin; }
+  bool fastLabelFormatting() const { return mFastLabelFormatting; }
   
   // setters:
   void setTickStepStrategy(TickStepStrategy strategy);
   void setTickCount(int count);
   void setTickOrigin(double origin);
+  void setFastLabelFormatting(bool enabled);
   
   // introduced virtual methods:
   virtual void generate(const QCPRange &range, const QLocale &locale, QChar formatChar, int precision, QVector<double> &ticks, QVector<double> *subTicks, QVector<QString> *tickLabels);
@@ -1766,6 +1828,18 @@ protected:
   TickStepStrategy mTickStepStrategy;
   int mTickCount;
   double mTickOrigin;
+  bool mFastLabelFormatting;
+  
+  // non-property members:
+  bool mTickStepCacheValid, mLabelCacheValid;
+  double mCachedRangeSize, mCachedTickStep, mCachedLabelTickStep;
+  QLocale mCachedLocale;
+  QChar mCachedFormatChar;
+  int mCachedPrecision;
+  QVector<double> mCachedTicks;
+  QVector<QString> mCachedTickLabels;
+  QLocale mFastFormatLocale;
+  bool mFastFormatLocaleChecked, mFastFormatDigits, mFastFormatNumbers;
   
   // introduced virtual methods:
   virtual double getTickStep(const QCPRange &range);
@@ -1780,6 +1854,10 @@ protected:
   double pickClosest(double target, const QVector<double> &candidates) const;
   double getMantissa(double input, double *magnitude=nullptr) const;
   double cleanMantissa(double input) const;
+  void invalidateCache();
+  QVector<QString> createLabelVectorCached(double tickStep, const QVector<double> &ticks, const QLocale &locale, QChar formatChar, int precision);
+  bool canFormatFast(const QLocale &locale, bool numbers);
+  QString formatNumber(double value, const QLocale &locale, QChar formatChar, int precision);
   
 private:
   Q_DISABLE_COPY(QCPAxisTicker)
@@ -1829,12 +1907,27 @@ protected:
 # endif
   // non-property members:
   enum DateStrategy {dsNone, dsUniformTimeInDay, dsUniformDayInMonth} mDateStrategy;
+  struct FormatToken
+  {
+    char field; // format character of a date/time field, or '\0' for literal text
+    int width;
+    QString literal;
+  };
+  QVector<FormatToken> mFormatTokens;
+  bool mFormatTokensValid;
+  QHash<qint64, int> mUtcOffsetCache;
   
   // reimplemented virtual methods:
   virtual double getTickStep(const QCPRange &range) Q_DECL_OVERRIDE;
   virtual int getSubTickCount(double tickStep) Q_DECL_OVERRIDE;
   virtual QString getTickLabel(double tick, const QLocale &locale, QChar formatChar, int precision) Q_DECL_OVERRIDE;
   virtual QVector<double> createTickVector(double tickStep, const QCPRange &range) Q_DECL_OVERRIDE;
+  
+  // non-virtual methods:
+  void parseDateTimeFormat();
+  bool utcOffset(qint64 msecs, int &offsetSeconds);
+  int computeUtcOffset(qint64 msecs) const;
+  bool formatDateTimeFast(double tick, QString &result);
 };
 
 /* end of 'src/axis/axistickerdatetime.h' */
@@ -1943,7 +2036,7 @@ public:
   QCPAxisTickerText();
   
   // getters:
-  QMap<double, QString> &ticks() { return mTicks; }
+  QMap<double, QString> &ticks() { invalidateCache(); return mTicks; }
   int subTickCount() const { return mSubTickCount; }
   
   // setters:
@@ -2463,11 +2556,6 @@ public:
   QVector<QString> tickLabels;
   
 protected:
-  struct CachedLabel
-  {
-    QPointF offset;
-    QPixmap pixmap;
-  };
   struct TickLabelData
   {
     QString basePart, expPart, suffixPart;
@@ -2475,8 +2563,7 @@ protected:
     QFont baseFont, expFont;
   };
   QCustomPlot *mParentPlot;
-  QByteArray mLabelParameterHash; // to determine whether mLabelCache needs to be cleared due to changed parameters
-  QCache<QString, CachedLabel> mLabelCache;
+  QByteArray mLabelParameterHash; // prefix of all keys this painter uses in the label cache of the parent plot, updated in draw and size
   QRect mAxisSelectionBox, mTickLabelsSelectionBox, mLabelSelectionBox;
   
   virtual QByteArray generateLabelParameterHash() const;
@@ -2622,6 +2709,7 @@ public:
   int size() const { return mData.size()-mPreallocSize; }
   bool isEmpty() const { return size() == 0; }
   bool autoSqueeze() const { return mAutoSqueeze; }
+  quint64 revision() const { return mRevision; }
   
   // setters:
   void setAutoSqueeze(bool enabled);
@@ -2642,8 +2730,8 @@ public:
   
   const_iterator constBegin() const { return mData.constBegin()+mPreallocSize; }
   const_iterator constEnd() const { return mData.constEnd(); }
-  iterator begin() { return mData.begin()+mPreallocSize; }
-  iterator end() { return mData.end(); }
+  iterator begin() { ++mRevision; return mData.begin()+mPreallocSize; }
+  iterator end() { ++mRevision; return mData.end(); }
   const_iterator findBegin(double sortKey, bool expandedRange=true) const;
   const_iterator findEnd(double sortKey, bool expandedRange=true) const;
   const_iterator at(int index) const { return constBegin()+qBound(0, index, size()); }
@@ -2660,6 +2748,7 @@ protected:
   QVector<DataType> mData;
   int mPreallocSize;
   int mPreallocIteration;
+  quint64 mRevision;
   
   // non-virtual methods:
   void preallocateGrow(int minimumPreallocSize);
@@ -2702,6 +2791,9 @@ protected:
   sort. Failing to do so can not be detected by the container efficiently and will cause both
   rendering artifacts and potential data loss.
 
+  Data points that are rarely accessed, like the old part of a long history, can be moved into a
+  \ref QCPDataArchive, which stores them compressed and decompresses them on demand.
+
   Implementing one-dimensional plottables that make use of a \ref QCPDataContainer<T> is usually
   done by subclassing from \ref QCPAbstractPlottable1D "QCPAbstractPlottable1D<T>", which
   introduces an according \a mDataContainer member and some convenience methods.
@@ -2780,6 +2872,16 @@ protected:
   description of this class.
 */
 
+/*! \fn quint64 QCPDataContainer<DataType>::revision() const
+  
+  Returns a number that changes whenever the data in this container may have changed, i.e. on every
+  call of a modifying method like \ref set, \ref add or \ref remove, and also when non-const
+  iterators are obtained via \ref begin or \ref end.
+  
+  This allows caches derived from the data, such as \ref QCPDataSpatialIndex, to detect that they
+  are outdated.
+*/
+
 /*! \fn QCPDataContainer::const_iterator QCPDataContainer<DataType>::at(int index) const
 
   Returns a const iterator to the element with the specified \a index. If \a index points beyond
@@ -2806,7 +2908,8 @@ template <class DataType>
 QCPDataContainer<DataType>::QCPDataContainer() :
   mAutoSqueeze(true),
   mPreallocSize(0),
-  mPreallocIteration(0)
+  mPreallocIteration(0),
+  mRevision(0)
 {
 }
 
@@ -2854,6 +2957,7 @@ void QCPDataContainer<DataType>::set(const QCPDataContainer<DataType> &data)
 template <class DataType>
 void QCPDataContainer<DataType>::set(const QVector<DataType> &data, bool alreadySorted)
 {
+  ++mRevision;
   mData = data;
   mPreallocSize = 0;
   mPreallocIteration = 0;
@@ -2939,6 +3043,7 @@ void QCPDataContainer<DataType>::add(const QVector<DataType> &data, bool already
 template <class DataType>
 void QCPDataContainer<DataType>::add(const DataType &data)
 {
+  ++mRevision;
   if (isEmpty() || !qcpLessThanSortKey<DataType>(data, *(constEnd()-1))) // quickly handle appends if new data key is greater or equal to existing ones
   {
     mData.append(data);
@@ -3037,6 +3142,7 @@ void QCPDataContainer<DataType>::remove(double sortKey)
 template <class DataType>
 void QCPDataContainer<DataType>::clear()
 {
+  ++mRevision;
   mData.clear();
   mPreallocIteration = 0;
   mPreallocSize = 0;
@@ -3439,181 +3545,789 @@ void QCPDataContainer<DataType>::performAutoSqueeze()
 }
 
 
-/* end of 'src/datacontainer.h' */
-
-
-/* including file 'src/plottable.h'        */
-/* modified 2022-11-06T12:45:56, size 8461 */
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataSpatialIndex
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-class QCP_LIB_DECL QCPSelectionDecorator
+template <class DataType>
+class QCPDataSpatialIndex
 {
-  Q_GADGET
 public:
-  QCPSelectionDecorator();
-  virtual ~QCPSelectionDecorator();
+  /*!
+    Holds the bounding box of the main keys and main values of all data points covered by one node
+    of a \ref QCPDataSpatialIndex. Data points with NaN main key or main value don't contribute to
+    the bounding box, but cause \a hasNaN to be set.
+  */
+  struct Bounds
+  {
+    double keyMin, keyMax, valueMin, valueMax;
+    bool hasNaN;
+    bool isEmpty() const { return keyMin > keyMax; }
+  };
+  
+  QCPDataSpatialIndex();
   
   // getters:
-  QPen pen() const { return mPen; }
-  QBrush brush() const { return mBrush; }
-  QCPScatterStyle scatterStyle() const { return mScatterStyle; }
-  QCPScatterStyle::ScatterProperties usedScatterProperties() const { return mUsedScatterProperties; }
+  int bucketSize() const { return mBucketSize; }
+  int levelCount() const { return int(mLevels.size()); }
+  int nodeCount(int level) const { return int(mLevels.at(level).size()); }
+  const Bounds &node(int level, int index) const { return mLevels.at(level).at(index); }
+  QCPDataRange nodeDataRange(int level, int index) const;
+  bool isUpToDate(const QSharedPointer<QCPDataContainer<DataType> > &data) const;
   
   // setters:
-  void setPen(const QPen &pen);
-  void setBrush(const QBrush &brush);
-  void setScatterStyle(const QCPScatterStyle &scatterStyle, QCPScatterStyle::ScatterProperties usedProperties=QCPScatterStyle::spPen);
-  void setUsedScatterProperties(const QCPScatterStyle::ScatterProperties &properties);
+  void setBucketSize(int size);
   
   // non-virtual methods:
-  void applyPen(QCPPainter *painter) const;
-  void applyBrush(QCPPainter *painter) const;
-  QCPScatterStyle getFinalScatterStyle(const QCPScatterStyle &unselectedStyle) const;
-  
-  // introduced virtual methods:
-  virtual void copyFrom(const QCPSelectionDecorator *other);
-  virtual void drawDecoration(QCPPainter *painter, QCPDataSelection selection);
+  void rebuild(const QSharedPointer<QCPDataContainer<DataType> > &data);
+  void clear();
   
 protected:
   // property members:
-  QPen mPen;
-  QBrush mBrush;
-  QCPScatterStyle mScatterStyle;
-  QCPScatterStyle::ScatterProperties mUsedScatterProperties;
-  // non-property members:
-  QCPAbstractPlottable *mPlottable;
+  int mBucketSize;
   
-  // introduced virtual methods:
-  virtual bool registerWithPlottable(QCPAbstractPlottable *plottable);
+  // non-property members:
+  QVector<QVector<Bounds> > mLevels;
+  QWeakPointer<QCPDataContainer<DataType> > mIndexedData;
+  quint64 mIndexedRevision;
+  int mIndexedSize;
   
-private:
-  Q_DISABLE_COPY(QCPSelectionDecorator)
-  friend class QCPAbstractPlottable;
+  // non-virtual methods:
+  static Bounds emptyBounds();
+  static Bounds unitedBounds(const Bounds &a, const Bounds &b);
 };
-Q_DECLARE_METATYPE(QCPSelectionDecorator*)
 
+// include implementation in header since it is a class template:
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataSpatialIndex
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-class QCP_LIB_DECL QCPAbstractPlottable : public QCPLayerable
-{
-  Q_OBJECT
-  /// \cond INCLUDE_QPROPERTIES
-  Q_PROPERTY(QString name READ name WRITE setName)
-  Q_PROPERTY(bool antialiasedFill READ antialiasedFill WRITE setAntialiasedFill)
-  Q_PROPERTY(bool antialiasedScatters READ antialiasedScatters WRITE setAntialiasedScatters)
-  Q_PROPERTY(QPen pen READ pen WRITE setPen)
-  Q_PROPERTY(QBrush brush READ brush WRITE setBrush)
-  Q_PROPERTY(QCPAxis* keyAxis READ keyAxis WRITE setKeyAxis)
-  Q_PROPERTY(QCPAxis* valueAxis READ valueAxis WRITE setValueAxis)
-  Q_PROPERTY(QCP::SelectionType selectable READ selectable WRITE setSelectable NOTIFY selectableChanged)
-  Q_PROPERTY(QCPDataSelection selection READ selection WRITE setSelection NOTIFY selectionChanged)
-  Q_PROPERTY(QCPSelectionDecorator* selectionDecorator READ selectionDecorator WRITE setSelectionDecorator)
-  /// \endcond
-public:
-  QCPAbstractPlottable(QCPAxis *keyAxis, QCPAxis *valueAxis);
-  virtual ~QCPAbstractPlottable() Q_DECL_OVERRIDE;
-  
-  // getters:
-  QString name() const { return mName; }
-  bool antialiasedFill() const { return mAntialiasedFill; }
-  bool antialiasedScatters() const { return mAntialiasedScatters; }
-  QPen pen() const { return mPen; }
-  QBrush brush() const { return mBrush; }
-  QCPAxis *keyAxis() const { return mKeyAxis.data(); }
-  QCPAxis *valueAxis() const { return mValueAxis.data(); }
-  QCP::SelectionType selectable() const { return mSelectable; }
-  bool selected() const { return !mSelection.isEmpty(); }
-  QCPDataSelection selection() const { return mSelection; }
-  QCPSelectionDecorator *selectionDecorator() const { return mSelectionDecorator; }
+/*! \class QCPDataSpatialIndex
+  \brief A bounding box hierarchy over the data points of a QCPDataContainer
   
-  // setters:
-  void setName(const QString &name);
-  void setAntialiasedFill(bool enabled);
-  void setAntialiasedScatters(bool enabled);
-  void setPen(const QPen &pen);
-  void setBrush(const QBrush &brush);
-  void setKeyAxis(QCPAxis *axis);
-  void setValueAxis(QCPAxis *axis);
-  Q_SLOT void setSelectable(QCP::SelectionType selectable);
-  Q_SLOT void setSelection(QCPDataSelection selection);
-  void setSelectionDecorator(QCPSelectionDecorator *decorator);
-
-  // introduced virtual methods:
-  virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const Q_DECL_OVERRIDE = 0; // actually introduced in QCPLayerable as non-pure, but we want to force reimplementation for plottables
-  virtual QCPPlottableInterface1D *interface1D() { return nullptr; }
-  virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const = 0;
-  virtual QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange()) const = 0;
+  \tparam DataType The type of the data points of the indexed \ref QCPDataContainer.
   
-  // non-property methods:
-  void coordsToPixels(double key, double value, double &x, double &y) const;
-  const QPointF coordsToPixels(double key, double value) const;
-  void pixelsToCoords(double x, double y, double &key, double &value) const;
-  void pixelsToCoords(const QPointF &pixelPos, double &key, double &value) const;
-  void rescaleAxes(bool onlyEnlarge=false) const;
-  void rescaleKeyAxis(bool onlyEnlarge=false) const;
-  void rescaleValueAxis(bool onlyEnlarge=false, bool inKeyRange=false) const;
-  bool addToLegend(QCPLegend *legend);
-  bool addToLegend();
-  bool removeFromLegend(QCPLegend *legend) const;
-  bool removeFromLegend() const;
+  This class partitions the data points of a \ref QCPDataContainer into consecutive buckets of \ref
+  bucketSize points (level 0) and stores the bounding box of the main keys and main values of each
+  bucket. Each following level combines two adjacent nodes of the previous level, until a single
+  root node covers the entire data. The nodes of level \a l thus each cover <tt>bucketSize()*2^l</tt>
+  consecutive data points, as returned by \ref nodeDataRange.
   
-signals:
-  void selectionChanged(bool selected);
-  void selectionChanged(const QCPDataSelection &selection);
-  void selectableChanged(QCP::SelectionType selectable);
+  Hit tests such as \ref QCPAbstractPlottable1D::selectTest and \ref
+  QCPAbstractPlottable1D::selectTestRect use this hierarchy to skip whole groups of data points
+  whose bounding box can't contain the closest point or can't intersect the selection rect. Since
+  the partitioning follows the storage order and not the key, this also works for data that isn't
+  sorted by its main key, like \ref QCPCurveData.
   
-protected:
-  // property members:
-  QString mName;
-  bool mAntialiasedFill, mAntialiasedScatters;
-  QPen mPen;
-  QBrush mBrush;
-  QPointer<QCPAxis> mKeyAxis, mValueAxis;
-  QCP::SelectionType mSelectable;
-  QCPDataSelection mSelection;
-  QCPSelectionDecorator *mSelectionDecorator;
+  The index doesn't update itself. Use \ref isUpToDate to check whether the index still reflects a
+  data container (the index compares the container's \ref QCPDataContainer::revision "revision"),
+  and \ref rebuild to regenerate it. Building the index requires a single pass over the data.
   
-  // reimplemented virtual methods:
-  virtual QRect clipRect() const Q_DECL_OVERRIDE;
-  virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE = 0;
-  virtual QCP::Interaction selectionCategory() const Q_DECL_OVERRIDE;
-  void applyDefaultAntialiasingHint(QCPPainter *painter) const Q_DECL_OVERRIDE;
-  // events:
-  virtual void selectEvent(QMouseEvent *event, bool additive, const QVariant &details, bool *selectionStateChanged) Q_DECL_OVERRIDE;
-  virtual void deselectEvent(bool *selectionStateChanged) Q_DECL_OVERRIDE;
+  Usually you don't need to use this class directly, but enable it on plottables via \ref
+  QCPAbstractPlottable1D::setSpatialIndexing.
+*/
+
+/* start documentation of inline functions */
+
+/*! \fn int QCPDataSpatialIndex<DataType>::levelCount() const
   
-  // introduced virtual methods:
-  virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const = 0;
+  Returns the number of levels of the hierarchy. Level 0 holds the buckets, the last level (\ref
+  levelCount - 1) consists of a single root node. Returns 0 if the index is empty.
+*/
+
+/*! \fn int QCPDataSpatialIndex<DataType>::nodeCount(int level) const
   
-  // non-virtual methods:
-  void applyFillAntialiasingHint(QCPPainter *painter) const;
-  void applyScattersAntialiasingHint(QCPPainter *painter) const;
+  Returns the number of nodes on the specified \a level. The children of node \a i on level \a
+  level are the nodes <tt>2*i</tt> and (if existing) <tt>2*i+1</tt> on level <tt>level-1</tt>.
+*/
 
-private:
-  Q_DISABLE_COPY(QCPAbstractPlottable)
+/*! \fn const Bounds &QCPDataSpatialIndex<DataType>::node(int level, int index) const
   
-  friend class QCustomPlot;
-  friend class QCPAxis;
-  friend class QCPPlottableLegendItem;
-};
+  Returns the bounding box of the node with the specified \a index on \a level.
+  
+  \see nodeDataRange
+*/
 
+/* end documentation of inline functions */
 
-/* end of 'src/plottable.h' */
+/*!
+  Constructs an empty spatial index with a bucket size of 64 data points.
+*/
+template <class DataType>
+QCPDataSpatialIndex<DataType>::QCPDataSpatialIndex() :
+  mBucketSize(64),
+  mIndexedRevision(0),
+  mIndexedSize(0)
+{
+}
 
+/*!
+  Returns the range of data point indices covered by the node with the specified \a index on \a
+  level.
+*/
+template <class DataType>
+QCPDataRange QCPDataSpatialIndex<DataType>::nodeDataRange(int level, int index) const
+{
+  const qint64 span = qint64(mBucketSize) << level;
+  const qint64 begin = qMin(qint64(mIndexedSize), span*index);
+  return QCPDataRange(int(begin), int(qMin(qint64(mIndexedSize), begin+span)));
+}
 
-/* including file 'src/item.h'             */
-/* modified 2022-11-06T12:45:56, size 9425 */
+/*!
+  Returns whether this index was built from the container \a data, and the data of the container
+  wasn't modified since.
+  
+  \see rebuild
+*/
+template <class DataType>
+bool QCPDataSpatialIndex<DataType>::isUpToDate(const QSharedPointer<QCPDataContainer<DataType> > &data) const
+{
+  return data && mIndexedData.toStrongRef() == data && mIndexedRevision == data->revision() && mIndexedSize == data->size();
+}
 
-class QCP_LIB_DECL QCPItemAnchor
+/*!
+  Sets the number of data points which are combined in one node of the lowest level. Smaller sizes
+  make queries visit fewer data points, at the expense of a larger index.
+  
+  Changing the bucket size clears the index, so it must be rebuilt with \ref rebuild before it can
+  be used again.
+*/
+template <class DataType>
+void QCPDataSpatialIndex<DataType>::setBucketSize(int size)
 {
-  Q_GADGET
-public:
-  QCPItemAnchor(QCustomPlot *parentPlot, QCPAbstractItem *parentItem, const QString &name, int anchorId=-1);
-  virtual ~QCPItemAnchor();
+  if (size < 2)
+  {
+    qDebug() << Q_FUNC_INFO << "bucket size must be at least 2" << size;
+    size = 2;
+  }
+  if (mBucketSize != size)
+  {
+    mBucketSize = size;
+    clear();
+  }
+}
+
+/*!
+  Regenerates the index from the data points in \a data. This requires a single pass over the
+  data.
   
-  // getters:
-  QString name() const { return mName; }
-  virtual QPointF pixelPosition() const;
+  \see isUpToDate, clear
+*/
+template <class DataType>
+void QCPDataSpatialIndex<DataType>::rebuild(const QSharedPointer<QCPDataContainer<DataType> > &data)
+{
+  clear();
+  if (!data)
+    return;
+  mIndexedData = data;
+  mIndexedRevision = data->revision();
+  mIndexedSize = data->size();
+  if (mIndexedSize == 0)
+    return;
   
-protected:
+  // fill level 0 with the bounds of the buckets:
+  QVector<Bounds> buckets((mIndexedSize+mBucketSize-1)/mBucketSize);
+  typename QCPDataContainer<DataType>::const_iterator it = data->constBegin();
+  for (int bucket=0; bucket<buckets.size(); ++bucket)
+  {
+    Bounds bounds = emptyBounds();
+    const int bucketEnd = qMin(mIndexedSize, (bucket+1)*mBucketSize);
+    for (int i=bucket*mBucketSize; i<bucketEnd; ++i, ++it)
+    {
+      const double key = it->mainKey();
+      const double value = it->mainValue();
+      if (qIsNaN(key) || qIsNaN(value))
+      {
+        bounds.hasNaN = true;
+        continue;
+      }
+      if (key < bounds.keyMin) bounds.keyMin = key;
+      if (key > bounds.keyMax) bounds.keyMax = key;
+      if (value < bounds.valueMin) bounds.valueMin = value;
+      if (value > bounds.valueMax) bounds.valueMax = value;
+    }
+    buckets[bucket] = bounds;
+  }
+  mLevels.append(buckets);
+  
+  // combine pairs of nodes until only the root node is left:
+  while (mLevels.last().size() > 1)
+  {
+    const QVector<Bounds> lower = mLevels.last();
+    QVector<Bounds> upper((lower.size()+1)/2);
+    for (int i=0; i<upper.size(); ++i)
+    {
+      if (2*i+1 < lower.size())
+        upper[i] = unitedBounds(lower.at(2*i), lower.at(2*i+1));
+      else
+        upper[i] = lower.at(2*i);
+    }
+    mLevels.append(upper);
+  }
+}
+
+/*!
+  Removes all nodes from the index and detaches it from the previously indexed container.
+*/
+template <class DataType>
+void QCPDataSpatialIndex<DataType>::clear()
+{
+  mLevels.clear();
+  mIndexedData.clear();
+  mIndexedRevision = 0;
+  mIndexedSize = 0;
+}
+
+/*! \internal
+  
+  Returns bounds that contain no data point. They are neutral with respect to \ref unitedBounds.
+*/
+template <class DataType>
+typename QCPDataSpatialIndex<DataType>::Bounds QCPDataSpatialIndex<DataType>::emptyBounds()
+{
+  Bounds result;
+  result.keyMin = (std::numeric_limits<double>::max)();
+  result.keyMax = -(std::numeric_limits<double>::max)();
+  result.valueMin = (std::numeric_limits<double>::max)();
+  result.valueMax = -(std::numeric_limits<double>::max)();
+  result.hasNaN = false;
+  return result;
+}
+
+/*! \internal
+  
+  Returns the smallest bounds that contain both \a a and \a b.
+*/
+template <class DataType>
+typename QCPDataSpatialIndex<DataType>::Bounds QCPDataSpatialIndex<DataType>::unitedBounds(const Bounds &a, const Bounds &b)
+{
+  Bounds result;
+  result.keyMin = qMin(a.keyMin, b.keyMin);
+  result.keyMax = qMax(a.keyMax, b.keyMax);
+  result.valueMin = qMin(a.valueMin, b.valueMin);
+  result.valueMax = qMax(a.valueMax, b.valueMax);
+  result.hasNaN = a.hasNaN || b.hasNaN;
+  return result;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPTimeSeriesCodec
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class QCP_LIB_DECL QCPTimeSeriesCodec
+{
+public:
+  /*!
+    Defines how the consecutive values of a column are encoded by \ref QCPTimeSeriesCodec.
+  */
+  enum Encoding { eDeltaOfDelta ///< Stores the change of the difference between consecutive values. Best for evenly spaced, ascending keys
+                  ,eXor         ///< Stores the bits that changed with respect to the previous value. Best for slowly changing values
+                };
+  
+  // static methods:
+  static void encode(const double *data, int count, int stride, Encoding encoding, QByteArray &output);
+  static int decode(const QByteArray &input, int offset, double *data, int count, int stride, Encoding encoding);
+  
+protected:
+  class BitWriter;
+  class BitReader;
+};
+
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataArchive
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class DataType>
+class QCPDataArchive
+{
+  Q_STATIC_ASSERT_X(!QTypeInfo<DataType>::isComplex && sizeof(DataType)%sizeof(double) == 0, "QCPDataArchive requires a data type that consists of doubles only");
+public:
+  QCPDataArchive();
+  
+  // getters:
+  int chunkSize() const { return mChunkSize; }
+  int cacheSize() const { return mCacheSize; }
+  int size() const { return mSize; }
+  bool isEmpty() const { return mSize == 0; }
+  int chunkCount() const { return int(mChunks.size()); }
+  qint64 compressedSize() const;
+  QCPRange sortKeyRange() const;
+  
+  // setters:
+  void setChunkSize(int size);
+  void setCacheSize(int chunks);
+  
+  // non-virtual methods:
+  int compress(QCPDataContainer<DataType> &container, double sortKey);
+  QVector<DataType> data(const QCPRange &sortKeyRange) const;
+  void decompressInto(QCPDataContainer<DataType> &container, const QCPRange &sortKeyRange) const;
+  void clear();
+  
+protected:
+  struct Chunk
+  {
+    double sortKeyLower, sortKeyUpper;
+    int size;
+    QByteArray data;
+  };
+  
+  // property members:
+  int mChunkSize;
+  int mCacheSize;
+  
+  // non-property members:
+  QVector<Chunk> mChunks;
+  int mSize;
+  bool mSorted;
+  mutable QList<QPair<int, QVector<DataType> > > mCache;
+  
+  // non-virtual methods:
+  QVector<DataType> chunkData(int index) const;
+  static QCPTimeSeriesCodec::Encoding fieldEncoding(int field) { return field == 0 ? QCPTimeSeriesCodec::eDeltaOfDelta : QCPTimeSeriesCodec::eXor; }
+};
+
+// include implementation in header since it is a class template:
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataArchive
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPDataArchive
+  \brief Holds data points of a QCPDataContainer in compressed chunks
+  
+  \tparam DataType The type of the data points, like in \ref QCPDataContainer. It must consist of
+  double members only, which is the case for all built-in data types except \ref
+  QCPStatisticalBoxData.
+  
+  Long histories, e.g. of live data that is appended to a graph over hours, keep every data point
+  at full precision in memory, even though the old part is rarely looked at. \ref compress moves
+  the data points below a given sort key out of a \ref QCPDataContainer into this archive, in
+  chunks of \ref chunkSize points. Each chunk is compressed losslessly with \ref
+  QCPTimeSeriesCodec: the first member of the data type (the key for all built-in data types) is
+  stored as delta of delta, since keys are typically evenly spaced, the other members are stored
+  as the bits that differ from the previous data point. Typical time series shrink to a fraction of
+  their size this way.
+  
+  When the archived data is needed again, e.g. because the user scrolls the key axis back or the
+  data is exported, \ref data or \ref decompressInto decompress the chunks that overlap the
+  requested sort key range. The last \ref cacheSize decompressed chunks are kept, so repeatedly
+  accessing the same region, like when dragging the axis range, doesn't decompress it again.
+  
+  The data should be compressed in ascending sort key order, i.e. each call of \ref compress should
+  only move data points that don't lie below the already archived ones. Otherwise \ref data has to
+  merge the chunks, which makes it slower.
+*/
+
+/* start documentation of inline functions */
+
+/*! \fn int QCPDataArchive<DataType>::size() const
+  
+  Returns the number of data points in the archive.
+*/
+
+/*! \fn int QCPDataArchive<DataType>::chunkCount() const
+  
+  Returns the number of compressed chunks the data points of the archive are stored in.
+*/
+
+/* end documentation of inline functions */
+
+/*!
+  Constructs an empty archive with a chunk size of 4096 data points and a cache of 8 chunks.
+*/
+template <class DataType>
+QCPDataArchive<DataType>::QCPDataArchive() :
+  mChunkSize(4096),
+  mCacheSize(8),
+  mSize(0),
+  mSorted(true)
+{
+}
+
+/*!
+  Returns the memory in bytes that the compressed data points occupy. This doesn't include the
+  decompressed chunks in the cache.
+*/
+template <class DataType>
+qint64 QCPDataArchive<DataType>::compressedSize() const
+{
+  qint64 result = 0;
+  for (int i=0; i<mChunks.size(); ++i)
+    result += mChunks.at(i).data.size();
+  return result;
+}
+
+/*!
+  Returns the range spanned by the sort keys of all data points in the archive. If the archive is
+  empty, returns a default constructed QCPRange.
+*/
+template <class DataType>
+QCPRange QCPDataArchive<DataType>::sortKeyRange() const
+{
+  if (mChunks.isEmpty())
+    return QCPRange();
+  QCPRange result(mChunks.first().sortKeyLower, mChunks.first().sortKeyUpper);
+  for (int i=1; i<mChunks.size(); ++i)
+  {
+    result.expand(mChunks.at(i).sortKeyLower);
+    result.expand(mChunks.at(i).sortKeyUpper);
+  }
+  return result;
+}
+
+/*!
+  Sets the number of data points that are compressed together. Larger chunks compress slightly
+  better, but each access decompresses at least one chunk. The chunk size applies to chunks created
+  by subsequent calls of \ref compress.
+*/
+template <class DataType>
+void QCPDataArchive<DataType>::setChunkSize(int size)
+{
+  if (size < 2)
+  {
+    qDebug() << Q_FUNC_INFO << "chunk size must be at least 2" << size;
+    size = 2;
+  }
+  mChunkSize = size;
+}
+
+/*!
+  Sets how many decompressed chunks are kept for subsequent accesses. Set \a chunks to 0 to disable
+  the cache.
+*/
+template <class DataType>
+void QCPDataArchive<DataType>::setCacheSize(int chunks)
+{
+  mCacheSize = qMax(0, chunks);
+  while (mCache.size() > mCacheSize)
+    mCache.removeLast();
+}
+
+/*!
+  Compresses the data points of \a container with sort keys below \a sortKey into this archive, and
+  removes them from \a container. Returns the number of data points that were moved.
+  
+  Only whole chunks of \ref chunkSize data points are compressed, so the remaining data points
+  below \a sortKey stay in \a container until enough have accumulated for a further chunk. This
+  allows calling this method regularly, e.g. whenever new data is appended to a live graph, with a
+  \a sortKey some distance behind the newest data point. Data points with equal sort keys are never
+  split between the archive and \a container.
+  
+  \see decompressInto
+*/
+template <class DataType>
+int QCPDataArchive<DataType>::compress(QCPDataContainer<DataType> &container, double sortKey)
+{
+  const typename QCPDataContainer<DataType>::const_iterator begin = container.constBegin();
+  typename QCPDataContainer<DataType>::const_iterator cut = container.findBegin(sortKey, false);
+  cut = begin + int(cut-begin)/mChunkSize*mChunkSize;
+  // don't split data points with equal sort keys, so the rest can be removed by sort key:
+  while (cut != begin && cut != container.constEnd() && (cut-1)->sortKey() == cut->sortKey())
+    --cut;
+  const int count = int(cut-begin);
+  if (count == 0)
+    return 0;
+  
+  const int fieldCount = int(sizeof(DataType)/sizeof(double));
+  QVector<double> fields(qMin(count, mChunkSize)*fieldCount);
+  for (typename QCPDataContainer<DataType>::const_iterator it = begin; it != cut; )
+  {
+    Chunk chunk;
+    chunk.size = qMin(mChunkSize, int(cut-it));
+    chunk.sortKeyLower = it->sortKey();
+    chunk.sortKeyUpper = (it+chunk.size-1)->sortKey();
+    memcpy(fields.data(), &*it, size_t(chunk.size)*sizeof(DataType));
+    for (int field=0; field<fieldCount; ++field)
+      QCPTimeSeriesCodec::encode(fields.constData()+field, chunk.size, fieldCount, fieldEncoding(field), chunk.data);
+    chunk.data.squeeze();
+    if (!mChunks.isEmpty() && chunk.sortKeyLower < mChunks.last().sortKeyUpper)
+      mSorted = false;
+    mChunks.append(chunk);
+    mSize += chunk.size;
+    it += chunk.size;
+  }
+  
+  if (cut == container.constEnd())
+    container.clear();
+  else
+    container.removeBefore(cut->sortKey());
+  return count;
+}
+
+/*!
+  Returns the archived data points with sort keys inside \a sortKeyRange (including the bounds),
+  ordered by sort key. Only the chunks that overlap \a sortKeyRange are decompressed.
+  
+  \see decompressInto
+*/
+template <class DataType>
+QVector<DataType> QCPDataArchive<DataType>::data(const QCPRange &sortKeyRange) const
+{
+  QVector<DataType> result;
+  for (int i=0; i<mChunks.size(); ++i)
+  {
+    const Chunk &chunk = mChunks.at(i);
+    if (chunk.sortKeyUpper < sortKeyRange.lower || chunk.sortKeyLower > sortKeyRange.upper)
+      continue;
+    const QVector<DataType> points = chunkData(i);
+    typename QVector<DataType>::const_iterator lower = std::lower_bound(points.constBegin(), points.constEnd(), DataType::fromSortKey(sortKeyRange.lower), qcpLessThanSortKey<DataType>);
+    typename QVector<DataType>::const_iterator upper = std::upper_bound(lower, points.constEnd(), DataType::fromSortKey(sortKeyRange.upper), qcpLessThanSortKey<DataType>);
+    const int oldSize = result.size();
+    result.resize(oldSize+int(upper-lower));
+    std::copy(lower, upper, result.begin()+oldSize);
+  }
+  if (!mSorted)
+    std::stable_sort(result.begin(), result.end(), qcpLessThanSortKey<DataType>);
+  return result;
+}
+
+/*!
+  Adds the archived data points with sort keys inside \a sortKeyRange to \a container. The data
+  points stay in the archive.
+  
+  To display an archived region, e.g. after the user dragged the key axis range into the past, pass
+  a copy of the plottable's live data container and the visible key range to this method, and set
+  the result as the plottable's data.
+  
+  \see data
+*/
+template <class DataType>
+void QCPDataArchive<DataType>::decompressInto(QCPDataContainer<DataType> &container, const QCPRange &sortKeyRange) const
+{
+  container.add(data(sortKeyRange), true);
+}
+
+/*!
+  Removes all data points from the archive and clears the cache.
+*/
+template <class DataType>
+void QCPDataArchive<DataType>::clear()
+{
+  mChunks.clear();
+  mCache.clear();
+  mSize = 0;
+  mSorted = true;
+}
+
+/*! \internal
+  
+  Returns the decompressed data points of the chunk with the specified \a index, either from the
+  cache or by decompressing it. Decompressed chunks are added to the front of the cache, evicting
+  the least recently used ones if necessary.
+*/
+template <class DataType>
+QVector<DataType> QCPDataArchive<DataType>::chunkData(int index) const
+{
+  for (int i=0; i<mCache.size(); ++i)
+  {
+    if (mCache.at(i).first == index)
+    {
+      if (i > 0)
+        mCache.move(i, 0);
+      return mCache.first().second;
+    }
+  }
+  
+  const Chunk &chunk = mChunks.at(index);
+  const int fieldCount = int(sizeof(DataType)/sizeof(double));
+  QVector<double> fields(chunk.size*fieldCount);
+  int offset = 0;
+  for (int field=0; field<fieldCount && offset >= 0; ++field)
+    offset = QCPTimeSeriesCodec::decode(chunk.data, offset, fields.data()+field, chunk.size, fieldCount, fieldEncoding(field));
+  if (offset < 0)
+  {
+    qDebug() << Q_FUNC_INFO << "corrupt chunk" << index;
+    return QVector<DataType>();
+  }
+  QVector<DataType> result(chunk.size);
+  memcpy(result.data(), fields.constData(), size_t(chunk.size)*sizeof(DataType));
+  if (mCacheSize > 0)
+  {
+    mCache.prepend(qMakePair(index, result));
+    while (mCache.size() > mCacheSize)
+      mCache.removeLast();
+  }
+  return result;
+}
+
+
+/* end of 'src/datacontainer.h' */
+
+
+/* including file 'src/plottable.h'        */
+/* modified 2022-11-06T12:45:56, size 8461 */
+
+class QCP_LIB_DECL QCPSelectionDecorator
+{
+  Q_GADGET
+public:
+  QCPSelectionDecorator();
+  virtual ~QCPSelectionDecorator();
+  
+  // getters:
+  QPen pen() const { return mPen; }
+  QBrush brush() const { return mBrush; }
+  QCPScatterStyle scatterStyle() const { return mScatterStyle; }
+  QCPScatterStyle::ScatterProperties usedScatterProperties() const { return mUsedScatterProperties; }
+  
+  // setters:
+  void setPen(const QPen &pen);
+  void setBrush(const QBrush &brush);
+  void setScatterStyle(const QCPScatterStyle &scatterStyle, QCPScatterStyle::ScatterProperties usedProperties=QCPScatterStyle::spPen);
+  void setUsedScatterProperties(const QCPScatterStyle::ScatterProperties &properties);
+  
+  // non-virtual methods:
+  void applyPen(QCPPainter *painter) const;
+  void applyBrush(QCPPainter *painter) const;
+  QCPScatterStyle getFinalScatterStyle(const QCPScatterStyle &unselectedStyle) const;
+  
+  // introduced virtual methods:
+  virtual void copyFrom(const QCPSelectionDecorator *other);
+  virtual void drawDecoration(QCPPainter *painter, QCPDataSelection selection);
+  
+protected:
+  // property members:
+  QPen mPen;
+  QBrush mBrush;
+  QCPScatterStyle mScatterStyle;
+  QCPScatterStyle::ScatterProperties mUsedScatterProperties;
+  // non-property members:
+  QCPAbstractPlottable *mPlottable;
+  
+  // introduced virtual methods:
+  virtual bool registerWithPlottable(QCPAbstractPlottable *plottable);
+  
+private:
+  Q_DISABLE_COPY(QCPSelectionDecorator)
+  friend class QCPAbstractPlottable;
+};
+Q_DECLARE_METATYPE(QCPSelectionDecorator*)
+
+
+class QCP_LIB_DECL QCPAbstractPlottable : public QCPLayerable
+{
+  Q_OBJECT
+  /// \cond INCLUDE_QPROPERTIES
+  Q_PROPERTY(QString name READ name WRITE setName)
+  Q_PROPERTY(bool antialiasedFill READ antialiasedFill WRITE setAntialiasedFill)
+  Q_PROPERTY(bool antialiasedScatters READ antialiasedScatters WRITE setAntialiasedScatters)
+  Q_PROPERTY(QPen pen READ pen WRITE setPen)
+  Q_PROPERTY(QBrush brush READ brush WRITE setBrush)
+  Q_PROPERTY(QCPAxis* keyAxis READ keyAxis WRITE setKeyAxis)
+  Q_PROPERTY(QCPAxis* valueAxis READ valueAxis WRITE setValueAxis)
+  Q_PROPERTY(QCP::SelectionType selectable READ selectable WRITE setSelectable NOTIFY selectableChanged)
+  Q_PROPERTY(QCPDataSelection selection READ selection WRITE setSelection NOTIFY selectionChanged)
+  Q_PROPERTY(QCPSelectionDecorator* selectionDecorator READ selectionDecorator WRITE setSelectionDecorator)
+  /// \endcond
+public:
+  QCPAbstractPlottable(QCPAxis *keyAxis, QCPAxis *valueAxis);
+  virtual ~QCPAbstractPlottable() Q_DECL_OVERRIDE;
+  
+  // getters:
+  QString name() const { return mName; }
+  bool antialiasedFill() const { return mAntialiasedFill; }
+  bool antialiasedScatters() const { return mAntialiasedScatters; }
+  QPen pen() const { return mPen; }
+  QBrush brush() const { return mBrush; }
+  QCPAxis *keyAxis() const { return mKeyAxis.data(); }
+  QCPAxis *valueAxis() const { return mValueAxis.data(); }
+  QCP::SelectionType selectable() const { return mSelectable; }
+  bool selected() const { return !mSelection.isEmpty(); }
+  QCPDataSelection selection() const { return mSelection; }
+  QCPSelectionDecorator *selectionDecorator() const { return mSelectionDecorator; }
+  
+  // setters:
+  void setName(const QString &name);
+  void setAntialiasedFill(bool enabled);
+  void setAntialiasedScatters(bool enabled);
+  void setPen(const QPen &pen);
+  void setBrush(const QBrush &brush);
+  void setKeyAxis(QCPAxis *axis);
+  void setValueAxis(QCPAxis *axis);
+  Q_SLOT void setSelectable(QCP::SelectionType selectable);
+  Q_SLOT void setSelection(QCPDataSelection selection);
+  void setSelectionDecorator(QCPSelectionDecorator *decorator);
+
+  // introduced virtual methods:
+  virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const Q_DECL_OVERRIDE = 0; // actually introduced in QCPLayerable as non-pure, but we want to force reimplementation for plottables
+  virtual QCPPlottableInterface1D *interface1D() { return nullptr; }
+  virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const = 0;
+  virtual QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange()) const = 0;
+  
+  // non-property methods:
+  void coordsToPixels(double key, double value, double &x, double &y) const;
+  const QPointF coordsToPixels(double key, double value) const;
+  void pixelsToCoords(double x, double y, double &key, double &value) const;
+  void pixelsToCoords(const QPointF &pixelPos, double &key, double &value) const;
+  void rescaleAxes(bool onlyEnlarge=false) const;
+  void rescaleKeyAxis(bool onlyEnlarge=false) const;
+  void rescaleValueAxis(bool onlyEnlarge=false, bool inKeyRange=false) const;
+  bool addToLegend(QCPLegend *legend);
+  bool addToLegend();
+  bool removeFromLegend(QCPLegend *legend) const;
+  bool removeFromLegend() const;
+  
+signals:
+  void selectionChanged(bool selected);
+  void selectionChanged(const QCPDataSelection &selection);
+  void selectableChanged(QCP::SelectionType selectable);
+  
+protected:
+  // property members:
+  QString mName;
+  bool mAntialiasedFill, mAntialiasedScatters;
+  QPen mPen;
+  QBrush mBrush;
+  QPointer<QCPAxis> mKeyAxis, mValueAxis;
+  QCP::SelectionType mSelectable;
+  QCPDataSelection mSelection;
+  QCPSelectionDecorator *mSelectionDecorator;
+  
+  // reimplemented virtual methods:
+  virtual QRect clipRect() const Q_DECL_OVERRIDE;
+  virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE = 0;
+  virtual QCP::Interaction selectionCategory() const Q_DECL_OVERRIDE;
+  void applyDefaultAntialiasingHint(QCPPainter *painter) const Q_DECL_OVERRIDE;
+  // events:
+  virtual void selectEvent(QMouseEvent *event, bool additive, const QVariant &details, bool *selectionStateChanged) Q_DECL_OVERRIDE;
+  virtual void deselectEvent(bool *selectionStateChanged) Q_DECL_OVERRIDE;
+  
+  // introduced virtual methods:
+  virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const = 0;
+  
+  // non-virtual methods:
+  void applyFillAntialiasingHint(QCPPainter *painter) const;
+  void applyScattersAntialiasingHint(QCPPainter *painter) const;
+
+private:
+  Q_DISABLE_COPY(QCPAbstractPlottable)
+  
+  friend class QCustomPlot;
+  friend class QCPAxis;
+  friend class QCPPlottableLegendItem;
+};
+
+
+/* end of 'src/plottable.h' */
+
+
+/* including file 'src/item.h'             */
+/* modified 2022-11-06T12:45:56, size 9425 */
+
+class QCP_LIB_DECL QCPItemAnchor
+{
+  Q_GADGET
+public:
+  QCPItemAnchor(QCustomPlot *parentPlot, QCPAbstractItem *parentItem, const QString &name, int anchorId=-1);
+  virtual ~QCPItemAnchor();
+  
+  // getters:
+  QString name() const { return mName; }
+  virtual QPointF pixelPosition() const;
+  
+protected:
   // property members:
   QString mName;
   
@@ -3787,6 +4501,52 @@ private:
 /* including file 'src/core.h'              */
 /* modified 2022-11-06T12:45:56, size 19304 */
 
+class QCP_LIB_DECL QCPReplotProfile
+{
+public:
+  /*!
+    Holds the timing of one step of a replot, see \ref QCPReplotProfile.
+  */
+  struct Event
+  {
+    QString name;         ///< the name of the step, e.g. the layer name or the plottable class and name
+    QString category;     ///< the kind of step, see the detailed description of \ref QCPReplotProfile
+    qint64 start;         ///< the start of the step in nanoseconds, relative to the start of the replot
+    qint64 duration;      ///< the duration of the step in nanoseconds
+    int depth;            ///< the nesting depth, 0 for the top level replot phases
+    qint64 dataCount;     ///< the number of data points the step processed, or -1 if not applicable
+    qint64 sampledCount;  ///< the number of points that remained after adaptive sampling, or -1 if not applicable
+  };
+  
+  QCPReplotProfile();
+  
+  // getters:
+  const QVector<Event> &events() const { return mEvents; }
+  qint64 duration() const { return mDuration; }
+  bool isRecording() const { return mRecording; }
+  
+  // non-virtual methods:
+  QVector<Event> events(const QString &category) const;
+  qint64 totalDuration(const QString &category) const;
+  QByteArray toChromeTrace() const;
+  bool saveChromeTrace(const QString &fileName) const;
+  void start();
+  void finish();
+  int beginEvent(const QString &name, const QString &category);
+  void endEvent(int event, qint64 dataCount=-1, qint64 sampledCount=-1);
+  
+protected:
+  // non-property members:
+  QVector<Event> mEvents;
+  QElapsedTimer mTimer;
+  qint64 mDuration;
+  int mDepth;
+  bool mRecording;
+  
+  // non-virtual methods:
+  static QByteArray jsonString(const QString &text);
+};
+
 class QCP_LIB_DECL QCustomPlot : public QWidget
 {
   Q_OBJECT
@@ -3846,6 +4606,9 @@ public:
   QCP::SelectionRectMode selectionRectMode() const { return mSelectionRectMode; }
   QCPSelectionRect *selectionRect() const { return mSelectionRect; }
   bool openGl() const { return mOpenGl; }
+  int labelCacheSize() const;
+  bool profiling() const { return mProfiling; }
+  const QCPReplotProfile &replotProfile() const { return mReplotProfile; }
   
   // setters:
   void setViewport(const QRect &rect);
@@ -3870,6 +4633,8 @@ public:
   void setSelectionRectMode(QCP::SelectionRectMode mode);
   void setSelectionRect(QCPSelectionRect *selectionRect);
   void setOpenGl(bool enabled, int multisampling=16);
+  void setLabelCacheSize(int kilobytes);
+  void setProfiling(bool enabled);
   
   // non-property methods:
   // plottable interface:
@@ -3940,6 +4705,7 @@ public:
   void toPainter(QCPPainter *painter, int width=0, int height=0);
   Q_SLOT void replot(QCustomPlot::RefreshPriority refreshPriority=QCustomPlot::rpRefreshHint);
   double replotTime(bool average=false) const;
+  void invalidateLayout();
   
   QCPAxis *xAxis, *yAxis, *xAxis2, *yAxis2;
   QCPLegend *legend;
@@ -3964,6 +4730,7 @@ signals:
   void beforeReplot();
   void afterLayout();
   void afterReplot();
+  void replotProfiled(const QCPReplotProfile &profile);
   
 protected:
   // property members:
@@ -3990,6 +4757,7 @@ protected:
   QCP::SelectionRectMode mSelectionRectMode;
   QCPSelectionRect *mSelectionRect;
   bool mOpenGl;
+  bool mProfiling;
   
   // non-property members:
   QList<QSharedPointer<QCPAbstractPaintBuffer> > mPaintBuffers;
@@ -4001,10 +4769,15 @@ protected:
   QVariant mMouseSignalLayerableDetails;
   bool mReplotting;
   bool mReplotQueued;
+  bool mLayoutValid;
   double mReplotTime, mReplotTimeAverage;
   int mOpenGlMultisamples;
   QCP::AntialiasedElements mOpenGlAntialiasedElementsBackup;
   bool mOpenGlCacheLabelsBackup;
+  QCPLabelCachePrivate *mLabelCache;
+  bool mScaledBackgroundSmooth;
+  QTimer *mBackgroundRescaleTimer;
+  QCPReplotProfile mReplotProfile;
 #ifdef QCP_OPENGL_FBO
   QSharedPointer<QOpenGLContext> mGlContext;
   QSharedPointer<QSurface> mGlSurface;
@@ -4039,6 +4812,9 @@ protected:
   QCPLayerable *layerableAt(const QPointF &pos, bool onlySelectable, QVariant *selectionDetails=nullptr) const;
   QList<QCPLayerable*> layerableListAt(const QPointF &pos, bool onlySelectable, QList<QVariant> *selectionDetails=nullptr) const;
   void drawBackground(QCPPainter *painter);
+  Q_SLOT void rescaleBackgroundSmooth();
+  QCPReplotProfile *activeProfile();
+  bool axisMarginsValid() const;
   void setupPaintBuffers();
   QCPAbstractPaintBuffer *createPaintBuffer();
   bool hasInvalidatedPaintBuffers();
@@ -4052,6 +4828,8 @@ protected:
   friend class QCPAbstractPlottable;
   friend class QCPGraph;
   friend class QCPAbstractItem;
+  friend class QCPAxisPainterPrivate;
+  friend class QCPLabelPainterPrivate;
 };
 Q_DECLARE_METATYPE(QCustomPlot::LayerInsertMode)
 Q_DECLARE_METATYPE(QCustomPlot::RefreshPriority)
@@ -4195,6 +4973,15 @@ public:
   virtual int findBegin(double sortKey, bool expandedRange=true) const Q_DECL_OVERRIDE;
   virtual int findEnd(double sortKey, bool expandedRange=true) const Q_DECL_OVERRIDE;
   
+  // getters:
+  bool spatialIndexing() const { return mSpatialIndexing; }
+  
+  // setters:
+  void setSpatialIndexing(bool enabled);
+  
+  // non-virtual methods:
+  int findNearestData(const QPointF &pixelPos, double maxPixelDistance, double *interpolatedValue=nullptr) const;
+  
   // reimplemented virtual methods:
   virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const Q_DECL_OVERRIDE;
   virtual QCPPlottableInterface1D *interface1D() Q_DECL_OVERRIDE { return this; }
@@ -4202,10 +4989,23 @@ public:
 protected:
   // property members:
   QSharedPointer<QCPDataContainer<DataType> > mDataContainer;
+  bool mSpatialIndexing;
+  
+  // non-property members:
+  mutable QCPDataSpatialIndex<DataType> mSpatialIndex;
+  
+  // introduced virtual methods:
+  virtual double indexedSegmentDistanceSqr(const QCPVector2D &pixelPoint, typename QCPDataContainer<DataType>::const_iterator segmentStart) const;
   
   // helpers for subclasses:
   void getDataSegments(QList<QCPDataRange> &selectedSegments, QList<QCPDataRange> &unselectedSegments) const;
   void drawPolyline(QCPPainter *painter, const QVector<QPointF> &lineData) const;
+  const QCPDataSpatialIndex<DataType> *spatialIndex() const;
+  QRectF nodePixelRect(const typename QCPDataSpatialIndex<DataType>::Bounds &bounds) const;
+  int indexedClosestData(const QPointF &pixelPoint, const QCPDataRange &dataRange, bool onlyVisible, double &minDistSqr) const;
+  QCPDataSelection indexedSelectTestRect(const QCPRange &keyRange, const QCPRange &valueRange, const QCPDataRange &dataRange) const;
+  double indexedLineDistanceSqr(const QPointF &pixelPoint, const QCPDataRange &segmentRange, double minDistSqr) const;
+  static double pixelRectDistanceSqr(const QRectF &rect, const QPointF &point);
 
 private:
   Q_DISABLE_COPY(QCPAbstractPlottable1D)
@@ -4382,6 +5182,9 @@ private:
   QCPPlottableInterface1D::selectTestRect, assuming point-like data points, based on the 1D data
   interface. In spite of that, most plottable subclasses will want to reimplement those methods
   again, to provide a more accurate hit test based on their specific data visualization geometry.
+  
+  For large data sets, hit tests can be accelerated with \ref setSpatialIndexing, which maintains a
+  \ref QCPDataSpatialIndex over the data and lets the hit tests skip whole groups of data points.
 */
 
 /* start documentation of inline functions */
@@ -4394,6 +5197,13 @@ private:
   \seebaseclassmethod
 */
 
+/*! \fn bool QCPAbstractPlottable1D::spatialIndexing() const
+  
+  Returns whether hit tests use a spatial index over the data.
+  
+  \see setSpatialIndexing
+*/
+
 /* end documentation of inline functions */
 
 /*!
@@ -4403,7 +5213,8 @@ private:
 template <class DataType>
 QCPAbstractPlottable1D<DataType>::QCPAbstractPlottable1D(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   QCPAbstractPlottable(keyAxis, valueAxis),
-  mDataContainer(new QCPDataContainer<DataType>)
+  mDataContainer(new QCPDataContainer<DataType>),
+  mSpatialIndexing(false)
 {
 }
 
@@ -4543,6 +5354,13 @@ QCPDataSelection QCPAbstractPlottable1D<DataType>::selectTestRect(const QRectF &
   if (begin == end)
     return result;
   
+  if (spatialIndex()) // skip data points that can't be inside rect, and add those that are entirely inside as a whole
+  {
+    result = indexedSelectTestRect(keyRange, valueRange, QCPDataRange(int(begin-mDataContainer->constBegin()), int(end-mDataContainer->constBegin())));
+    result.simplify();
+    return result;
+  }
+  
   int currentSegmentBegin = -1; // -1 means we're currently not in a segment that's contained in rect
   for (typename QCPDataContainer<DataType>::const_iterator it=begin; it!=end; ++it)
   {
@@ -4582,6 +5400,138 @@ int QCPAbstractPlottable1D<DataType>::findEnd(double sortKey, bool expandedRange
   return int(mDataContainer->findEnd(sortKey, expandedRange)-mDataContainer->constBegin());
 }
 
+/*!
+  Sets whether hit tests (\ref selectTest and \ref selectTestRect) use a spatial index over the
+  data of this plottable.
+  
+  The index (see \ref QCPDataSpatialIndex) is built lazily on the first hit test after the data was
+  modified, which takes a single pass over the data. After that, hit tests only need to visit the
+  data points close to the tested position or the border of the selection rect, instead of all
+  data points in the tested key range. This is beneficial for large data sets that are hit tested
+  repeatedly, e.g. when reacting to mouse hover, or for data that isn't sorted by its main key (like
+  \ref QCPCurve), where the non-indexed hit tests need to check every data point.
+  
+  If the data changes very frequently compared to the hit tests (e.g. in real time plots), leave
+  this disabled to avoid rebuilding the index.
+  
+  Disabling the spatial indexing frees the memory of the index.
+*/
+template <class DataType>
+void QCPAbstractPlottable1D<DataType>::setSpatialIndexing(bool enabled)
+{
+  mSpatialIndexing = enabled;
+  if (!mSpatialIndexing)
+    mSpatialIndex.clear();
+}
+
+/*!
+  Returns the index of the data point whose pixel position is closest to \a pixelPos, e.g. for a
+  coordinate readout that snaps to the data while the mouse hovers over the plot. Only data points
+  within \a maxPixelDistance pixels are considered. Pass a negative \a maxPixelDistance to consider
+  all data points. Returns -1 if no data point is close enough.
+  
+  If the data is sorted by the main key (see \ref sortKeyIsMainKey), the data point at the key of
+  \a pixelPos is found by binary search, and the search proceeds to both sides only as long as the
+  key distance alone is smaller than the distance of the closest point found so far. So the cost
+  depends on the data density around \a pixelPos and not on the total number of data points. If
+  \ref setSpatialIndexing "spatial indexing" is enabled, the spatial index is used instead, which
+  also copes with many data points at almost the same key.
+  
+  If \a interpolatedValue is not zero, it is set to the main value at the key of \a pixelPos,
+  linearly interpolated between the adjacent data points. It is set to NaN if the key lies outside
+  the data, or if the data isn't sorted by the main key.
+  
+  \see selectTest
+*/
+template <class DataType>
+int QCPAbstractPlottable1D<DataType>::findNearestData(const QPointF &pixelPos, double maxPixelDistance, double *interpolatedValue) const
+{
+  if (interpolatedValue)
+    *interpolatedValue = qQNaN();
+  if (!mKeyAxis || !mValueAxis || mDataContainer->isEmpty())
+    return -1;
+  
+  double posKey, posValue;
+  pixelsToCoords(pixelPos, posKey, posValue);
+  typename QCPDataContainer<DataType>::const_iterator begin = mDataContainer->constBegin();
+  typename QCPDataContainer<DataType>::const_iterator end = mDataContainer->constEnd();
+  typename QCPDataContainer<DataType>::const_iterator center = begin;
+  if (DataType::sortKeyIsMainKey())
+  {
+    center = mDataContainer->findBegin(posKey, false);
+    if (interpolatedValue && center != end)
+    {
+      if (center->mainKey() == posKey)
+        *interpolatedValue = center->mainValue();
+      else if (center != begin)
+      {
+        const typename QCPDataContainer<DataType>::const_iterator previous = center-1;
+        *interpolatedValue = previous->mainValue() + (center->mainValue()-previous->mainValue())*(posKey-previous->mainKey())/(center->mainKey()-previous->mainKey());
+      }
+    }
+    if (maxPixelDistance >= 0) // only the keys within the pixel distance come into question
+    {
+      double posKeyMin, posKeyMax, dummy;
+      pixelsToCoords(pixelPos-QPointF(maxPixelDistance, maxPixelDistance), posKeyMin, dummy);
+      pixelsToCoords(pixelPos+QPointF(maxPixelDistance, maxPixelDistance), posKeyMax, dummy);
+      if (posKeyMin > posKeyMax)
+        qSwap(posKeyMin, posKeyMax);
+      begin = mDataContainer->findBegin(posKeyMin, false);
+      end = mDataContainer->findEnd(posKeyMax, false);
+      center = qBound(begin, center, end);
+    }
+  }
+  if (begin == end)
+    return -1;
+  
+  double minDistSqr = maxPixelDistance < 0 ? (std::numeric_limits<double>::max)() : maxPixelDistance*maxPixelDistance;
+  if (spatialIndex())
+    return indexedClosestData(pixelPos, QCPDataRange(int(begin-mDataContainer->constBegin()), int(end-mDataContainer->constBegin())), false, minDistSqr);
+  
+  int result = -1;
+  if (DataType::sortKeyIsMainKey()) // walk away from the key of pixelPos to both sides, until the key distance alone exceeds the closest distance
+  {
+    const double posKeyPixel = mKeyAxis->coordToPixel(posKey);
+    for (typename QCPDataContainer<DataType>::const_iterator it=center; it!=end; ++it)
+    {
+      const double keyDist = mKeyAxis->coordToPixel(it->mainKey())-posKeyPixel;
+      if (keyDist*keyDist >= minDistSqr)
+        break;
+      const double currentDistSqr = QCPVector2D(coordsToPixels(it->mainKey(), it->mainValue())-pixelPos).lengthSquared();
+      if (currentDistSqr < minDistSqr)
+      {
+        minDistSqr = currentDistSqr;
+        result = int(it-mDataContainer->constBegin());
+      }
+    }
+    for (typename QCPDataContainer<DataType>::const_iterator it=center; it!=begin; )
+    {
+      --it;
+      const double keyDist = mKeyAxis->coordToPixel(it->mainKey())-posKeyPixel;
+      if (keyDist*keyDist >= minDistSqr)
+        break;
+      const double currentDistSqr = QCPVector2D(coordsToPixels(it->mainKey(), it->mainValue())-pixelPos).lengthSquared();
+      if (currentDistSqr < minDistSqr)
+      {
+        minDistSqr = currentDistSqr;
+        result = int(it-mDataContainer->constBegin());
+      }
+    }
+  } else
+  {
+    for (typename QCPDataContainer<DataType>::const_iterator it=begin; it!=end; ++it)
+    {
+      const double currentDistSqr = QCPVector2D(coordsToPixels(it->mainKey(), it->mainValue())-pixelPos).lengthSquared();
+      if (currentDistSqr < minDistSqr)
+      {
+        minDistSqr = currentDistSqr;
+        result = int(it-mDataContainer->constBegin());
+      }
+    }
+  }
+  return result;
+}
+
 /*!
   Implements a point-selection algorithm assuming the data (accessed via the 1D data interface) is
   point-like. Most subclasses will want to reimplement this method again, to provide a more
@@ -4619,19 +5569,27 @@ double QCPAbstractPlottable1D<DataType>::selectTest(const QPointF &pos, bool onl
   }
   if (begin == end)
     return -1;
-  QCPRange keyRange(mKeyAxis->range());
-  QCPRange valueRange(mValueAxis->range());
-  for (typename QCPDataContainer<DataType>::const_iterator it=begin; it!=end; ++it)
+  if (spatialIndex()) // only visit data points whose index node may contain a point closer than the closest one found so far
+  {
+    const int closestIndex = indexedClosestData(pos, QCPDataRange(int(begin-mDataContainer->constBegin()), int(end-mDataContainer->constBegin())), true, minDistSqr);
+    if (closestIndex >= 0)
+      minDistIndex = closestIndex;
+  } else
   {
-    const double mainKey = it->mainKey();
-    const double mainValue = it->mainValue();
-    if (keyRange.contains(mainKey) && valueRange.contains(mainValue)) // make sure data point is inside visible range, for speedup in cases where sort key isn't main key and we iterate over all points
+    QCPRange keyRange(mKeyAxis->range());
+    QCPRange valueRange(mValueAxis->range());
+    for (typename QCPDataContainer<DataType>::const_iterator it=begin; it!=end; ++it)
     {
-      const double currentDistSqr = QCPVector2D(coordsToPixels(mainKey, mainValue)-pos).lengthSquared();
-      if (currentDistSqr < minDistSqr)
+      const double mainKey = it->mainKey();
+      const double mainValue = it->mainValue();
+      if (keyRange.contains(mainKey) && valueRange.contains(mainValue)) // make sure data point is inside visible range, for speedup in cases where sort key isn't main key and we iterate over all points
       {
-        minDistSqr = currentDistSqr;
-        minDistIndex = int(it-mDataContainer->constBegin());
+        const double currentDistSqr = QCPVector2D(coordsToPixels(mainKey, mainValue)-pos).lengthSquared();
+        if (currentDistSqr < minDistSqr)
+        {
+          minDistSqr = currentDistSqr;
+          minDistIndex = int(it-mDataContainer->constBegin());
+        }
       }
     }
   }
@@ -4742,6 +5700,285 @@ void QCPAbstractPlottable1D<DataType>::drawPolyline(QCPPainter *painter, const Q
   }
 }
 
+/*! \internal
+  
+  Returns the spatial index over the data of this plottable, or \c nullptr if \ref
+  setSpatialIndexing is disabled. If the data was modified since the index was built, the index is
+  rebuilt before it is returned.
+*/
+template <class DataType>
+const QCPDataSpatialIndex<DataType> *QCPAbstractPlottable1D<DataType>::spatialIndex() const
+{
+  if (!mSpatialIndexing)
+    return nullptr;
+  if (!mSpatialIndex.isUpToDate(mDataContainer))
+    mSpatialIndex.rebuild(mDataContainer);
+  return &mSpatialIndex;
+}
+
+/*! \internal
+  
+  Returns the rect in pixel coordinates that encloses the plot coordinate \a bounds of a spatial
+  index node.
+*/
+template <class DataType>
+QRectF QCPAbstractPlottable1D<DataType>::nodePixelRect(const typename QCPDataSpatialIndex<DataType>::Bounds &bounds) const
+{
+  const QPointF p1 = coordsToPixels(bounds.keyMin, bounds.valueMin);
+  const QPointF p2 = coordsToPixels(bounds.keyMax, bounds.valueMax);
+  return QRectF(QPointF(qMin(p1.x(), p2.x()), qMin(p1.y(), p2.y())), QPointF(qMax(p1.x(), p2.x()), qMax(p1.y(), p2.y())));
+}
+
+/*! \internal
+  
+  Returns the index of the data point within \a dataRange whose pixel position is closest to \a
+  pixelPoint, using the spatial index. If \a onlyVisible is true, only data points inside the
+  current axis ranges are considered.
+  
+  Only data points that are closer than the passed \a minDistSqr are considered, and if one is
+  found, \a minDistSqr is set to its squared pixel distance. If no such point exists, returns -1
+  and leaves \a minDistSqr untouched.
+  
+  The nodes of the index are visited depth-first, nearer child first, and nodes whose pixel
+  bounding box is farther away than the closest point found so far are skipped. This must only be
+  called when \ref spatialIndex returns a valid index.
+*/
+template <class DataType>
+int QCPAbstractPlottable1D<DataType>::indexedClosestData(const QPointF &pixelPoint, const QCPDataRange &dataRange, bool onlyVisible, double &minDistSqr) const
+{
+  const QCPDataSpatialIndex<DataType> *index = spatialIndex();
+  if (!index || index->levelCount() == 0 || dataRange.isEmpty())
+    return -1;
+  const QCPRange keyRange(mKeyAxis->range());
+  const QCPRange valueRange(mValueAxis->range());
+  
+  int result = -1;
+  QVector<QPair<int, int> > stack; // pairs of level and node index
+  stack.reserve(index->levelCount()*2);
+  stack.append(qMakePair(index->levelCount()-1, 0));
+  while (!stack.isEmpty())
+  {
+    const int level = stack.last().first;
+    const int node = stack.last().second;
+    stack.removeLast();
+    const typename QCPDataSpatialIndex<DataType>::Bounds &bounds = index->node(level, node);
+    const QCPDataRange nodeRange = index->nodeDataRange(level, node).bounded(dataRange);
+    if (bounds.isEmpty() || nodeRange.isEmpty())
+      continue;
+    if (onlyVisible && (bounds.keyMax < keyRange.lower || bounds.keyMin > keyRange.upper || bounds.valueMax < valueRange.lower || bounds.valueMin > valueRange.upper))
+      continue;
+    if (pixelRectDistanceSqr(nodePixelRect(bounds), pixelPoint) >= minDistSqr)
+      continue;
+    
+    if (level == 0) // bucket, check its data points
+    {
+      typename QCPDataContainer<DataType>::const_iterator it = mDataContainer->constBegin()+nodeRange.begin();
+      for (int i=nodeRange.begin(); i<nodeRange.end(); ++i, ++it)
+      {
+        const double mainKey = it->mainKey();
+        const double mainValue = it->mainValue();
+        if (qIsNaN(mainKey) || qIsNaN(mainValue))
+          continue;
+        if (onlyVisible && !(keyRange.contains(mainKey) && valueRange.contains(mainValue)))
+          continue;
+        const double currentDistSqr = QCPVector2D(coordsToPixels(mainKey, mainValue)-pixelPoint).lengthSquared();
+        if (currentDistSqr < minDistSqr)
+        {
+          minDistSqr = currentDistSqr;
+          result = i;
+        }
+      }
+    } else // push children such that the nearer one is visited first
+    {
+      const int first = node*2;
+      const int second = node*2+1;
+      if (second < index->nodeCount(level-1))
+      {
+        const double firstDistSqr = pixelRectDistanceSqr(nodePixelRect(index->node(level-1, first)), pixelPoint);
+        const double secondDistSqr = pixelRectDistanceSqr(nodePixelRect(index->node(level-1, second)), pixelPoint);
+        if (firstDistSqr <= secondDistSqr)
+        {
+          stack.append(qMakePair(level-1, second));
+          stack.append(qMakePair(level-1, first));
+        } else
+        {
+          stack.append(qMakePair(level-1, first));
+          stack.append(qMakePair(level-1, second));
+        }
+      } else
+        stack.append(qMakePair(level-1, first));
+    }
+  }
+  return result;
+}
+
+/*! \internal
+  
+  Returns the data points within \a dataRange whose main key and main value lie inside \a keyRange
+  and \a valueRange, using the spatial index.
+  
+  Nodes whose bounding box lies outside the ranges are skipped, and nodes whose bounding box lies
+  entirely inside the ranges are added as a whole, so only the data points of buckets crossing the
+  border of the ranges are checked individually. The returned selection is not simplified. This
+  must only be called when \ref spatialIndex returns a valid index.
+*/
+template <class DataType>
+QCPDataSelection QCPAbstractPlottable1D<DataType>::indexedSelectTestRect(const QCPRange &keyRange, const QCPRange &valueRange, const QCPDataRange &dataRange) const
+{
+  QCPDataSelection result;
+  const QCPDataSpatialIndex<DataType> *index = spatialIndex();
+  if (!index || index->levelCount() == 0 || dataRange.isEmpty())
+    return result;
+  
+  QVector<QPair<int, int> > stack; // pairs of level and node index
+  stack.reserve(index->levelCount()*2);
+  stack.append(qMakePair(index->levelCount()-1, 0));
+  while (!stack.isEmpty())
+  {
+    const int level = stack.last().first;
+    const int node = stack.last().second;
+    stack.removeLast();
+    const typename QCPDataSpatialIndex<DataType>::Bounds &bounds = index->node(level, node);
+    const QCPDataRange fullNodeRange = index->nodeDataRange(level, node);
+    const QCPDataRange nodeRange = fullNodeRange.bounded(dataRange);
+    if (bounds.isEmpty() || nodeRange.isEmpty())
+      continue;
+    if (bounds.keyMax < keyRange.lower || bounds.keyMin > keyRange.upper || bounds.valueMax < valueRange.lower || bounds.valueMin > valueRange.upper)
+      continue;
+    if (!bounds.hasNaN && nodeRange == fullNodeRange &&
+        keyRange.contains(bounds.keyMin) && keyRange.contains(bounds.keyMax) &&
+        valueRange.contains(bounds.valueMin) && valueRange.contains(bounds.valueMax))
+    {
+      result.addDataRange(nodeRange, false);
+    } else if (level == 0) // bucket crosses the border of the ranges, check its data points
+    {
+      int currentSegmentBegin = -1; // -1 means we're currently not in a segment that's contained in the ranges
+      typename QCPDataContainer<DataType>::const_iterator it = mDataContainer->constBegin()+nodeRange.begin();
+      for (int i=nodeRange.begin(); i<nodeRange.end(); ++i, ++it)
+      {
+        const bool inside = valueRange.contains(it->mainValue()) && keyRange.contains(it->mainKey());
+        if (currentSegmentBegin == -1 && inside) // start segment
+          currentSegmentBegin = i;
+        else if (currentSegmentBegin != -1 && !inside) // segment just ended
+        {
+          result.addDataRange(QCPDataRange(currentSegmentBegin, i), false);
+          currentSegmentBegin = -1;
+        }
+      }
+      if (currentSegmentBegin != -1)
+        result.addDataRange(QCPDataRange(currentSegmentBegin, nodeRange.end()), false);
+    } else // push children in reverse order, so ranges are added in ascending order
+    {
+      if (node*2+1 < index->nodeCount(level-1))
+        stack.append(qMakePair(level-1, node*2+1));
+      stack.append(qMakePair(level-1, node*2));
+    }
+  }
+  return result;
+}
+
+/*! \internal
+  
+  Returns the smaller one of \a minDistSqr and the squared pixel distance of \a pixelPoint to the
+  closest line segment starting at a data point within \a segmentRange, using the spatial index.
+  The segment starting at data point \a i connects it with data point <tt>i+1</tt>, its distance is
+  calculated by \ref indexedSegmentDistanceSqr.
+  
+  Since the segments starting in an index node end at the first data point after the node, the
+  bounding box of each node is extended by that point. Nodes whose extended pixel bounding box is
+  farther away than the closest segment found so far are skipped. This must only be called when
+  \ref spatialIndex returns a valid index.
+*/
+template <class DataType>
+double QCPAbstractPlottable1D<DataType>::indexedLineDistanceSqr(const QPointF &pixelPoint, const QCPDataRange &segmentRange, double minDistSqr) const
+{
+  const QCPDataSpatialIndex<DataType> *index = spatialIndex();
+  if (!index || index->levelCount() == 0 || segmentRange.isEmpty())
+    return minDistSqr;
+  const QCPVector2D p(pixelPoint);
+  const int dataSize = mDataContainer->size();
+  
+  QVector<QPair<int, int> > stack; // pairs of level and node index
+  stack.reserve(index->levelCount()*2);
+  stack.append(qMakePair(index->levelCount()-1, 0));
+  while (!stack.isEmpty())
+  {
+    const int level = stack.last().first;
+    const int node = stack.last().second;
+    stack.removeLast();
+    const typename QCPDataSpatialIndex<DataType>::Bounds &bounds = index->node(level, node);
+    const QCPDataRange nodeRange = index->nodeDataRange(level, node).bounded(segmentRange);
+    if (bounds.isEmpty() || nodeRange.isEmpty())
+      continue;
+    QRectF rect = nodePixelRect(bounds);
+    if (nodeRange.end() < dataSize) // include end point of the last segment starting in this node
+    {
+      const typename QCPDataContainer<DataType>::const_iterator next = mDataContainer->constBegin()+nodeRange.end();
+      if (!qIsNaN(next->mainKey()) && !qIsNaN(next->mainValue()))
+      {
+        const QPointF nextPixel = coordsToPixels(next->mainKey(), next->mainValue());
+        rect.setLeft(qMin(rect.left(), nextPixel.x()));
+        rect.setRight(qMax(rect.right(), nextPixel.x()));
+        rect.setTop(qMin(rect.top(), nextPixel.y()));
+        rect.setBottom(qMax(rect.bottom(), nextPixel.y()));
+      }
+    }
+    if (pixelRectDistanceSqr(rect, pixelPoint) >= minDistSqr)
+      continue;
+    
+    if (level == 0) // bucket, check the segments starting at its data points
+    {
+      typename QCPDataContainer<DataType>::const_iterator it = mDataContainer->constBegin()+nodeRange.begin();
+      for (int i=nodeRange.begin(); i<nodeRange.end() && i<dataSize-1; ++i, ++it)
+      {
+        const double currentDistSqr = indexedSegmentDistanceSqr(p, it);
+        if (currentDistSqr < minDistSqr)
+          minDistSqr = currentDistSqr;
+      }
+    } else // visit children in order of data, neighboring segments are usually similarly close
+    {
+      if (node*2+1 < index->nodeCount(level-1))
+        stack.append(qMakePair(level-1, node*2+1));
+      stack.append(qMakePair(level-1, node*2));
+    }
+  }
+  return minDistSqr;
+}
+
+/*! \internal
+  
+  Returns the squared pixel distance of \a pixelPoint to the line segment which connects the data
+  point \a segmentStart with the following data point. Returns the maximum double value if one of
+  the two data points has a NaN main key or main value, since NaNs create gaps in lines.
+  
+  This is used by \ref indexedLineDistanceSqr. The default implementation assumes a straight line
+  between the main key/value positions of the two data points. Subclasses whose lines take a
+  different path between data points (e.g. the step line styles of \ref QCPGraph) reimplement this
+  method accordingly. The path must stay within the bounding box of the two data points. \a
+  segmentStart is guaranteed to not be the last data point.
+*/
+template <class DataType>
+double QCPAbstractPlottable1D<DataType>::indexedSegmentDistanceSqr(const QCPVector2D &pixelPoint, typename QCPDataContainer<DataType>::const_iterator segmentStart) const
+{
+  const typename QCPDataContainer<DataType>::const_iterator segmentEnd = segmentStart+1;
+  if (qIsNaN(segmentStart->mainKey()) || qIsNaN(segmentStart->mainValue()) || qIsNaN(segmentEnd->mainKey()) || qIsNaN(segmentEnd->mainValue()))
+    return (std::numeric_limits<double>::max)();
+  return pixelPoint.distanceSquaredToLine(coordsToPixels(segmentStart->mainKey(), segmentStart->mainValue()), coordsToPixels(segmentEnd->mainKey(), segmentEnd->mainValue()));
+}
+
+/*! \internal
+  
+  Returns the squared distance of \a point to the closest point of \a rect, or zero if \a point
+  lies inside \a rect.
+*/
+template <class DataType>
+double QCPAbstractPlottable1D<DataType>::pixelRectDistanceSqr(const QRectF &rect, const QPointF &point)
+{
+  const double dx = qMax(0.0, qMax(rect.left()-point.x(), point.x()-rect.right()));
+  const double dy = qMax(0.0, qMax(rect.top()-point.y(), point.y()-rect.bottom()));
+  return dx*dx + dy*dy;
+}
+
 
 /* end of 'src/plottable1d.h' */
 
@@ -5491,6 +6728,14 @@ Q_DECLARE_TYPEINFO(QCPGraphData, Q_PRIMITIVE_TYPE);
 */
 typedef QCPDataContainer<QCPGraphData> QCPGraphDataContainer;
 
+/*! \typedef QCPGraphDataArchive
+  
+  Compressed storage for \ref QCPGraphData points that were moved out of a \ref
+  QCPGraphDataContainer, e.g. the old part of a long history. For details, see the documentation of
+  the class template \ref QCPDataArchive.
+*/
+typedef QCPDataArchive<QCPGraphData> QCPGraphDataArchive;
+
 class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable1D<QCPGraphData>
 {
   Q_OBJECT
@@ -5554,9 +6799,17 @@ protected:
   QPointer<QCPGraph> mChannelFillGraph;
   bool mAdaptiveSampling;
   
+  // non-property members:
+  QVector<int> mSamplingBorders;
+  QVector<int> *mSamplingIndices;
+  QVector<QPointF> mChannelFillLines;
+  QVector<QCPDataRange> mChannelFillSegments;
+  mutable QPolygonF mChannelFillPolygon;
+  
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const Q_DECL_OVERRIDE;
+  virtual double indexedSegmentDistanceSqr(const QCPVector2D &pixelPoint, QCPGraphDataContainer::const_iterator segmentStart) const Q_DECL_OVERRIDE;
   
   // introduced virtual methods:
   virtual void drawFill(QCPPainter *painter, QVector<QPointF> *lines) const;
@@ -5570,7 +6823,15 @@ protected:
   // non-virtual methods:
   void getVisibleDataBounds(QCPGraphDataContainer::const_iterator &begin, QCPGraphDataContainer::const_iterator &end, const QCPDataRange &rangeRestriction) const;
   void getLines(QVector<QPointF> *lines, const QCPDataRange &dataRange) const;
+  void getLines(QVector<QPointF> *lines, const QVector<QCPGraphData> &lineData, const QVector<int> &dataIndices, const QCPDataRange &dataRange) const;
   void getScatters(QVector<QPointF> *scatters, const QCPDataRange &dataRange) const;
+  void getScatters(QVector<QPointF> *scatters, const QVector<QCPGraphData> &scatterData, const QVector<int> &dataIndices, const QCPDataRange &dataRange) const;
+  void dataToStyledLines(QVector<QPointF> *lines, QVector<QCPGraphData> &lineData) const;
+  void dataToScatters(QVector<QPointF> *scatters, QVector<QCPGraphData> &data) const;
+  void sampleLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end, const QVector<int> &segmentBorders, QVector<int> *dataIndices) const;
+  void sampleScatterData(QVector<QCPGraphData> *scatterData, QCPGraphDataContainer::const_iterator begin, QCPGraphDataContainer::const_iterator end, const QVector<int> &segmentBorders, QVector<int> *dataIndices) const;
+  static bool passSegmentBorder(const QVector<int> &segmentBorders, int &borderIndex, int dataIndex);
+  static void appendBorderCluster(QVector<QCPGraphData> *lineData, const QCPGraphData &first, const QCPGraphData &last, double minValue, double maxValue);
   QVector<QPointF> dataToLines(const QVector<QCPGraphData> &data) const;
   QVector<QPointF> dataToStepLeftLines(const QVector<QCPGraphData> &data) const;
   QVector<QPointF> dataToStepRightLines(const QVector<QCPGraphData> &data) const;
@@ -5582,6 +6843,10 @@ protected:
   QPointF getFillBasePoint(QPointF matchingDataPoint) const;
   const QPolygonF getFillPolygon(const QVector<QPointF> *lineData, QCPDataRange segment) const;
   const QPolygonF getChannelFillPolygon(const QVector<QPointF> *thisData, QCPDataRange thisSegment, const QVector<QPointF> *otherData, QCPDataRange otherSegment) const;
+  bool getChannelFillPolygon(QPolygonF *polygon, const QVector<QPointF> *thisData, QCPDataRange thisSegment, const QVector<QPointF> *otherData, QCPDataRange otherSegment) const;
+  void updateChannelFillLines();
+  static int findKeyIndex(const QVector<QPointF> *data, QCPDataRange segment, double key, bool verticalKey, bool includeEqual);
+  static QPointF interpolateAtKey(const QPointF &a, const QPointF &b, double key, bool verticalKey);
   int findIndexBelowX(const QVector<QPointF> *data, double x) const;
   int findIndexAboveX(const QVector<QPointF> *data, double x) const;
   int findIndexBelowY(const QVector<QPointF> *data, double y) const;
@@ -5638,6 +6903,7 @@ class QCP_LIB_DECL QCPCurve : public QCPAbstractPlottable1D<QCPCurveData>
   Q_PROPERTY(QCPScatterStyle scatterStyle READ scatterStyle WRITE setScatterStyle)
   Q_PROPERTY(int scatterSkip READ scatterSkip WRITE setScatterSkip)
   Q_PROPERTY(LineStyle lineStyle READ lineStyle WRITE setLineStyle)
+  Q_PROPERTY(bool adaptiveSampling READ adaptiveSampling WRITE setAdaptiveSampling)
   /// \endcond
 public:
   /*!
@@ -5658,6 +6924,7 @@ public:
   QCPScatterStyle scatterStyle() const { return mScatterStyle; }
   int scatterSkip() const { return mScatterSkip; }
   LineStyle lineStyle() const { return mLineStyle; }
+  bool adaptiveSampling() const { return mAdaptiveSampling; }
   
   // setters:
   void setData(QSharedPointer<QCPCurveDataContainer> data);
@@ -5666,6 +6933,7 @@ public:
   void setScatterStyle(const QCPScatterStyle &style);
   void setScatterSkip(int skip);
   void setLineStyle(LineStyle style);
+  void setAdaptiveSampling(bool enabled);
   
   // non-property methods:
   void addData(const QVector<double> &t, const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
@@ -5683,6 +6951,7 @@ protected:
   QCPScatterStyle mScatterStyle;
   int mScatterSkip;
   LineStyle mLineStyle;
+  bool mAdaptiveSampling;
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
@@ -5695,6 +6964,7 @@ protected:
   // non-virtual methods:
   void getCurveLines(QVector<QPointF> *lines, const QCPDataRange &dataRange, double penWidth) const;
   void getScatters(QVector<QPointF> *scatters, const QCPDataRange &dataRange, double scatterWidth) const;
+  void decimateCurveLines(QVector<QPointF> *lines, double tolerance) const;
   int getRegion(double key, double value, double keyMin, double valueMax, double keyMax, double valueMin) const;
   QPointF getOptimizedPoint(int otherRegion, double otherKey, double otherValue, double key, double value, double keyMin, double valueMax, double keyMax, double valueMin) const;
   QVector<QPointF> getOptimizedCornerPoints(int prevRegion, int currentRegion, double prevKey, double prevValue, double key, double value, double keyMin, double valueMax, double keyMax, double valueMin) const;
@@ -5819,6 +7089,7 @@ class QCP_LIB_DECL QCPBars : public QCPAbstractPlottable1D<QCPBarsData>
   Q_PROPERTY(QCPBarsGroup* barsGroup READ barsGroup WRITE setBarsGroup)
   Q_PROPERTY(double baseValue READ baseValue WRITE setBaseValue)
   Q_PROPERTY(double stackingGap READ stackingGap WRITE setStackingGap)
+  Q_PROPERTY(bool adaptiveSampling READ adaptiveSampling WRITE setAdaptiveSampling)
   Q_PROPERTY(QCPBars* barBelow READ barBelow)
   Q_PROPERTY(QCPBars* barAbove READ barAbove)
   /// \endcond
@@ -5844,6 +7115,7 @@ public:
   QCPBarsGroup *barsGroup() const { return mBarsGroup; }
   double baseValue() const { return mBaseValue; }
   double stackingGap() const { return mStackingGap; }
+  bool adaptiveSampling() const { return mAdaptiveSampling; }
   QCPBars *barBelow() const { return mBarBelow.data(); }
   QCPBars *barAbove() const { return mBarAbove.data(); }
   QSharedPointer<QCPBarsDataContainer> data() const { return mDataContainer; }
@@ -5856,6 +7128,7 @@ public:
   void setBarsGroup(QCPBarsGroup *barsGroup);
   void setBaseValue(double baseValue);
   void setStackingGap(double pixels);
+  void setAdaptiveSampling(bool enabled);
   
   // non-property methods:
   void addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
@@ -5877,8 +7150,25 @@ protected:
   QCPBarsGroup *mBarsGroup;
   double mBaseValue;
   double mStackingGap;
+  bool mAdaptiveSampling;
   QPointer<QCPBars> mBarBelow, mBarAbove;
   
+  // non-property members:
+  struct StackTop
+  {
+    double key;
+    double positive, negative;
+  };
+  mutable QVector<StackTop> mStackTops;
+  mutable double mStackBottomValue;
+  mutable quint64 mStackVersion;
+  mutable QWeakPointer<QCPBarsDataContainer> mStackData;
+  mutable quint64 mStackDataRevision;
+  mutable int mStackDataSize;
+  mutable const QCPBars *mStackBelow;
+  mutable quint64 mStackBelowVersion;
+  mutable double mStackBaseValue;
+  
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const Q_DECL_OVERRIDE;
@@ -5888,6 +7178,9 @@ protected:
   QRectF getBarRect(double key, double value) const;
   void getPixelWidth(double key, double &lower, double &upper) const;
   double getStackedBaseValue(double key, bool positive) const;
+  void updateStackCache() const;
+  double stackTopValue(double key, bool positive) const;
+  static double stackKeyEpsilon(double key);
   static void connectBars(QCPBars* lower, QCPBars* upper);
   
   friend class QCustomPlot;
@@ -5980,6 +7273,7 @@ public:
   // non-property methods:
   void addData(const QVector<double> &keys, const QVector<double> &minimum, const QVector<double> &lowerQuartile, const QVector<double> &median, const QVector<double> &upperQuartile, const QVector<double> &maximum, bool alreadySorted=false);
   void addData(double key, double minimum, double lowerQuartile, double median, double upperQuartile, double maximum, const QVector<double> &outliers=QVector<double>());
+  void addSamples(const QVector<double> &keys, const QVector<QVector<double> > &samples, double whiskerFactor=1.5, int maxOutliers=1000);
   
   // reimplemented virtual methods:
   virtual QCPDataSelection selectTestRect(const QRectF &rect, bool onlySelectable) const Q_DECL_OVERRIDE;
@@ -5987,6 +7281,9 @@ public:
   virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const Q_DECL_OVERRIDE;
   virtual QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange()) const Q_DECL_OVERRIDE;
   
+  // static methods:
+  static QCPStatisticalBoxData samplesToBox(double key, const QVector<double> &samples, double whiskerFactor=1.5, int maxOutliers=1000);
+  
 protected:
   // property members:
   double mWidth;
@@ -6009,6 +7306,10 @@ protected:
   QVector<QLineF> getWhiskerBackboneLines(QCPStatisticalBoxDataContainer::const_iterator it) const;
   QVector<QLineF> getWhiskerBarLines(QCPStatisticalBoxDataContainer::const_iterator it) const;
   
+  // static methods:
+  static double selectQuantile(std::vector<double> &values, double p);
+  static void samplesToBoxes(const QVector<double> *keys, const QVector<QVector<double> > *samples, int first, int stride, double whiskerFactor, int maxOutliers, QVector<QCPStatisticalBoxData> *boxes);
+  
   friend class QCustomPlot;
   friend class QCPLegend;
 };
@@ -6198,6 +7499,8 @@ class QCP_LIB_DECL QCPFinancial : public QCPAbstractPlottable1D<QCPFinancialData
   Q_PROPERTY(QBrush brushNegative READ brushNegative WRITE setBrushNegative)
   Q_PROPERTY(QPen penPositive READ penPositive WRITE setPenPositive)
   Q_PROPERTY(QPen penNegative READ penNegative WRITE setPenNegative)
+  Q_PROPERTY(bool adaptiveBinning READ adaptiveBinning WRITE setAdaptiveBinning)
+  Q_PROPERTY(double minimumCandleWidth READ minimumCandleWidth WRITE setMinimumCandleWidth)
   /// \endcond
 public:
   /*!
@@ -6235,6 +7538,9 @@ public:
   QBrush brushNegative() const { return mBrushNegative; }
   QPen penPositive() const { return mPenPositive; }
   QPen penNegative() const { return mPenNegative; }
+  bool adaptiveBinning() const { return mAdaptiveBinning; }
+  double minimumCandleWidth() const { return mMinimumCandleWidth; }
+  QVector<double> binSizes() const { return mBinSizes; }
   
   // setters:
   void setData(QSharedPointer<QCPFinancialDataContainer> data);
@@ -6247,6 +7553,9 @@ public:
   void setBrushNegative(const QBrush &brush);
   void setPenPositive(const QPen &pen);
   void setPenNegative(const QPen &pen);
+  void setAdaptiveBinning(bool enabled);
+  void setMinimumCandleWidth(double pixels);
+  void setBinSizes(const QVector<double> &binSizes);
   
   // non-property methods:
   void addData(const QVector<double> &keys, const QVector<double> &open, const QVector<double> &high, const QVector<double> &low, const QVector<double> &close, bool alreadySorted=false);
@@ -6269,12 +7578,32 @@ protected:
   bool mTwoColored;
   QBrush mBrushPositive, mBrushNegative;
   QPen mPenPositive, mPenNegative;
+  bool mAdaptiveBinning;
+  double mMinimumCandleWidth;
+  QVector<double> mBinSizes;
+  
+  // non-property members:
+  struct BinLevel
+  {
+    double binSize;
+    QCPFinancialDataContainer data;
+    QVector<int> firstIndex; // index of the first data point merged into each candle
+  };
+  QVector<BinLevel> mBinLevels;
+  double mBaseBinSize;
+  QWeakPointer<QCPFinancialDataContainer> mBinLevelsData;
+  quint64 mBinLevelsRevision;
+  int mBinLevelsSize;
+  double mWidthScale;
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const Q_DECL_OVERRIDE;
   
   // non-virtual methods:
+  void updateBinLevels();
+  int binLevelForRange();
+  void drawBinLevel(QCPPainter *painter, const BinLevel &level);
   void drawOhlcPlot(QCPPainter *painter, const QCPFinancialDataContainer::const_iterator &begin, const QCPFinancialDataContainer::const_iterator &end, bool isSelected);
   void drawCandlestickPlot(QCPPainter *painter, const QCPFinancialDataContainer::const_iterator &begin, const QCPFinancialDataContainer::const_iterator &end, bool isSelected);
   double getPixelWidth(double key, double keyPixel) const;
@@ -6288,6 +7617,43 @@ protected:
 };
 Q_DECLARE_METATYPE(QCPFinancial::ChartStyle)
 
+
+class QCP_LIB_DECL QCPFinancialAggregator
+{
+public:
+  explicit QCPFinancialAggregator(double timeBinSize, double timeBinOffset=0);
+  
+  // getters:
+  double timeBinSize() const { return mTimeBinSize; }
+  double timeBinOffset() const { return mTimeBinOffset; }
+  int threadCount() const { return mThreadCount; }
+  QSharedPointer<QCPFinancialDataContainer> data() const { return mDataContainer; }
+  
+  // setters:
+  void setData(QSharedPointer<QCPFinancialDataContainer> data);
+  void setThreadCount(int count);
+  
+  // non-property methods:
+  void addTick(double time, double value);
+  void addTicks(const QVector<double> &time, const QVector<double> &value);
+  void clear();
+  QCPFinancialDataContainer rebinned(double timeBinSize, double timeBinOffset=0) const;
+  
+  // static methods:
+  static QCPFinancialDataContainer rebin(const QCPFinancialDataContainer &candles, double timeBinSize, double timeBinOffset=0);
+  
+protected:
+  // property members:
+  double mTimeBinSize, mTimeBinOffset;
+  int mThreadCount;
+  QSharedPointer<QCPFinancialDataContainer> mDataContainer;
+  
+  // static methods:
+  static double binKey(double time, double timeBinSize, double timeBinOffset);
+  static void mergeCandle(QCPFinancialData &candle, const QCPFinancialData &later);
+  static void aggregateTicks(const double *time, const double *value, int count, double timeBinSize, double timeBinOffset, QVector<QCPFinancialData> *candles, bool *sorted);
+};
+
 /* end of 'src/plottables/plottable-financial.h' */
 
 
@@ -6394,6 +7760,9 @@ protected:
   double mWhiskerWidth;
   double mSymbolGap;
   
+  // non-property members:
+  QVector<QLineF> mBackbones, mWhiskers;
+  
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const Q_DECL_OVERRIDE;
@@ -6402,6 +7771,7 @@ protected:
   
   // non-virtual methods:
   void getErrorBarLines(QCPErrorBarsDataContainer::const_iterator it, QVector<QLineF> &backbones, QVector<QLineF> &whiskers) const;
+  void getErrorBarLines(const QCPErrorBarsDataContainer::const_iterator &begin, const QCPErrorBarsDataContainer::const_iterator &end, bool checkPointVisibility, QVector<QLineF> &backbones, QVector<QLineF> &whiskers) const;
   void getVisibleDataBounds(QCPErrorBarsDataContainer::const_iterator &begin, QCPErrorBarsDataContainer::const_iterator &end, const QCPDataRange &rangeRestriction) const;
   double pointDistance(const QPointF &pixelPoint, QCPErrorBarsDataContainer::const_iterator &closestData) const;
   // helpers:
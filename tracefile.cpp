@@ -0,0 +1,244 @@
+#include "tracefile.h"
+#include <QDateTime>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char magic[8] = {'Q', 'C', 'P', 'T', 'R', 'A', 'C', 'E'};
+const quint32 formatVersion = 1;
+const quint32 sortedFlag = 0x1;
+const qint64 headerSize = 72;
+const qint64 writeBufferSize = 4*1024*1024;
+
+template <typename T>
+void putLittleEndian(uchar *header, int offset, T value)
+{
+    qToLittleEndian<T>(value, header + offset);
+}
+
+template <typename T>
+T getLittleEndian(const uchar *header, int offset)
+{
+    return qFromLittleEndian<T>(header + offset);
+}
+
+// Writes doubles in little-endian byte order. On little-endian machines this is a single write of
+// the whole array, otherwise the values are converted through a buffer.
+bool writeDoubles(QSaveFile &file, const double *data, qint64 count)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const qint64 size = count*qint64(sizeof(double));
+    return file.write(reinterpret_cast<const char*>(data), size) == size;
+#else
+    QVector<double> buffer(int(qMin(count, writeBufferSize/qint64(sizeof(double)))));
+    for (qint64 i = 0; i < count; i += buffer.size()){
+        const qint64 n = qMin(qint64(buffer.size()), count - i);
+        qToLittleEndian<double>(data + i, n, buffer.data());
+        if (file.write(reinterpret_cast<const char*>(buffer.constData()), n*qint64(sizeof(double))) != n*qint64(sizeof(double)))
+            return false;
+    }
+    return true;
+#endif
+}
+
+} // namespace
+
+TraceFile::TraceFile(const QString &filePath)
+    : file(filePath)
+    , mappedKeys(nullptr)
+    , mappedValues(nullptr)
+    , count(0)
+    , sorted(false)
+    , pointsPerChunk(0)
+    , chunks(0)
+    , creationTime(0)
+    , keyColumnOffset(0)
+    , valueColumnOffset(0)
+    , keyData(nullptr)
+    , valueData(nullptr)
+{
+}
+
+TraceFile::~TraceFile()
+{
+    close();
+}
+
+// Writes keys and values to filePath. The file is replaced only once it was written completely.
+bool TraceFile::write(const QString &filePath, const QVector<double> &keys, const QVector<double> &values,
+                      QString *errorString, qint64 chunkSize)
+{
+    if (keys.size() != values.size()){
+        if (errorString)
+            *errorString = "Key and value count differ";
+        return false;
+    }
+    chunkSize = qMax(qint64(1), chunkSize);
+    const qint64 n = keys.size();
+    const qint64 chunkCount = (n + chunkSize - 1)/chunkSize;
+    const double *keyData = keys.constData();
+    const double *valueData = values.constData();
+
+    // chunk index, NaNs are ignored (a chunk of only NaNs gets NaN ranges):
+    QVector<double> index(int(chunkCount*4));
+    bool sorted = true;
+    for (qint64 chunk = 0; chunk < chunkCount; ++chunk){
+        double keyMin = qQNaN(), keyMax = qQNaN(), valueMin = qQNaN(), valueMax = qQNaN();
+        const qint64 end = qMin(n, (chunk + 1)*chunkSize);
+        for (qint64 i = chunk*chunkSize; i < end; ++i){
+            const double key = keyData[i];
+            const double value = valueData[i];
+            if (i > 0 && key < keyData[i - 1])
+                sorted = false;
+            if (!qIsNaN(key)){
+                keyMin = qIsNaN(keyMin) ? key : qMin(keyMin, key);
+                keyMax = qIsNaN(keyMax) ? key : qMax(keyMax, key);
+            }
+            if (!qIsNaN(value)){
+                valueMin = qIsNaN(valueMin) ? value : qMin(valueMin, value);
+                valueMax = qIsNaN(valueMax) ? value : qMax(valueMax, value);
+            }
+        }
+        index[int(chunk*4 + 0)] = keyMin;
+        index[int(chunk*4 + 1)] = keyMax;
+        index[int(chunk*4 + 2)] = valueMin;
+        index[int(chunk*4 + 3)] = valueMax;
+    }
+
+    uchar header[headerSize];
+    std::memset(header, 0, sizeof(header));
+    std::memcpy(header, magic, sizeof(magic));
+    putLittleEndian<quint32>(header, 8, formatVersion);
+    putLittleEndian<quint32>(header, 12, sorted ? sortedFlag : 0);
+    putLittleEndian<qint64>(header, 16, n);
+    putLittleEndian<qint64>(header, 24, chunkSize);
+    putLittleEndian<qint64>(header, 32, chunkCount);
+    putLittleEndian<qint64>(header, 40, headerSize);
+    putLittleEndian<qint64>(header, 48, headerSize + n*8);
+    putLittleEndian<qint64>(header, 56, headerSize + n*16);
+    putLittleEndian<qint64>(header, 64, QDateTime::currentMSecsSinceEpoch());
+
+    QSaveFile file(filePath);
+    if (!file.open(QFile::WriteOnly)
+            || file.write(reinterpret_cast<const char*>(header), headerSize) != headerSize
+            || !writeDoubles(file, keyData, n)
+            || !writeDoubles(file, valueData, n)
+            || !writeDoubles(file, index.constData(), index.size())
+            || !file.commit()){
+        if (errorString)
+            *errorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+// Reads the header and the chunk index of the file. If mapColumns is true, the key and value
+// columns are mapped into memory and available through keys() and values(). Otherwise, only the
+// header and index are resident, and the columns can be mapped piecewise via keysOffset() and
+// valuesOffset(), see TraceGraphSource. Returns false if the file can't be read or isn't a valid
+// trace file, see errorString().
+bool TraceFile::open(bool mapColumns)
+{
+    close();
+    error.clear();
+    if (!file.open(QFile::ReadOnly))
+        return fail(file.errorString());
+    const qint64 fileSize = file.size();
+    uchar header[headerSize];
+    if (file.read(reinterpret_cast<char*>(header), headerSize) != headerSize)
+        return fail("File is too small for a trace file");
+
+    if (std::memcmp(header, magic, sizeof(magic)) != 0)
+        return fail("File is not a trace file");
+    if (getLittleEndian<quint32>(header, 8) != formatVersion)
+        return fail("Unsupported trace file version");
+    sorted = getLittleEndian<quint32>(header, 12) & sortedFlag;
+    count = getLittleEndian<qint64>(header, 16);
+    pointsPerChunk = getLittleEndian<qint64>(header, 24);
+    chunks = getLittleEndian<qint64>(header, 32);
+    keyColumnOffset = getLittleEndian<qint64>(header, 40);
+    valueColumnOffset = getLittleEndian<qint64>(header, 48);
+    const qint64 indexOffset = getLittleEndian<qint64>(header, 56);
+    creationTime = getLittleEndian<qint64>(header, 64);
+
+    const qint64 maxCount = fileSize/8;
+    const bool validCounts = count >= 0 && count <= maxCount && chunks >= 0 && chunks <= maxCount/4 &&
+            pointsPerChunk > 0 && chunks == (count > 0 ? (count - 1)/pointsPerChunk + 1 : 0);
+    const bool validOffsets = validCounts &&
+            keyColumnOffset >= headerSize && keyColumnOffset % 8 == 0 && keyColumnOffset <= fileSize - count*8 &&
+            valueColumnOffset >= headerSize && valueColumnOffset % 8 == 0 && valueColumnOffset <= fileSize - count*8 &&
+            indexOffset >= headerSize && indexOffset % 8 == 0 && indexOffset <= fileSize - chunks*32;
+    if (!validOffsets)
+        return fail("Trace file is damaged");
+
+    // the index is small (32 bytes per chunk), so it is always kept in memory:
+    const QByteArray rawIndex = file.seek(indexOffset) ? file.read(chunks*32) : QByteArray();
+    if (rawIndex.size() != chunks*32)
+        return fail(file.errorString());
+    index.resize(qsizetype(chunks*4));
+    qFromLittleEndian<double>(rawIndex.constData(), chunks*4, index.data());
+
+    if (mapColumns && count > 0){
+        mappedKeys = file.map(keyColumnOffset, count*8);
+        mappedValues = file.map(valueColumnOffset, count*8);
+        if (!mappedKeys || !mappedValues)
+            return fail(file.errorString());
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        keyData = reinterpret_cast<const double*>(mappedKeys);
+        valueData = reinterpret_cast<const double*>(mappedValues);
+#else
+        converted.resize(qsizetype(count*2));
+        qFromLittleEndian<double>(mappedKeys, count, converted.data());
+        qFromLittleEndian<double>(mappedValues, count, converted.data() + count);
+        keyData = converted.constData();
+        valueData = converted.constData() + count;
+#endif
+    }
+    return true;
+}
+
+void TraceFile::close()
+{
+    if (mappedKeys){
+        file.unmap(mappedKeys);
+        mappedKeys = nullptr;
+    }
+    if (mappedValues){
+        file.unmap(mappedValues);
+        mappedValues = nullptr;
+    }
+    file.close();
+    converted.clear();
+    index.clear();
+    count = 0;
+    sorted = false;
+    pointsPerChunk = 0;
+    chunks = 0;
+    creationTime = 0;
+    keyColumnOffset = 0;
+    valueColumnOffset = 0;
+    keyData = nullptr;
+    valueData = nullptr;
+}
+
+// Returns the key and value range of the points of chunk, without touching the columns.
+TraceFile::ChunkSummary TraceFile::chunkSummary(qint64 chunk) const
+{
+    ChunkSummary summary;
+    const double *entry = index.constData() + chunk*4;
+    summary.keyMin = entry[0];
+    summary.keyMax = entry[1];
+    summary.valueMin = entry[2];
+    summary.valueMax = entry[3];
+    return summary;
+}
+
+bool TraceFile::fail(const QString &message)
+{
+    close();
+    error = message;
+    return false;
+}
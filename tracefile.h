@@ -0,0 +1,80 @@
+#ifndef TRACEFILE_H
+#define TRACEFILE_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// Binary trace files hold the keys and values of a graph as two little-endian double columns,
+// followed by an index with the key and value range of every chunk of chunkSize() points:
+//
+//   offset  size  field
+//        0     8  magic "QCPTRACE"
+//        8     4  format version (1)
+//       12     4  flags (bit 0: keys are sorted ascending)
+//       16     8  point count n
+//       24     8  points per chunk
+//       32     8  chunk count
+//       40     8  offset of the key column (n doubles)
+//       48     8  offset of the value column (n doubles)
+//       56     8  offset of the chunk index (4 doubles per chunk: key min/max, value min/max)
+//       64     8  creation time in milliseconds since the epoch
+//
+// Reading maps the columns into memory, so on little-endian machines keys() and values() point
+// directly into the file without any parsing or copying.
+class TraceFile
+{
+public:
+    struct ChunkSummary
+    {
+        double keyMin;
+        double keyMax;
+        double valueMin;
+        double valueMax;
+    };
+
+    static const qint64 defaultChunkSize = 65536;
+
+    explicit TraceFile(const QString &filePath);
+    ~TraceFile();
+
+    static bool write(const QString &filePath, const QVector<double> &keys, const QVector<double> &values,
+                      QString *errorString = nullptr, qint64 chunkSize = defaultChunkSize);
+
+    bool open(bool mapColumns = true);
+    void close();
+
+    QString errorString() const { return error; }
+    qint64 pointCount() const { return count; }
+    bool isSorted() const { return sorted; }
+    qint64 chunkSize() const { return pointsPerChunk; }
+    qint64 chunkCount() const { return chunks; }
+    qint64 created() const { return creationTime; }
+    QString filePath() const { return file.fileName(); }
+    qint64 keysOffset() const { return keyColumnOffset; }
+    qint64 valuesOffset() const { return valueColumnOffset; }
+    const double *keys() const { return keyData; }
+    const double *values() const { return valueData; }
+    ChunkSummary chunkSummary(qint64 chunk) const;
+
+private:
+    QFile file;
+    uchar *mappedKeys;
+    uchar *mappedValues;
+    QString error;
+    qint64 count;
+    bool sorted;
+    qint64 pointsPerChunk;
+    qint64 chunks;
+    qint64 creationTime;
+    qint64 keyColumnOffset;
+    qint64 valueColumnOffset;
+    const double *keyData;
+    const double *valueData;
+    QVector<double> index;
+    QVector<double> converted; // columns in host byte order on big-endian machines
+
+    bool fail(const QString &message);
+};
+
+#endif // TRACEFILE_H
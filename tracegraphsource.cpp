@@ -0,0 +1,253 @@
+#include "tracegraphsource.h"
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const qint64 defaultMemoryLimit = 256*1024*1024;
+const int subSummarySize = 1024;
+
+} // namespace
+
+TraceGraphSource::TraceGraphSource(QCPGraph *graph, const QString &filePath, QObject *parent)
+    : QObject(parent)
+    , graph(graph)
+    , trace(filePath)
+    , file(filePath)
+    , useCounter(0)
+    , limit(defaultMemoryLimit)
+    , mappedBytes(0)
+{
+    connect(graph, &QObject::destroyed, this, &QObject::deleteLater);
+    connect(graph->keyAxis(), qOverload<const QCPRange &>(&QCPAxis::rangeChanged), this, &TraceGraphSource::update);
+}
+
+TraceGraphSource::~TraceGraphSource()
+{
+    for (Chunk &chunk : chunks)
+        unmapChunk(chunk);
+}
+
+// Reads the header and chunk index of the trace. The trace must be sorted by key.
+bool TraceGraphSource::open()
+{
+    error.clear();
+    if (!trace.open(false)){
+        error = trace.errorString();
+        return false;
+    }
+    if (!trace.isSorted()){
+        error = "The trace is not sorted by key";
+        return false;
+    }
+    if (!file.open(QFile::ReadOnly)){
+        error = file.errorString();
+        return false;
+    }
+    summaries.resize(qsizetype(trace.chunkCount()));
+    for (qint64 i = 0; i < trace.chunkCount(); ++i){
+        const TraceFile::ChunkSummary summary = trace.chunkSummary(i);
+        summaries[qsizetype(i)] = {summary.keyMin, summary.keyMax, summary.valueMin, summary.valueMax};
+    }
+    return true;
+}
+
+// Limits the memory of the chunks mapped at the same time. The chunks needed for a single update
+// are always mapped, even if they exceed the limit.
+void TraceGraphSource::setMemoryLimit(qint64 bytes)
+{
+    limit = qMax(qint64(0), bytes);
+    evict(0);
+}
+
+QCPRange TraceGraphSource::keyRange() const
+{
+    QCPRange range;
+    bool found = false;
+    for (const Summary &summary : summaries){
+        if (std::isnan(summary.keyMin))
+            continue;
+        if (!found){
+            range = QCPRange(summary.keyMin, summary.keyMax);
+            found = true;
+        }
+        else{
+            range.expand(QCPRange(summary.keyMin, summary.keyMax));
+        }
+    }
+    return range;
+}
+
+QCPRange TraceGraphSource::valueRange() const
+{
+    QCPRange range;
+    bool found = false;
+    for (const Summary &summary : summaries){
+        if (std::isnan(summary.valueMin))
+            continue;
+        if (!found){
+            range = QCPRange(summary.valueMin, summary.valueMax);
+            found = true;
+        }
+        else{
+            range.expand(QCPRange(summary.valueMin, summary.valueMax));
+        }
+    }
+    return range;
+}
+
+// Replaces the graph data with the level of detail needed for the current key axis range.
+void TraceGraphSource::update()
+{
+    if (!graph || summaries.isEmpty())
+        return;
+    QCPAxis *keyAxis = graph->keyAxis();
+    const QCPRange range = keyAxis->range();
+    const int pixels = qMax(1, keyAxis->orientation() == Qt::Horizontal ? keyAxis->axisRect()->width() : keyAxis->axisRect()->height());
+    const double bucketWidth = range.size()/pixels;
+
+    // chunks overlapping the range, plus one on each side so lines continue beyond the viewport:
+    const auto firstVisible = std::lower_bound(summaries.constBegin(), summaries.constEnd(), range.lower,
+                                               [](const Summary &summary, double key){ return summary.keyMax < key; });
+    const auto endVisible = std::upper_bound(summaries.constBegin(), summaries.constEnd(), range.upper,
+                                             [](double key, const Summary &summary){ return key < summary.keyMin; });
+    const qint64 first = qMax(qint64(0), qint64(firstVisible - summaries.constBegin()) - 1);
+    const qint64 end = qMin(qint64(summaries.size()), qint64(endVisible - summaries.constBegin()) + 1);
+
+    QVector<QCPGraphData> data;
+    const qint64 pointsPerPixel = qMax(qint64(0), end - first)*trace.chunkSize()/pixels;
+    qint64 lastBucket = std::numeric_limits<qint64>::min();
+    if (pointsPerPixel >= trace.chunkSize()){
+        data.reserve(qsizetype(qMin(end - first, qint64(pixels + 2))*2));
+        for (qint64 i = first; i < end; ++i)
+            appendSummary(data, summaries.at(qsizetype(i)), range, bucketWidth, lastBucket);
+    }
+    else if (pointsPerPixel >= subSummarySize){
+        data.reserve(pixels*2 + 4);
+        for (qint64 i = first; i < end; ++i){
+            const Chunk *c = chunk(i);
+            if (!c)
+                return;
+            for (const Summary &summary : c->subSummaries)
+                appendSummary(data, summary, range, bucketWidth, lastBucket);
+        }
+    }
+    else{
+        data.reserve(qsizetype((end - first)*trace.chunkSize()));
+        for (qint64 i = first; i < end; ++i){
+            const Chunk *c = chunk(i);
+            if (!c)
+                return;
+            const qint64 count = qMin(trace.chunkSize(), trace.pointCount() - i*trace.chunkSize());
+            for (qint64 j = 0; j < count; ++j)
+                data.append(QCPGraphData(c->keys[j], c->values[j]));
+        }
+    }
+    graph->data()->set(data, true);
+}
+
+// Returns the mapped chunk with the given index, mapping it and computing its sub-summaries if
+// necessary. Returns nullptr if mapping fails.
+TraceGraphSource::Chunk *TraceGraphSource::chunk(qint64 index)
+{
+    auto it = chunks.find(index);
+    if (it == chunks.end()){
+        const qint64 firstPoint = index*trace.chunkSize();
+        const qint64 count = qMin(trace.chunkSize(), trace.pointCount() - firstPoint);
+        const qint64 bytes = count*qint64(2*sizeof(double));
+        evict(bytes);
+
+        Chunk chunk;
+        chunk.mappedKeys = file.map(trace.keysOffset() + firstPoint*qint64(sizeof(double)), count*qint64(sizeof(double)));
+        chunk.mappedValues = file.map(trace.valuesOffset() + firstPoint*qint64(sizeof(double)), count*qint64(sizeof(double)));
+        chunk.bytes = bytes;
+        if (!chunk.mappedKeys || !chunk.mappedValues){
+            error = file.errorString();
+            unmapChunk(chunk);
+            return nullptr;
+        }
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        chunk.keys = reinterpret_cast<const double*>(chunk.mappedKeys);
+        chunk.values = reinterpret_cast<const double*>(chunk.mappedValues);
+#else
+        chunk.converted.resize(qsizetype(count*2));
+        qFromLittleEndian<double>(chunk.mappedKeys, count, chunk.converted.data());
+        qFromLittleEndian<double>(chunk.mappedValues, count, chunk.converted.data() + count);
+        chunk.keys = chunk.converted.constData();
+        chunk.values = chunk.converted.constData() + count;
+#endif
+
+        // summaries of subSummarySize points, NaNs are ignored like in the chunk index:
+        for (qint64 begin = 0; begin < count; begin += subSummarySize){
+            Summary summary = {qQNaN(), qQNaN(), qQNaN(), qQNaN()};
+            const qint64 subEnd = qMin(count, begin + subSummarySize);
+            for (qint64 i = begin; i < subEnd; ++i){
+                const double key = chunk.keys[i];
+                const double value = chunk.values[i];
+                if (std::isnan(key) || std::isnan(value))
+                    continue;
+                if (std::isnan(summary.keyMin)){
+                    summary = {key, key, value, value};
+                    continue;
+                }
+                summary.keyMin = qMin(summary.keyMin, key);
+                summary.keyMax = qMax(summary.keyMax, key);
+                summary.valueMin = qMin(summary.valueMin, value);
+                summary.valueMax = qMax(summary.valueMax, value);
+            }
+            chunk.subSummaries.append(summary);
+        }
+        mappedBytes += bytes;
+        it = chunks.insert(index, chunk);
+    }
+    it->lastUse = ++useCounter;
+    return &it.value();
+}
+
+// Unmaps least recently used chunks until bytesNeeded more bytes fit into the memory limit.
+void TraceGraphSource::evict(qint64 bytesNeeded)
+{
+    while (!chunks.isEmpty() && mappedBytes + bytesNeeded > limit){
+        auto oldest = chunks.begin();
+        for (auto it = chunks.begin(); it != chunks.end(); ++it){
+            if (it->lastUse < oldest->lastUse)
+                oldest = it;
+        }
+        mappedBytes -= oldest->bytes;
+        unmapChunk(oldest.value());
+        chunks.erase(oldest);
+    }
+}
+
+void TraceGraphSource::unmapChunk(Chunk &chunk)
+{
+    if (chunk.mappedKeys)
+        file.unmap(chunk.mappedKeys);
+    if (chunk.mappedValues)
+        file.unmap(chunk.mappedValues);
+    chunk.mappedKeys = nullptr;
+    chunk.mappedValues = nullptr;
+}
+
+// Adds summary as a minimum and maximum point at the center of its pixel, or widens those points
+// if the previous summary fell into the same pixel.
+void TraceGraphSource::appendSummary(QVector<QCPGraphData> &data, const Summary &summary, const QCPRange &range, double bucketWidth, qint64 &lastBucket) const
+{
+    if (std::isnan(summary.keyMin))
+        return;
+    const double keyCenter = (summary.keyMin + summary.keyMax)*0.5;
+    const qint64 bucket = qint64(qBound(-1e15, std::floor((keyCenter - range.lower)/bucketWidth), 1e15));
+    if (bucket == lastBucket && data.size() >= 2){
+        QCPGraphData &minPoint = data[data.size() - 2];
+        QCPGraphData &maxPoint = data[data.size() - 1];
+        minPoint.value = qMin(minPoint.value, summary.valueMin);
+        maxPoint.value = qMax(maxPoint.value, summary.valueMax);
+        return;
+    }
+    const double bucketKey = range.lower + (double(bucket) + 0.5)*bucketWidth;
+    data.append(QCPGraphData(bucketKey, summary.valueMin));
+    data.append(QCPGraphData(bucketKey, summary.valueMax));
+    lastBucket = bucket;
+}
@@ -0,0 +1,82 @@
+#ifndef TRACEGRAPHSOURCE_H
+#define TRACEGRAPHSOURCE_H
+
+#include <QFile>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include "qcustomplot.h"
+#include "tracefile.h"
+
+// Displays a trace file in a graph without loading it into memory.
+//
+// Only the chunk index of the trace is resident. Whenever the key axis range changes, the graph
+// data is replaced by what the current viewport needs, choosing the coarsest sufficient level:
+//   - the resident chunk summaries, if a pixel covers at least a whole chunk,
+//   - summaries of 1024 points each (computed once per chunk while it is mapped), if a pixel
+//     covers at least that many points,
+//   - otherwise the raw points of the visible chunks.
+// Chunks are mapped from the file on demand, and the least recently used ones are unmapped when
+// the mapped chunks exceed the memory limit. Summaries are shown as the minimum and maximum value
+// per pixel, like the adaptive sampling of QCPGraph. The trace must be sorted by key.
+//
+// The source deletes itself when its graph is deleted.
+class TraceGraphSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    TraceGraphSource(QCPGraph *graph, const QString &filePath, QObject *parent = nullptr);
+    ~TraceGraphSource();
+
+    bool open();
+    void setMemoryLimit(qint64 bytes);
+
+    QString errorString() const { return error; }
+    qint64 pointCount() const { return trace.pointCount(); }
+    qint64 memoryLimit() const { return limit; }
+    qint64 residentBytes() const { return mappedBytes; }
+    QCPRange keyRange() const;
+    QCPRange valueRange() const;
+
+public slots:
+    void update();
+
+private:
+    struct Summary
+    {
+        double keyMin;
+        double keyMax;
+        double valueMin;
+        double valueMax;
+    };
+    struct Chunk
+    {
+        const double *keys;
+        const double *values;
+        uchar *mappedKeys;
+        uchar *mappedValues;
+        QVector<double> converted; // keys and values in host byte order on big-endian machines
+        QVector<Summary> subSummaries;
+        quint64 lastUse;
+        qint64 bytes;
+    };
+
+    QPointer<QCPGraph> graph;
+    TraceFile trace;
+    QFile file;
+    QVector<Summary> summaries;
+    QHash<qint64, Chunk> chunks;
+    quint64 useCounter;
+    qint64 limit;
+    qint64 mappedBytes;
+    QString error;
+
+    Chunk *chunk(qint64 index);
+    void evict(qint64 bytesNeeded);
+    void unmapChunk(Chunk &chunk);
+    void appendSummary(QVector<QCPGraphData> &data, const Summary &summary, const QCPRange &range, double bucketWidth, qint64 &lastBucket) const;
+};
+
+#endif // TRACEGRAPHSOURCE_H